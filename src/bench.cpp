@@ -0,0 +1,81 @@
+#include "model/numa.h"
+#include "model/HybridModel.h"
+#include "model/Backtest.h"
+#include "framework/DataFramework.h"
+#include "framework/FeatureStore.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Benchmarks on synthetic data, so they run anywhere: NUMA placement bandwidth, FeatureStore against FeatureCache,
+ * streamed against windowed backtesting, and timestamp parsing. Files are written to the working directory and
+ * removed afterwards.
+ */
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    constexpr int TIMESTEPS = 30;
+
+    //Minute bars in the parseData CSV format
+    std::string csv_text(const size_t rows) {
+        std::string text = "Date,Open,High,Low,Close,Volume\n";
+        char line[128];
+        for (size_t k = 0; k < rows; k++) {
+            const size_t day = k / 390, minute = k % 390;
+            const double close = 100 + 10 * std::sin(0.01 * k);
+            std::snprintf(line, sizeof(line), "%04zu-%02zu-%02zu %02zu:%02zu:00,%.4f,%.4f,%.4f,%.4f,%zu\n",
+                          2000 + day / 336, (day / 28) % 12 + 1, day % 28 + 1, 9 + (30 + minute) / 60, (30 + minute) % 60,
+                          close - 0.1, close + 0.5, close - 0.5, close, 1000 + k % 97);
+            text += line;
+        }
+        return text;
+    }
+}
+
+int main() {
+    const numa::Bandwidth bandwidth = numa::benchmark();
+    std::cout << "NUMA read bandwidth (" << bandwidth.nodes << " node(s)): local " << bandwidth.local
+              << " GB/s, interleaved " << bandwidth.interleaved << " GB/s, remote " << bandwidth.remote << " GB/s\n";
+
+    //Slowly varying features compress the way market data does
+    const size_t rows = 1 << 18;
+    std::vector<int64_t> timestamps(rows);
+    Matrix X(rows), Y(rows);
+    for (size_t k = 0; k < rows; k++) {
+        timestamps[k] = 946684800 + 60 * static_cast<int64_t>(k);
+        X[k] = {100 + std::round(1000 * std::sin(1e-3 * k)) / 100, std::round(std::cos(3e-4 * k) * 1e4) / 1e4, static_cast<double>(1000 + k % 97)};
+        Y[k] = {X[k][0]};
+    }
+    const FeatureStore::Benchmark store = FeatureStore::benchmark(timestamps, X, Y, ".");
+    std::cout << "FeatureStore: " << store.rows << " rows, " << store.raw_bytes << " -> " << store.compressed_bytes
+              << " bytes (" << store.ratio << "x), write " << store.compress_seconds << " s, raw load "
+              << store.raw_load_gbps << " GB/s, decode " << store.decode_gbps << " GB/s\n";
+
+    Matrix series(4000);
+    for (size_t k = 0; k < series.size(); k++) {
+        series[k] = {std::sin(0.05 * k), std::cos(0.03 * k), std::sin(0.011 * k)};
+    }
+    const auto windows = DataFramework::generate_tensor(series, TIMESTEPS);
+    HybridModel model;
+    model.init_data(windows, Matrix(windows.size(), std::vector<double>(1, 0.0)), 64);
+    model.init_hidden_units(32);
+    model.init_layers({"LSTM", "Relu", "Linear"}, {32, 16, 1});
+    model.initialize_network();
+    Backtest::Config config;
+    config.reset_every = TIMESTEPS;
+    const Backtest::Comparison backtest = Backtest::compare(model, series, TIMESTEPS, config);
+    std::cout << "Backtest: " << backtest.windows << " windows, stream " << backtest.stream_seconds << " s, windowed "
+              << backtest.windowed_seconds << " s (" << backtest.speedup << "x), period-end drift "
+              << backtest.max_period_end_drift << "\n";
+
+    const DataFramework::TimestampBenchmark parsing = DataFramework::benchmarkTimestamps(csv_text(200000));
+    std::cout << "Timestamps: " << parsing.rows << " rows, mktime " << parsing.mktime_rows_per_second
+              << " rows/s, civil " << parsing.civil_rows_per_second << " rows/s (" << parsing.speedup << "x)\n";
+
+    return 0;
+}
@@ -0,0 +1,540 @@
+#include "AsyncLoader.h"
+#include "DataFramework.h"
+#include "../model/parallel.h"
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AsyncLoader {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        typedef std::chrono::steady_clock Clock;
+
+        struct Shared;
+
+        //Read of one whole file, owned by the coroutine awaiting it
+        struct Request {
+            Shared* shared = nullptr;
+            std::coroutine_handle<> handle;
+            std::string path;
+            std::string contents;
+            std::exception_ptr error;
+            int fd = -1;       //io_uring backend
+            size_t offset = 0; //io_uring backend, bytes read so far
+        };
+
+        //State shared by the lanes, the read backend and the compute threads
+        struct Shared {
+            std::vector<File> files;
+            Process process;
+            std::function<void(Request*)> submit;
+            std::atomic<size_t> next{0};
+
+            //Coroutines whose read has completed, resumed by the compute threads
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::deque<std::coroutine_handle<>> ready;
+            size_t lanes_running = 0;
+
+            std::mutex io_mutex;
+            size_t reads_in_flight = 0;
+            Clock::time_point busy_since;
+            double read_seconds = 0.0;
+            size_t bytes = 0;
+
+            void read_started() {
+                std::lock_guard<std::mutex> lock(io_mutex);
+                if (reads_in_flight++ == 0) {
+                    busy_since = Clock::now();
+                }
+            }
+
+            void read_finished(const size_t n) {
+                std::lock_guard<std::mutex> lock(io_mutex);
+                bytes += n;
+                if (--reads_in_flight == 0) {
+                    read_seconds += std::chrono::duration<double>(Clock::now() - busy_since).count();
+                }
+            }
+
+            void resume_later(const std::coroutine_handle<> handle) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready.push_back(handle);
+                }
+                wake.notify_one();
+            }
+
+            void lane_finished() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    lanes_running--;
+                }
+                wake.notify_all();
+            }
+
+            //Resume ready coroutines until every lane has finished
+            void drain() {
+                while (true) {
+                    std::coroutine_handle<> handle;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [this]() { return !ready.empty() || lanes_running == 0; });
+                        if (ready.empty()) {
+                            return;
+                        }
+                        handle = ready.front();
+                        ready.pop_front();
+                    }
+                    handle.resume();
+                }
+            }
+        };
+
+        //Called by a backend once a read is done; the request must not be touched afterwards
+        void complete(Request* request) {
+            Shared* shared = request->shared;
+            shared->read_finished(request->contents.size());
+            shared->resume_later(request->handle);
+        }
+
+        //Suspends the calling coroutine until the file has been read
+        struct ReadFile {
+            Shared& shared;
+            Request request;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(const std::coroutine_handle<> handle) {
+                request.shared = &shared;
+                request.handle = handle;
+                shared.read_started();
+                shared.submit(&request);
+            }
+
+            std::string await_resume() {
+                if (request.error) {
+                    std::rethrow_exception(request.error);
+                }
+                return std::move(request.contents);
+            }
+        };
+
+        //Fire-and-forget coroutine, starts eagerly and frees itself when it returns
+        struct Lane {
+            struct promise_type {
+                Lane get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+        //Takes the next file until none are left: read it, then process it on whichever compute thread resumes it
+        Lane lane(const std::shared_ptr<Shared> shared) {
+            size_t i;
+            while ((i = shared->next.fetch_add(1)) < shared->files.size()) {
+                File& file = shared->files[i];
+                try {
+                    //Named rather than a temporary, GCC 12 misplaces aggregate temporaries of a co_await
+                    Request request{};
+                    request.path = file.path;
+                    ReadFile read{*shared, std::move(request)};
+                    const std::string contents = co_await read;
+                    file.data = shared->process(file.path, contents);
+                } catch (const std::exception& e) {
+                    file.error = e.what();
+                }
+            }
+            shared->lane_finished();
+        }
+
+        void read_blocking(Request* request) {
+            try {
+                std::ifstream file(request->path, std::ios::binary | std::ios::ate);
+                if (!file.is_open()) {
+                    throw std::runtime_error("Could not open " + request->path + " (" + std::strerror(errno) + ")");
+                }
+                request->contents.resize(static_cast<size_t>(file.tellg()));
+                file.seekg(0);
+                if (!file.read(request->contents.data(), static_cast<std::streamsize>(request->contents.size()))) {
+                    throw std::runtime_error("Failed reading " + request->path);
+                }
+            } catch (...) {
+                request->error = std::current_exception();
+            }
+        }
+
+#if defined(__linux__)
+        //Single io_uring serviced by one thread: it opens files, keeps up to `entries` reads queued in the kernel
+        //and completes requests as their reads finish. Reads longer than one submission are resubmitted
+        class Uring {
+        public:
+            explicit Uring(const unsigned entries) {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                if (ring_fd < 0) {
+                    throw std::runtime_error(std::string("io_uring unavailable (") + std::strerror(errno) + ")");
+                }
+                //IORING_OP_READ needs Linux 5.6, FAST_POLL (5.7) is the closest feature bit that implies it
+                if (!(params.features & IORING_FEAT_FAST_POLL)) {
+                    close(ring_fd);
+                    throw std::runtime_error("io_uring too old for IORING_OP_READ");
+                }
+
+                sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if (single) {
+                    sq_bytes = cq_bytes = std::max(sq_bytes, cq_bytes);
+                }
+                sqe_bytes = params.sq_entries * sizeof(io_uring_sqe);
+
+                sq_ring = mmap(nullptr, sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+                cq_ring = single ? sq_ring : mmap(nullptr, cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+                void* sqe_map = mmap(nullptr, sqe_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+                if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqe_map == MAP_FAILED) {
+                    unmap(sqe_map);
+                    throw std::runtime_error("Could not map io_uring");
+                }
+                sqes = static_cast<io_uring_sqe*>(sqe_map);
+
+                char* sq = static_cast<char*>(sq_ring);
+                sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                char* cq = static_cast<char*>(cq_ring);
+                cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                capacity = params.sq_entries;
+
+                thread = std::thread([this]() { run(); });
+            }
+
+            ~Uring() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                wake.notify_all();
+                thread.join();
+                unmap(sqes);
+            }
+
+            Uring(const Uring&) = delete;
+            Uring& operator=(const Uring&) = delete;
+
+            void submit(Request* request) {
+                std::string error;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failure.empty()) {
+                        pending.push_back(request);
+                    } else {
+                        error = failure;
+                    }
+                }
+                if (!error.empty()) { //The ring thread has stopped, nothing would read it
+                    fail(request, error + ", " + request->path + " was not read");
+                    return;
+                }
+                wake.notify_one();
+            }
+
+        private:
+            //Largest single read, the length field is 32 bits
+            static constexpr size_t MAX_READ = size_t(1) << 30;
+
+            int ring_fd = -1;
+            void* sq_ring = MAP_FAILED;
+            void* cq_ring = MAP_FAILED;
+            size_t sq_bytes = 0, cq_bytes = 0, sqe_bytes = 0;
+            io_uring_sqe* sqes = nullptr;
+            unsigned* sq_tail = nullptr;
+            unsigned* sq_array = nullptr;
+            unsigned sq_mask = 0;
+            unsigned* cq_head = nullptr;
+            unsigned* cq_tail = nullptr;
+            unsigned cq_mask = 0;
+            io_uring_cqe* cqes = nullptr;
+            size_t capacity = 0;
+
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::deque<Request*> pending;
+            bool stopping = false;
+            std::string failure; //Set when the ring stopped working, later requests fail at once
+
+            //Touched by the ring thread only
+            size_t in_flight = 0;
+            unsigned to_submit = 0;
+            std::vector<Request*> active; //Opened requests with a read queued
+
+            void unmap(void* sqe_map) {
+                if (sqe_map != MAP_FAILED && sqe_map != nullptr) {
+                    munmap(sqe_map, sqe_bytes);
+                }
+                if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+                    munmap(cq_ring, cq_bytes);
+                }
+                if (sq_ring != MAP_FAILED) {
+                    munmap(sq_ring, sq_bytes);
+                }
+                close(ring_fd);
+            }
+
+            void queue_read(Request* request) {
+                const unsigned tail = *sq_tail;
+                const unsigned index = tail & sq_mask;
+                io_uring_sqe& sqe = sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = request->fd;
+                sqe.off = request->offset;
+                sqe.addr = reinterpret_cast<uint64_t>(request->contents.data() + request->offset);
+                sqe.len = static_cast<uint32_t>(std::min(MAX_READ, request->contents.size() - request->offset));
+                sqe.user_data = reinterpret_cast<uint64_t>(request);
+                sq_array[index] = index;
+                __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+                to_submit++;
+                in_flight++;
+            }
+
+            void finish(Request* request) {
+                const auto opened = std::find(active.begin(), active.end(), request);
+                if (opened != active.end()) {
+                    active.erase(opened);
+                }
+                if (request->fd >= 0) {
+                    close(request->fd);
+                    request->fd = -1;
+                }
+                complete(request);
+            }
+
+            void fail(Request* request, const std::string& message) {
+                request->error = std::make_exception_ptr(std::runtime_error(message));
+                finish(request);
+            }
+
+            void start(Request* request) {
+                request->fd = open(request->path.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat info;
+                if (request->fd < 0 || fstat(request->fd, &info) != 0) {
+                    fail(request, "Could not open " + request->path + " (" + std::strerror(errno) + ")");
+                    return;
+                }
+                request->contents.resize(static_cast<size_t>(info.st_size));
+                if (request->contents.empty()) {
+                    finish(request);
+                    return;
+                }
+                active.push_back(request);
+                queue_read(request);
+            }
+
+            //io_uring_enter failed for good: fails every opened and pending request with message and stops taking
+            //new ones, so no coroutine waits for a read that will never complete
+            void abandon(const std::string& message) {
+                std::deque<Request*> waiting;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failure = message;
+                    waiting.swap(pending);
+                }
+                while (!active.empty()) {
+                    fail(active.back(), message);
+                }
+                for (Request* request : waiting) {
+                    fail(request, message);
+                }
+                in_flight = 0;
+                to_submit = 0;
+            }
+
+            void reap() {
+                unsigned head = *cq_head;
+                while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                    const io_uring_cqe& cqe = cqes[head & cq_mask];
+                    Request* request = reinterpret_cast<Request*>(cqe.user_data);
+                    const int res = cqe.res;
+                    head++;
+                    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+                    in_flight--;
+
+                    if (res == -EAGAIN || res == -EINTR) {
+                        queue_read(request);
+                    } else if (res < 0) {
+                        fail(request, "Failed reading " + request->path + " (" + std::strerror(-res) + ")");
+                    } else if (res == 0) {
+                        request->contents.resize(request->offset); //File shrank since fstat
+                        finish(request);
+                    } else {
+                        request->offset += static_cast<size_t>(res);
+                        if (request->offset < request->contents.size()) {
+                            queue_read(request);
+                        } else {
+                            finish(request);
+                        }
+                    }
+                }
+            }
+
+            void run() {
+                while (true) {
+                    std::deque<Request*> batch;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [this]() { return stopping || !pending.empty() || in_flight > 0; });
+                        if (stopping && pending.empty() && in_flight == 0) {
+                            return;
+                        }
+                        while (!pending.empty() && in_flight + batch.size() < capacity) {
+                            batch.push_back(pending.front());
+                            pending.pop_front();
+                        }
+                    }
+                    for (Request* request : batch) {
+                        start(request);
+                    }
+                    if (in_flight == 0) {
+                        continue;
+                    }
+
+                    //Submit what was queued and wait for at least one completion
+                    const int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                    if (submitted >= 0) {
+                        to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(submitted));
+                    } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                        //Throwing here would end the ring thread with std::terminate
+                        abandon(std::string("io_uring_enter failed (") + std::strerror(errno) + ")");
+                        return;
+                    }
+                    reap();
+                }
+            }
+        };
+#endif
+    }
+
+    double Stats::read_bandwidth() const {
+        return read_seconds > 0.0 ? static_cast<double>(bytes) / read_seconds / 1e9 : 0.0;
+    }
+
+    double Stats::throughput() const {
+        return seconds > 0.0 ? static_cast<double>(bytes) / seconds / 1e9 : 0.0;
+    }
+
+    Result load(const std::vector<std::string>& paths, const Process& process, const Config& config) {
+        const auto start = Clock::now();
+
+        auto shared = std::make_shared<Shared>();
+        shared->files.resize(paths.size());
+        for (size_t i = 0; i < paths.size(); i++) {
+            shared->files[i].path = paths[i];
+        }
+        shared->process = process;
+
+        Result result;
+#if defined(__linux__)
+        std::unique_ptr<Uring> uring;
+        if (config.backend != Backend::Threads) {
+            try {
+                uring = std::make_unique<Uring>(static_cast<unsigned>(std::max<size_t>(config.queue_depth, 1)));
+            } catch (const std::runtime_error&) {
+                if (config.backend == Backend::IoUring) {
+                    throw;
+                }
+            }
+        }
+        if (uring) {
+            result.stats.backend = Backend::IoUring;
+            shared->submit = [&uring](Request* request) { uring->submit(request); };
+        }
+#else
+        if (config.backend == Backend::IoUring) {
+            throw std::runtime_error("io_uring is only available on Linux");
+        }
+#endif
+        std::unique_ptr<parallel::ThreadPool> io;
+        if (!shared->submit) {
+            io = std::make_unique<parallel::ThreadPool>(std::max<size_t>(config.io_threads, 1));
+            shared->submit = [&io](Request* request) {
+                io->enqueue([request]() {
+                    read_blocking(request);
+                    complete(request);
+                });
+            };
+        }
+
+        const size_t in_flight = config.max_in_flight > 0 ? config.max_in_flight : 2 * parallel::num_threads();
+        const size_t lanes = std::min(in_flight, paths.size());
+        shared->lanes_running = lanes;
+
+        //Compute threads: the caller and up to lanes - 1 pool workers resume coroutines as their reads complete
+        parallel::ThreadPool& workers = parallel::pool();
+        for (size_t i = 0; i + 1 < std::min(lanes, workers.size() + 1); i++) {
+            workers.enqueue([shared]() { shared->drain(); });
+        }
+        for (size_t i = 0; i < lanes; i++) {
+            lane(shared);
+        }
+        shared->drain();
+
+        //Every lane has returned, so no read is pending and the backends can be shut down
+#if defined(__linux__)
+        uring.reset();
+#endif
+        io.reset();
+
+        result.files = std::move(shared->files);
+        {
+            std::lock_guard<std::mutex> lock(shared->io_mutex);
+            result.stats.bytes = shared->bytes;
+            result.stats.read_seconds = shared->read_seconds;
+        }
+        result.stats.files = paths.size();
+        result.stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return result;
+    }
+
+    Result parseFiles(const std::vector<std::string>& paths, const Config& config) {
+        return load(paths, [](const std::string&, const std::string& contents) {
+            return DataFramework::parseCSV(contents);
+        }, config);
+    }
+
+    Result engineerFiles(const std::vector<std::string>& paths, const Config& config) {
+        return load(paths, [](const std::string&, const std::string& contents) {
+            return DataFramework::engineerData(DataFramework::parseCSV(contents));
+        }, config);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef ASYNCLOADER_H
+#define ASYNCLOADER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+/*
+ * Asynchronous loading of multi-file datasets with C++20 coroutines.
+ *
+ * Each file is handled by a coroutine that co_awaits the read of the whole file and is then resumed on a compute
+ * thread to parse and engineer it. Up to max_in_flight coroutines run at once, so while some files are being
+ * read, others are being parsed, keeping both the disks and the cores busy. Reads go through io_uring on Linux
+ * (raw syscalls, no liburing needed) and fall back to a small pool of blocking I/O threads when io_uring is
+ * unavailable. Compute runs on the calling thread and parallel::pool().
+ */
+namespace AsyncLoader {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    enum class Backend { Auto, IoUring, Threads };
+
+    struct Config {
+        Backend backend = Backend::Auto; //Auto uses io_uring when the kernel allows it
+        size_t max_in_flight = 0;        //Files being read or processed at once, 0 = twice parallel::num_threads()
+        size_t io_threads = 4;           //Threads backend only
+        size_t queue_depth = 64;         //io_uring backend only, submission queue entries
+    };
+
+    struct File {
+        std::string path;
+        Matrix data;
+        std::string error; //Set when reading or processing failed
+    };
+
+    struct Stats {
+        Backend backend = Backend::Threads; //Backend actually used
+        size_t files = 0;
+        size_t bytes = 0;                   //Bytes read
+        double seconds = 0.0;               //Wall time of the whole load
+        double read_seconds = 0.0;          //Wall time during which at least one read was in flight
+        double read_bandwidth() const;      //GB/s while reading
+        double throughput() const;          //GB/s over the whole load, processing included
+    };
+
+    struct Result {
+        std::vector<File> files; //In the order of the paths
+        Stats stats;
+    };
+
+    //Turns the contents of a file into a matrix, runs on a compute thread
+    typedef std::function<Matrix(const std::string& path, const std::string& contents)> Process;
+
+    Result load(const std::vector<std::string>& paths, const Process& process, const Config& config = Config());
+
+    //DataFramework::parseCSV of each file, and engineerData on top of it
+    Result parseFiles(const std::vector<std::string>& paths, const Config& config = Config());
+    Result engineerFiles(const std::vector<std::string>& paths, const Config& config = Config());
+}
+
+#endif //ASYNCLOADER_H
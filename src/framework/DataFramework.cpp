@@ -1,4 +1,7 @@
 #include "DataFramework.h"
+#include "FeatureGraph.h"
+#include "../model/reductions.h"
+#include "../model/parallel.h"
 
 #include <iostream>
 #include <fstream>
@@ -7,71 +10,331 @@
 #include <ctime>
 #include <cmath>
 #include <tuple>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+#include <charconv>
+#include <iterator>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define QUANTNET_HAS_MMAP 1
+#endif
 
 namespace DataFramework {
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
 
+    namespace {
+        constexpr size_t CHUNK_BYTES = size_t(1) << 20; //Files are parsed in chunks of about this size, one task each
+
+        //Reads the number at the start of [p, end), like std::stod: leading whitespace and '+' are skipped and
+        //anything after the number is ignored
+        double parseNumber(const char* p, const char* end) {
+            while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+                p++;
+            }
+            if (p < end && *p == '+') {
+                p++;
+            }
+            double value = 0.0;
+            const std::from_chars_result parsed = std::from_chars(p, end, value);
+            if (parsed.ec == std::errc::invalid_argument) {
+                throw std::invalid_argument("Malformed number: " + std::string(p, end));
+            }
+            if (parsed.ec == std::errc::result_out_of_range) {
+                throw std::out_of_range("Number out of range: " + std::string(p, end));
+            }
+            return value;
+        }
+
+        //Appends the row of the line [p, end), without its newline
+        void parseRow(const char* p, const char* end, Matrix& data) {
+            std::vector<double> row;
+            row.reserve(data.empty() ? 8 : data.back().size()); //Rows of a file have the same columns
+
+            // Parse through the Date, straight from the line's characters
+            DateTime date;
+            if (!parseDateTime(p, end, date)) {
+                throw std::invalid_argument("Malformed date in row: " + std::string(p, end));
+            }
+            row.push_back(date.year);
+            row.push_back(date.month);
+            row.push_back(date.day + (date.hour * 3600 + date.minute * 60 + date.second) / 86400.0); //Whole at midnight
+            p = std::find(p, end, ','); //Rest of the Date field
+
+            // Parse through all other columns, a trailing comma ends the row
+            while (p < end && ++p < end) {
+                const char* field_end = std::find(p, end, ',');
+                row.push_back(parseNumber(p, field_end));
+                p = field_end;
+            }
+            data.push_back(std::move(row));
+        }
+
+        //Rows of [begin, end), heading included. The data is cut at the first newline after every CHUNK_BYTES,
+        //chunks are parsed into their own matrices in parallel and then moved into place in file order
+        Matrix parseText(const char* begin, const char* end) {
+            // Skip the heading at the top
+            const char* body = std::find(begin, end, '\n');
+            if (body == end) {
+                return Matrix();
+            }
+            body++;
+
+            std::vector<const char*> bounds = {body};
+            while (bounds.back() != end) {
+                const char* cut = bounds.back() + std::min<size_t>(CHUNK_BYTES, end - bounds.back());
+                cut = (cut == end) ? end : std::find(cut, end, '\n');
+                bounds.push_back(cut == end ? end : cut + 1);
+            }
+
+            std::vector<Matrix> chunks(bounds.size() - 1);
+            parallel::parallel_for(0, chunks.size(), 1, [&](const size_t first, const size_t last) {
+                for (size_t c = first; c < last; c++) {
+                    const char* line = bounds[c];
+                    while (line < bounds[c + 1]) {
+                        const char* line_end = std::find(line, bounds[c + 1], '\n');
+                        parseRow(line, line_end, chunks[c]);
+                        line = (line_end == bounds[c + 1]) ? line_end : line_end + 1;
+                    }
+                }
+            });
+
+            size_t rows = 0;
+            for (const Matrix& chunk : chunks) {
+                rows += chunk.size();
+            }
+            Matrix data;
+            data.reserve(rows);
+            for (Matrix& chunk : chunks) {
+                std::move(chunk.begin(), chunk.end(), std::back_inserter(data));
+            }
+            return data;
+        }
+    }
+
     Matrix parseData(const std::string& filename) {
+#ifdef QUANTNET_HAS_MMAP
+        //Parsed straight from a read-only mapping, the file is never copied
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || ::fstat(fd, &info) != 0) {
+            std::cerr << "Could not open file: " << filename
+                  << " (" << std::strerror(errno) << ")" << std::endl;
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return Matrix();
+        }
+        const size_t size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            ::close(fd);
+            return Matrix();
+        }
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); //The mapping keeps the file alive
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            const char* text = static_cast<const char*>(mapping);
+            try {
+                Matrix data = parseText(text, text + size);
+                ::munmap(mapping, size);
+                return data;
+            } catch (...) {
+                ::munmap(mapping, size);
+                throw;
+            }
+        }
+#endif
         std::ifstream file(filename);
-        Matrix data;
-        std::string line;
 
         if (!file) {
             std::cerr << "Could not open file: " << filename
                   << " (" << std::strerror(errno) << ")" << std::endl;
-            return data;
+            return Matrix();
         }
 
-        // Skip the heading at the top
-        getline(file, line);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        file.close();
+        return parseCSV(contents.str());
+    }
 
-        // Parse the numerical data
-        while (getline(file, line)) {
-            std::stringstream ss(line);
-            std::string token;
-            std::vector<double> row;
+    Matrix parseCSV(const std::string& text) {
+        return parseText(text.data(), text.data() + text.size());
+    }
 
-            // Parse through the Date
-            std::getline(ss, token, '-');
-            row.push_back(std::stod(token)); //Year
+    namespace {
+        //Reads n digits at p into value
+        bool digits(const char* p, const int n, int& value) {
+            value = 0;
+            for (int i = 0; i < n; i++) {
+                const unsigned digit = static_cast<unsigned>(p[i] - '0');
+                if (digit > 9) {
+                    return false;
+                }
+                value = value * 10 + static_cast<int>(digit);
+            }
+            return true;
+        }
 
-            std::getline(ss, token, '-');
-            row.push_back(std::stod(token)); //Month
+        //The time-feature stage before days_from_civil, the baseline of benchmarkTimestamps
+        time_t mktimeTimestamp(const double year, const double month, const double day) {
+            struct std::tm time = {};
+            time.tm_year = year - 1900;
+            time.tm_mon = month - 1;
+            time.tm_mday = day;
+            return mktime(&time);
+        }
+    }
 
-            std::getline(ss, token, ',');
-            row.push_back(std::stod(token)); //Day
+    bool parseDateTime(const char*& cursor, const char* end, DateTime& date) {
+        //Fixed-width fields, so the parser only checks digits and separators
+        const char* p = cursor;
+        DateTime parsed;
+        if (end - p < 10 || p[4] != '-' || p[7] != '-' ||
+            !digits(p, 4, parsed.year) || !digits(p + 5, 2, parsed.month) || !digits(p + 8, 2, parsed.day) ||
+            parsed.month < 1 || parsed.month > 12 || parsed.day < 1 || parsed.day > 31) {
+            return false;
+        }
+        p += 10;
 
-            // Parse through all other columns
-            while (getline(ss, token, ',')) {
-                row.push_back(std::stod(token));
+        //Optional time of day, otherwise midnight
+        if (end - p >= 9 && (p[0] == ' ' || p[0] == 'T') && p[3] == ':' && p[6] == ':' &&
+            digits(p + 1, 2, parsed.hour) && digits(p + 4, 2, parsed.minute) && digits(p + 7, 2, parsed.second)) {
+            if (parsed.hour > 23 || parsed.minute > 59 || parsed.second > 60) {
+                return false;
             }
-
-            data.push_back(row);
+            p += 9;
+        } else {
+            parsed.hour = parsed.minute = parsed.second = 0;
         }
-        file.close();
-        return data;
+
+        date = parsed;
+        cursor = p;
+        return true;
+    }
+
+    int64_t days_from_civil(int64_t year, const int month, const int day) {
+        //Counts from 0000-03-01 in 400-year eras of 146097 days, so the leap day is the last day of its year
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const int64_t year_of_era = year - era * 400;                                      //[0, 399]
+        const int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; //[0, 365]
+        const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return era * 146097 + day_of_era - 719468; //719468 days from 0000-03-01 to 1970-01-01
     }
 
     //Function to convert a Date to a UnixTimestamp
-    time_t UnixTimestamp(const double year, const double month, const double day) {
-        struct std::tm time = {};
-        time.tm_year = year - 1900;
-        time.tm_mon = month - 1;
-        time.tm_mday = day;
-        time.tm_hour = 0;
-        time.tm_min = 0;
-        time.tm_sec = 0;
-
-        return mktime(&time);
+    time_t UnixTimestamp(const double year, const double month, const double day, const double hour, const double minute, const double second) {
+        //A fractional day is parseData's time of day, rounded back to whole seconds
+        const double whole_day = std::floor(day);
+        const int64_t day_seconds = std::llround((day - whole_day) * 86400);
+        const int64_t days = days_from_civil(static_cast<int64_t>(year), static_cast<int>(month), static_cast<int>(whole_day));
+        return static_cast<time_t>(days * 86400 + day_seconds + static_cast<int64_t>(hour) * 3600 + static_cast<int64_t>(minute) * 60 + static_cast<int64_t>(second));
+    }
+
+    TimestampBenchmark benchmarkTimestamps(const std::string& text, const int repeats) {
+        //Lines are split once up front, only the per-row date work is timed
+        std::vector<std::pair<size_t, size_t>> lines;
+        size_t begin = text.find('\n');
+        while (begin != std::string::npos && begin + 1 < text.size()) {
+            begin++;
+            const size_t end = std::min(text.find('\n', begin), text.size());
+            if (end > begin) {
+                lines.emplace_back(begin, end - begin);
+            }
+            begin = (end < text.size()) ? end : std::string::npos;
+        }
+
+        TimestampBenchmark benchmark;
+        benchmark.rows = lines.size();
+        if (lines.empty()) {
+            return benchmark;
+        }
+        volatile double sink = 0.0; //Keeps the timestamps from being optimized away
+
+        auto best_rate = [&](const std::function<double(size_t)>& timestamp) {
+            double best = 0.0;
+            for (int r = 0; r < std::max(repeats, 1); r++) {
+                const auto start = std::chrono::steady_clock::now();
+                double sum = 0.0;
+                for (size_t i = 0; i < lines.size(); i++) {
+                    sum += timestamp(i);
+                }
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                sink = sink + sum;
+                best = std::max(best, lines.size() / std::max(seconds, 1e-9));
+            }
+            return best;
+        };
+
+        benchmark.mktime_rows_per_second = best_rate([&](const size_t i) {
+            std::stringstream ss(text.substr(lines[i].first, lines[i].second));
+            std::string token;
+            std::getline(ss, token, '-');
+            const double year = std::stod(token);
+            std::getline(ss, token, '-');
+            const double month = std::stod(token);
+            std::getline(ss, token, ',');
+            const double day = std::stod(token);
+            return static_cast<double>(mktimeTimestamp(year, month, day) - mktimeTimestamp(1970, 1, 1));
+        });
+        benchmark.civil_rows_per_second = best_rate([&](const size_t i) {
+            const char* cursor = text.data() + lines[i].first;
+            DateTime date;
+            if (!parseDateTime(cursor, cursor + lines[i].second, date)) {
+                throw std::invalid_argument("Malformed date in row " + std::to_string(i + 1));
+            }
+            return static_cast<double>(UnixTimestamp(date.year, date.month, date.day, date.hour, date.minute, date.second));
+        });
+        benchmark.speedup = benchmark.civil_rows_per_second / benchmark.mktime_rows_per_second;
+        return benchmark;
     }
 
     Matrix engineerData(const Matrix& data) {
-        Matrix result(data.size(), std::vector<double>(16, 0.0)); // m x 16 features
-        double EMA_12_day = 0.0;
-        double EMA_26_day = 0.0;
+        IndicatorState state;
+        return engineerData(data, state);
+    }
 
-        for (int row = 0; row < data.size(); row++) {
+    Matrix engineerData(const Matrix& data, const std::vector<std::string>& features) {
+        //The full set is faster through the single-pass loop, the graph only computes what the named features need
+        return FeatureGraph::engineer(data, features);
+    }
+
+    Matrix engineerData(const Matrix& data, IndicatorState& state) {
+        Matrix result(data.size(), std::vector<double>(16, 0.0)); // m x 16 features
+        if (data.empty()) {
+            return result;
+        }
+        if (state.rows == 0) {
+            state.first_close = data[0][6];
+        }
+        double EMA_12_day = state.EMA_12_day;
+        double EMA_26_day = state.EMA_26_day;
+
+        //Rows are addressed by their index in the whole series: earlier rows come from the saved history
+        const int first_row = static_cast<int>(state.rows);
+        const int history_begin = first_row - static_cast<int>(state.history.size());
+        auto raw = [&](const int index) -> const std::vector<double>& {
+            return (index >= first_row) ? data[index - first_row] : state.history[index - history_begin];
+        };
+        //Features of the previous row, which may have been engineered by an earlier call
+        auto previous = [&](const int row) -> const std::vector<double>& {
+            return (row > first_row) ? result[row - 1 - first_row] : state.last_features;
+        };
+
+        for (int row = first_row; row < first_row + static_cast<int>(data.size()); row++) {
             /*
             * NOTE:
             * Row:
@@ -85,19 +348,21 @@ namespace DataFramework {
             *   0.     1.       2.       3.           4.         5.          6.         7.         8.           9.           10.       11.        12.       13    14.  15
             *  Year, Month, Daily Var, Timestamp, 7-Day SMA, 7-Day STD, High-Close, Low-Open, Cumul Return, 14-Day EMA, Close Change, MACD, Stochastic Osc, ATR, ADX, DMI
             */
+            const std::vector<double>& bar = raw(row);
+            std::vector<double>& features = result[row - first_row];
 
             //Construct features:
-            double year = data[row][0];
-            double month = data[row][1];
-            double day = data[row][2]; //NOTE: Not used in result
-            double daily_variation = data[row][4] - data[row][5]; //high - low
-            double timestamp = static_cast<double>(UnixTimestamp(year, month, day) - UnixTimestamp(1970, 1, 1));
+            double year = bar[0];
+            double month = bar[1];
+            double day = bar[2]; //NOTE: Not used in result, only through the timestamp (with its time of day)
+            double daily_variation = bar[4] - bar[5]; //high - low
+            double timestamp = static_cast<double>(UnixTimestamp(year, month, day));
 
             // Populate time features to result
-            result[row][0] = year;
-            result[row][1] = month;
-            result[row][2] = daily_variation;
-            result[row][3] = timestamp;
+            features[0] = year;
+            features[1] = month;
+            features[2] = daily_variation;
+            features[3] = timestamp;
 
             //Unused:
                 // double index_hash
@@ -106,40 +371,36 @@ namespace DataFramework {
             double seven_day_SMA = 0.0; //Simple moving avg of Close column -- short-term trend of the index
             double seven_day_STD = 0.0; //Standard deviation of the Close column -- short-term variability of the index
 
-            int availableDays = std::min(7, static_cast<int>(data.size()) - row);
+            //Trailing window ending at the current row, so a row never depends on the bars after it
+            const int availableDays = 7;
             if (row > 7) {
-                //Adding back with SMA
                 for (int back = row; back > row - availableDays; back--) {
-                    seven_day_SMA += data[back][6];
+                    seven_day_SMA += raw(back)[6];
                 }
                 //Compute avg
                 seven_day_SMA /= availableDays;
 
                 //Standard deviation of the 7-day timeframe
                 for (int back = row; back > row - availableDays; back--) {
-                    seven_day_STD += std::pow(data[back][6] - seven_day_SMA, 2);
+                    seven_day_STD += std::pow(raw(back)[6] - seven_day_SMA, 2);
                 }
 
                 seven_day_STD = std::sqrt(seven_day_STD / availableDays);
-
-                //Populating result with SMA & STD
-                for (int back = row; back > row - availableDays; back--) {
-                    result[back][4] = seven_day_SMA;
-                    result[back][5] = seven_day_STD;
-                }
             }
+            features[4] = seven_day_SMA;
+            features[5] = seven_day_STD;
 
             //Represents downward pressure on the index
-            double high_close_difference = data[row][4] - data[row][6];
-            result[row][6] = high_close_difference;
+            double high_close_difference = bar[4] - bar[6];
+            features[6] = high_close_difference;
 
             //Represents the upward pressure on the index
-            double low_open_difference = data[row][5] - data[row][3];
-            result[row][7] = low_open_difference;
+            double low_open_difference = bar[5] - bar[3];
+            features[7] = low_open_difference;
 
             //Cumulative percentage change in the Close column from the first observation in the training set
-            double cumulative_return = (data[row][6] - data[0][6]) / data[0][6];
-            result[row][8] = cumulative_return;
+            double cumulative_return = (bar[6] - state.first_close) / state.first_close;
+            features[8] = cumulative_return;
 
             //EMA: exponential moving average of Close -- smoother and more responsive version of SMA
             double EMA_14_day = 0.0;
@@ -147,17 +408,17 @@ namespace DataFramework {
             if (row < 14) {
                 //Initialize first 13 EMAs as SMAs
                 for (int i = 0; i < row; i++) {
-                    EMA_14_day += data[row][6];
+                    EMA_14_day += bar[6];
                 }
                 EMA_14_day /= row;
             } else {
-                EMA_14_day = (data[row][6] * SMOOTHING_FACTOR + result[row-1][9] * (1-SMOOTHING_FACTOR));
+                EMA_14_day = (bar[6] * SMOOTHING_FACTOR + previous(row)[9] * (1-SMOOTHING_FACTOR));
             }
-            result[row][9] = EMA_14_day;
+            features[9] = EMA_14_day;
 
             // Close Change -- Difference between current close and previous day's close (similar to daily return)
-            double close_change = (row > 0) ? data[row][6] - data[row-1][6] : 0.0;
-            result[row][10] = close_change;
+            double close_change = (row > 0) ? bar[6] - raw(row-1)[6] : 0.0;
+            features[10] = close_change;
 
             // MACD -- Moving Average Convergence Divergence
             // - 12-Day EMA and 26-day EMA of Close % Change
@@ -166,50 +427,50 @@ namespace DataFramework {
             if (row < 12) { //Handle days < 12 case
                 //Initialize first 13 EMAs as SMAs
                 for (int i = 0; i < row; i++) {
-                    EMA_12_day += data[row][6];
+                    EMA_12_day += bar[6];
                 }
                 EMA_12_day /= row;
-                result[row][11] = EMA_12_day;
+                features[11] = EMA_12_day;
             } else if (row < 26) { //Handle 12 < days < 26 case
                 //Calculate the 12-day EMA
-                EMA_12_day = (data[row][6] * SMOOTHING_FACTOR_12 + result[row-1][11] * (1-SMOOTHING_FACTOR_12));
+                EMA_12_day = (bar[6] * SMOOTHING_FACTOR_12 + previous(row)[11] * (1-SMOOTHING_FACTOR_12));
                 // Initialize 26-day EMA as an SMA
                 for (int i = 0; i < row; i++) {
-                    EMA_26_day += data[row][6];
+                    EMA_26_day += bar[6];
                 }
                 EMA_26_day /= row;
-                result[row][11] = EMA_26_day - EMA_12_day;
+                features[11] = EMA_26_day - EMA_12_day;
             } else {
                 //Calculate both EMAs properly
-                EMA_26_day = (data[row][6] * SMOOTHING_FACTOR_26 + EMA_26_day * (1-SMOOTHING_FACTOR_26));
-                EMA_12_day = (data[row][6] * SMOOTHING_FACTOR_12 + EMA_12_day * (1-SMOOTHING_FACTOR_12));
-                result[row][11] = EMA_26_day - EMA_12_day;
+                EMA_26_day = (bar[6] * SMOOTHING_FACTOR_26 + EMA_26_day * (1-SMOOTHING_FACTOR_26));
+                EMA_12_day = (bar[6] * SMOOTHING_FACTOR_12 + EMA_12_day * (1-SMOOTHING_FACTOR_12));
+                features[11] = EMA_26_day - EMA_12_day;
             }
 
             // Stochastic Oscillator over 14 days -- compares the Close with the High and Low columns over a 14-day window
             // Measures the position of the index relative to its recent range
             double stochastic_oscillator = 0.0;
             if (row < 14) {
-                stochastic_oscillator = data[row][6]; //No current oscillation -- set as just the current close price
+                stochastic_oscillator = bar[6]; //No current oscillation -- set as just the current close price
             } else {
                 //Find the lowest and highest traded price of the previous 14 trading sessions -- i.e. max(High), min(Low)
-                double lowest = data[row][5];
-                double highest = data[row][4];
+                double lowest = bar[5];
+                double highest = bar[4];
                 for (int i = row; i > row - 14; i--) {
                     //Check for lowest
-                    if (data[i][5] < lowest) {
-                        lowest = data[i][5];
+                    if (raw(i)[5] < lowest) {
+                        lowest = raw(i)[5];
                     }
                     //Check for highest
-                    if (data[i][4] > highest) {
-                        highest = data[i][4];
+                    if (raw(i)[4] > highest) {
+                        highest = raw(i)[4];
                     }
                 }
 
                 //Calculate the stochastic oscillator
-                stochastic_oscillator = (data[row][6] - lowest) / (highest - lowest);
+                stochastic_oscillator = (bar[6] - lowest) / (highest - lowest);
             }
-            result[row][12] = stochastic_oscillator;
+            features[12] = stochastic_oscillator;
 
             //Average true range (ATR) over 14 days -- Volatility indicator
             double ATR = 0.0;
@@ -217,15 +478,15 @@ namespace DataFramework {
                 ATR = 0.0;
             } else if (row < 14) {
                 for (int i = row; i > 0 && i > row - 14; i--) {
-                    double true_range = std::max({data[i][4] - data[i][5], data[i][4] - data[i-1][6], data[i][5] - data[i-1][6]});
+                    double true_range = std::max({raw(i)[4] - raw(i)[5], raw(i)[4] - raw(i-1)[6], raw(i)[5] - raw(i-1)[6]});
                     ATR += true_range;
                 }
                 ATR /= row;
             } else {
-                ATR = (result[row-1][13] + std::max({data[row][4] - data[row][5], data[row][4] - data[row-1][6], data[row][5] - data[row-1][6]})) / 14;
+                ATR = (previous(row)[13] + std::max({bar[4] - bar[5], bar[4] - raw(row-1)[6], bar[5] - raw(row-1)[6]})) / 14;
             }
 
-            result[row][13] = ATR;
+            features[13] = ATR;
 
             //Average directional index (ADX)
             double ADX = 0.0;
@@ -234,24 +495,35 @@ namespace DataFramework {
             if (row > 14) {
 
                 for (int i = row; i > row - 14; i--) {
-                    plus_DM += data[i][4] - data[i-1][4];
-                    neg_DM += data[i-1][5] - data[i][5];
+                    plus_DM += raw(i)[4] - raw(i-1)[4];
+                    neg_DM += raw(i-1)[5] - raw(i)[5];
                 }
-                plus_DM = plus_DM - (plus_DM / 14) + (data[row][4] - data[row-1][4]);
-                plus_DM /= result[row][13]; // Divide by ATR
+                plus_DM = plus_DM - (plus_DM / 14) + (bar[4] - raw(row-1)[4]);
+                plus_DM /= features[13]; // Divide by ATR
 
-                neg_DM = neg_DM - (neg_DM / 14) + (data[row-1][5] - data[row][5]);
-                neg_DM /= result[row][13]; // Divide by ATR
+                neg_DM = neg_DM - (neg_DM / 14) + (raw(row-1)[5] - bar[5]);
+                neg_DM /= features[13]; // Divide by ATR
 
                 ADX = plus_DM - neg_DM; //ADX = difference of the two indicators
             }
-            result[row][14] = ADX;
+            features[14] = ADX;
 
             // DMI/DX -- directional movement index: measures the positive and negative movements of the index
             double DMI = (plus_DM - neg_DM) / (plus_DM + neg_DM); //NOTE: DM here represent the DI (directional index)
-            result[row][15] = DMI;
+            features[15] = DMI;
         }
 
+        //Carry the running values and the last bars over to the next call
+        state.rows += data.size();
+        state.EMA_12_day = EMA_12_day;
+        state.EMA_26_day = EMA_26_day;
+        state.last_features = result.back();
+        Matrix history;
+        for (int row = std::max(history_begin, first_row + static_cast<int>(data.size()) - IndicatorState::HISTORY); row < static_cast<int>(state.rows); row++) {
+            history.push_back(raw(row));
+        }
+        state.history = std::move(history);
+
         return result;
     }
 
@@ -259,28 +531,18 @@ namespace DataFramework {
     Matrix standardizeData(const Matrix& data) {
         Matrix result(data.size(), std::vector<double>(data[0].size(), 0.0));
 
-        //Standardize the features across the columns
-        for (int col = 0; col < data[0].size(); col++) {
-            double stdev = 0.0;
-            double mean = 0.0;
-            // Calculate the mean across the column
-            for (int row = 0; row < data.size(); row++) {
-                mean += data[row][col];
-            }
-            mean /= data.size();;
+        //Column means and (population) standard deviations, reduced row by row with pairwise summation
+        const Matrix mean = reductions::mean(data, 0);
+        const Matrix variance = reductions::variance(data, 0);
 
-            // Calculate the standard deviation across the column
-            for (int row = 0; row < data.size(); row++) {
-                stdev += std::pow(data[row][col] - mean, 2);
-            }
-            stdev = std::pow(stdev/data.size(), 0.5);
-
-            //Z-Score Standardize:
-            for (int row = 0; row < data.size(); row++) {
+        //Z-Score Standardize:
+        for (int row = 0; row < data.size(); row++) {
+            for (int col = 0; col < data[0].size(); col++) {
+                const double stdev = std::sqrt(variance[0][col]);
                 if (stdev == 0) {
                     result[row][col] = 0.0; //Edge case: stdev in denominator = 0
                 } else {
-                    result[row][col] = (data[row][col] - mean) / stdev;
+                    result[row][col] = (data[row][col] - mean[0][col]) / stdev;
                 }
             }
         }
@@ -292,24 +554,17 @@ namespace DataFramework {
     Matrix normalizeData(const Matrix& data) {
         Matrix result(data.size(), std::vector<double>(data[0].size(), 0.0));
 
-        //Normalize the features across the columns
-        for (int col = 0; col < data[0].size(); col++) {
-            //Default values
-            double min = data[0][col];
-            double max = data[0][col];
+        //Find the min and max values of every column
+        const Matrix min = reductions::min(data, 0);
+        const Matrix max = reductions::max(data, 0);
 
-            //Find the min and max values in the current column
-            for (int row = 0; row < data.size(); row++) {
-                min = std::min(min, data[row][col]);
-                max = std::max(max, data[row][col]);
-            }
-
-            //Apply min-max normalization 
-            for (int row = 0; row < data.size(); row++) {
-                if (max - min == 0) {
+        //Apply min-max normalization
+        for (int row = 0; row < data.size(); row++) {
+            for (int col = 0; col < data[0].size(); col++) {
+                if (max[0][col] - min[0][col] == 0) {
                     result[row][col] = 0.5; //Edge case: max = min
                 } else {
-                    result[row][col] = (data[row][col] - min) / (max - min);
+                    result[row][col] = (data[row][col] - min[0][col]) / (max[0][col] - min[0][col]);
                 }
             }
         }
@@ -331,20 +586,39 @@ namespace DataFramework {
         return result;
     }
 
-    std::tuple<Tensor3D, Matrix> preprocessDataFromFile(const std::string& filename) {
+    namespace {
+        //Scaled features and the scaled Close column of the raw rows as targets
+        std::tuple<Matrix, Matrix> scaleFeatures(const Matrix& features, Matrix originalData) {
+            Matrix x_matrix = normalizeData(standardizeData(features));
+
+            originalData = normalizeData(standardizeData(originalData));
+            Matrix y_train(originalData.size(), std::vector<double>(1, 0.0));
+            for (int i = 0; i < originalData.size(); i++) {
+                y_train[i][0] = originalData[i][6]; //Close column
+            }
+
+            return std::make_tuple(x_matrix, y_train);
+        }
+    }
+
+    std::tuple<Matrix, Matrix> preprocessFeaturesFromFile(const std::string& filename) {
         Matrix originalData = parseData(filename);
-        const int TIMESTEPS = 30;
+        const Matrix features_matrix = engineerData(originalData);
+        return scaleFeatures(features_matrix, std::move(originalData));
+    }
+
+    std::tuple<Matrix, Matrix> preprocessFeaturesFromFile(const std::string& filename, const std::vector<std::string>& features) {
+        Matrix originalData = parseData(filename);
+        const Matrix features_matrix = engineerData(originalData, features);
+        return scaleFeatures(features_matrix, std::move(originalData));
+    }
 
-        Matrix x_matrix = normalizeData(standardizeData(engineerData(originalData)));
+    std::tuple<Tensor3D, Matrix> preprocessDataFromFile(const std::string& filename) {
+        const int TIMESTEPS = 30;
+        auto [x_matrix, y_train] = preprocessFeaturesFromFile(filename);
 
         Tensor3D x_train = generate_tensor(x_matrix, TIMESTEPS);
 
-        originalData = normalizeData(standardizeData(originalData));
-        Matrix y_train(originalData.size(), std::vector<double>(1, 0.0));
-        for (int i = 0; i < originalData.size(); i++) {
-            y_train[i][0] = originalData[i][6]; //Close column
-        }
-
         return std::make_tuple(x_train, y_train);
     }
 
@@ -8,18 +8,63 @@
 #include <random>
 #include <ctime>
 #include <tuple>
+#include <cstdint>
 
 namespace DataFramework {
     // Type definitions
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
 
+    //Everything engineerData needs from earlier rows, so a series can be engineered in pieces
+    struct IndicatorState {
+        static constexpr int HISTORY = 15; //Longest lookback of the indicators (ADX) plus the current row
+
+        size_t rows = 0;                   //Rows engineered so far
+        double first_close = 0.0;          //Close of the first row, base of the cumulative return
+        double EMA_12_day = 0.0;
+        double EMA_26_day = 0.0;
+        Matrix history;                    //Last HISTORY raw rows
+        std::vector<double> last_features; //Engineered features of the last row
+    };
+
+    //Date column of a row, YYYY-MM-DD with an optional HH:MM:SS time of day
+    struct DateTime {
+        int year = 1970, month = 1, day = 1;
+        int hour = 0, minute = 0, second = 0;
+    };
+
+    //Time-feature stage (date parsing and timestamps) of parseCSV + engineerData, in rows per second
+    struct TimestampBenchmark {
+        size_t rows = 0;
+        double mktime_rows_per_second = 0.0; //Previous stage: stringstream fields, stod and two mktime calls per row
+        double civil_rows_per_second = 0.0;  //parseDateTime and days_from_civil
+        double speedup = 0.0;
+    };
+
     // Function declarations
+    //Rows of Year, Month, Day, Open, High, Low, Close, Volume. An intraday bar's time of day is the fraction of its
+    //Day column (13:30 on the 5th is 5.5625), so rows order by date and time and daily bars keep whole days
     Matrix parseData(const std::string& filename);
-    time_t UnixTimestamp(const double year, const double month, const double day);
+    Matrix parseCSV(const std::string& text); //Contents of a file in the parseData format, heading included
+    //Reads YYYY-MM-DD[ HH:MM:SS] (or a 'T' before the time) at cursor and advances cursor past it. Returns false,
+    //leaving cursor alone, if there is no valid date there
+    bool parseDateTime(const char*& cursor, const char* end, DateTime& date);
+    //Days from 1970-01-01 to a proleptic Gregorian date, in integer arithmetic with no timezone, locale or lock
+    int64_t days_from_civil(int64_t year, const int month, const int day);
+    //Seconds since 1970-01-01 00:00:00 UTC. A fractional day, as in parseData's Day column, adds its time of day
+    time_t UnixTimestamp(const double year, const double month, const double day, const double hour = 0, const double minute = 0, const double second = 0);
+    TimestampBenchmark benchmarkTimestamps(const std::string& text, const int repeats = 5); //text as for parseCSV
     Matrix engineerData(const Matrix& data);
+    //Only the named features (FeatureGraph::features()), in that order, computing only what they depend on
+    Matrix engineerData(const Matrix& data, const std::vector<std::string>& features);
+    //Engineers rows that continue the series described by state and advances it; calling it on consecutive
+    //pieces of a series gives the same features as one call on the whole series
+    Matrix engineerData(const Matrix& data, IndicatorState& state);
     Matrix standardizeData(const Matrix& data);
     Matrix normalizeData(const Matrix& data);
+    Tensor3D generate_tensor(const Matrix& data, const int timesteps);
+    std::tuple<Matrix, Matrix> preprocessFeaturesFromFile(const std::string& filename); //Scaled features and targets, not windowed
+    std::tuple<Matrix, Matrix> preprocessFeaturesFromFile(const std::string& filename, const std::vector<std::string>& features);
     std::tuple<Tensor3D, Matrix> preprocessDataFromFile(const std::string& filename);
     Matrix preprocessData(const Matrix& data);
 }
@@ -0,0 +1,155 @@
+#include "FeatureCache.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace FeatureCache {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        constexpr char MAGIC[8] = {'Q', 'N', 'F', 'E', 'A', 'T', '0', '1'};
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t n_features;
+            uint64_t rows;
+        };
+
+        Header read_header(std::istream& file, const std::string& path) {
+            Header header;
+            if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != 1) {
+                throw std::runtime_error("Not a compatible feature cache: " + path);
+            }
+            return header;
+        }
+
+        //Features then the target
+        size_t row_bytes(const Header& header) {
+            return (header.n_features + 1) * sizeof(double);
+        }
+    }
+
+    size_t rows(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return 0;
+        }
+        return read_header(file, path).rows;
+    }
+
+    void append(const std::string& path, const Matrix& X, const Matrix& Y) {
+        if (X.size() != Y.size()) {
+            throw std::invalid_argument("Feature cache rows need one target each");
+        }
+        if (X.empty()) {
+            return;
+        }
+        const uint32_t n_features = X[0].size();
+
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        Header header;
+        if (file.is_open()) {
+            header = read_header(file, path);
+            if (header.n_features != n_features) {
+                throw std::invalid_argument("Feature cache " + path + " holds " + std::to_string(header.n_features) + " features, got " + std::to_string(n_features));
+            }
+        } else {
+            file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not create feature cache " + path);
+            }
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = 1;
+            header.n_features = n_features;
+            header.rows = 0;
+        }
+
+        //Rows go after the last committed row, so the leftovers of an interrupted append are overwritten
+        file.seekp(static_cast<std::streamoff>(sizeof(Header) + header.rows * row_bytes(header)));
+        std::vector<double> row(n_features + 1);
+        for (size_t i = 0; i < X.size(); i++) {
+            if (X[i].size() != n_features || Y[i].empty()) {
+                throw std::invalid_argument("Feature cache rows must all have the same shape");
+            }
+            std::copy(X[i].begin(), X[i].end(), row.begin());
+            row[n_features] = Y[i][0];
+            file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row_bytes(header)));
+        }
+        file.flush();
+
+        //The row count is written last, it is what commits the new rows
+        header.rows += X.size();
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.flush();
+        if (!file.good()) {
+            throw std::runtime_error("Failed appending to feature cache " + path);
+        }
+    }
+
+    std::tuple<Matrix, Matrix> read(const std::string& path, const size_t from, const size_t to) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open feature cache " + path);
+        }
+        const Header header = read_header(file, path);
+        const size_t end = std::min<size_t>(to, header.rows);
+        const size_t count = from < end ? end - from : 0;
+
+        Matrix X(count, std::vector<double>(header.n_features));
+        Matrix Y(count, std::vector<double>(1));
+        file.seekg(static_cast<std::streamoff>(sizeof(Header) + from * row_bytes(header)));
+        std::vector<double> row(header.n_features + 1);
+        for (size_t i = 0; i < count; i++) {
+            if (!file.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row_bytes(header)))) {
+                throw std::runtime_error("Truncated feature cache " + path);
+            }
+            std::copy(row.begin(), row.end() - 1, X[i].begin());
+            Y[i][0] = row.back();
+        }
+        return std::make_tuple(std::move(X), std::move(Y));
+    }
+
+    linalg::View Block::matrix() const {
+        return linalg::View(features.get(), rows, n_features, n_features);
+    }
+
+    linalg::View Block::window(const size_t w, const size_t timesteps) const {
+        if (w + timesteps > rows) {
+            throw std::out_of_range("Window " + std::to_string(w) + " runs past the end of the feature block");
+        }
+        return linalg::View(features.get() + w * n_features, timesteps, n_features, n_features);
+    }
+
+    Block load(const std::string& path, const size_t from, const size_t to) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open feature cache " + path);
+        }
+        const Header header = read_header(file, path);
+        const size_t end = std::min<size_t>(to, header.rows);
+
+        Block block;
+        block.rows = from < end ? end - from : 0;
+        block.n_features = header.n_features;
+        block.features = memory::make_buffer<double>(block.rows * block.n_features);
+        block.targets.resize(block.rows);
+
+        file.seekg(static_cast<std::streamoff>(sizeof(Header) + from * row_bytes(header)));
+        std::vector<double> row(header.n_features + 1);
+        for (size_t i = 0; i < block.rows; i++) {
+            if (!file.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row_bytes(header)))) {
+                throw std::runtime_error("Truncated feature cache " + path);
+            }
+            std::copy(row.begin(), row.end() - 1, block.features.get() + i * block.n_features);
+            block.targets[i] = row.back();
+        }
+        return block;
+    }
+}
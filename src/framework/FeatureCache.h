@@ -0,0 +1,46 @@
+#ifndef FEATURECACHE_H
+#define FEATURECACHE_H
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <cstddef>
+
+#include "../model/linalg.h"
+#include "../model/memory.h"
+
+/*
+ * Append-only binary cache of preprocessed feature rows and their targets.
+ *
+ * Layout: a fixed header (feature count, row count) followed by fixed-size rows of n_features doubles and one
+ * target each, in time order. New bars are appended without rewriting what is already there, and any row range
+ * can be read back with a single seek, so a nightly update only touches the rows it needs.
+ */
+namespace FeatureCache {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    //Number of rows in the cache, 0 if the file does not exist yet
+    size_t rows(const std::string& path);
+
+    //Append rows (X of shape (n, n_features), Y of shape (n, 1)), creating the cache if needed
+    void append(const std::string& path, const Matrix& X, const Matrix& Y);
+
+    //Rows [from, to) as (X, Y), to is clamped to the number of rows
+    std::tuple<Matrix, Matrix> read(const std::string& path, const size_t from, const size_t to = static_cast<size_t>(-1));
+
+    //Rows [from, to) in one contiguous row-major buffer from memory::allocate, so a large dataset is 64-byte
+    //aligned and uses huge pages when memory::set_huge_pages enables them. Windows are views into the buffer,
+    //not copies: window w is rows w .. w + timesteps - 1
+    struct Block {
+        memory::Buffer<double> features; //(rows, n_features)
+        std::vector<double> targets;     //One per row
+        size_t rows = 0;
+        size_t n_features = 0;
+
+        linalg::View matrix() const;
+        linalg::View window(const size_t w, const size_t timesteps) const;
+    };
+    Block load(const std::string& path, const size_t from = 0, const size_t to = static_cast<size_t>(-1));
+}
+
+#endif //FEATURECACHE_H
@@ -0,0 +1,342 @@
+#include "FeatureGraph.h"
+#include "DataFramework.h"
+#include "../model/parallel.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace FeatureGraph {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        typedef std::vector<double> Column;
+
+        //A column of the series computed from the columns of its inputs, or a column of the raw data for leaves
+        struct Node {
+            std::string name;
+            std::vector<std::string> inputs;
+            std::function<Column(const std::vector<const Column*>& in)> compute;
+            int raw = -1; //parseData column of a leaf
+        };
+
+        //Elementwise f(in[0][row], in[1][row], ...) of same-length inputs
+        template <typename F>
+        Column map_rows(const std::vector<const Column*>& in, F f) {
+            Column values(in[0]->size());
+            for (size_t row = 0; row < values.size(); row++) {
+                values[row] = f(row);
+            }
+            return values;
+        }
+
+        //Extreme of the trailing window of `length` rows ending at each row (shorter at the start), in O(rows)
+        //with a monotonic deque. Minima and maxima are exact, so this matches a rescan of the window
+        template <typename Compare>
+        Column rolling_extreme(const Column& values, const size_t length, Compare better) {
+            Column result(values.size());
+            std::deque<size_t> candidates;
+            for (size_t row = 0; row < values.size(); row++) {
+                while (!candidates.empty() && !better(values[candidates.back()], values[row])) {
+                    candidates.pop_back();
+                }
+                candidates.push_back(row);
+                if (candidates.front() + length <= row) {
+                    candidates.pop_front();
+                }
+                result[row] = values[candidates.front()];
+            }
+            return result;
+        }
+
+        //+DI or -DI, from the directional movement move(i) of each row and the ATR
+        template <typename Move>
+        Column directional_index(const Column& ATR, Move move) {
+            Column result(ATR.size(), 0.0);
+            for (size_t row = 15; row < ATR.size(); row++) {
+                double DM = 0.0;
+                for (size_t i = row; i > row - 14; i--) {
+                    DM += move(i);
+                }
+                DM = DM - (DM / 14) + move(row);
+                result[row] = DM / ATR[row];
+            }
+            return result;
+        }
+
+        /*
+         * The nodes, inputs before the nodes that read them. Formulas are engineerData's, including its quirks
+         * (e.g. NaN first rows of the EMAs), so the columns are bitwise equal to engineerData on the whole series.
+         * The 14-day EMA and MACD's 12/26-day EMAs are seeded differently there (MACD's seeds carry over between
+         * rows and feed back through the MACD column), so they stay separate nodes rather than sharing an EMA(n).
+         */
+        const std::vector<Node>& graph() {
+            static const std::vector<Node> nodes = [] {
+                std::vector<Node> g;
+                const char* raw_names[] = {"Year", "Month", "Day", "Open", "High", "Low", "Close"};
+                for (int column = 0; column < 7; column++) {
+                    g.push_back({raw_names[column], {}, nullptr, column});
+                }
+
+                g.push_back({"Daily Var", {"High", "Low"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) { return (*in[0])[r] - (*in[1])[r]; });
+                }});
+                g.push_back({"Timestamp", {"Year", "Month", "Day"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) {
+                        return static_cast<double>(DataFramework::UnixTimestamp((*in[0])[r], (*in[1])[r], (*in[2])[r]));
+                    });
+                }});
+                g.push_back({"7-Day SMA", {"Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    Column SMA(close.size(), 0.0);
+                    for (size_t row = 8; row < close.size(); row++) {
+                        for (size_t back = row; back > row - 7; back--) {
+                            SMA[row] += close[back];
+                        }
+                        SMA[row] /= 7;
+                    }
+                    return SMA;
+                }});
+                g.push_back({"7-Day STD", {"Close", "7-Day SMA"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    const Column& SMA = *in[1];
+                    Column STD(close.size(), 0.0);
+                    for (size_t row = 8; row < close.size(); row++) {
+                        for (size_t back = row; back > row - 7; back--) {
+                            STD[row] += std::pow(close[back] - SMA[row], 2);
+                        }
+                        STD[row] = std::sqrt(STD[row] / 7);
+                    }
+                    return STD;
+                }});
+                g.push_back({"High-Close", {"High", "Close"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) { return (*in[0])[r] - (*in[1])[r]; });
+                }});
+                g.push_back({"Low-Open", {"Low", "Open"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) { return (*in[0])[r] - (*in[1])[r]; });
+                }});
+                g.push_back({"Cumul Return", {"Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    return map_rows(in, [&](const size_t r) { return (close[r] - close[0]) / close[0]; });
+                }});
+                g.push_back({"14-Day EMA", {"Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    const double SMOOTHING_FACTOR = 2.0/(1.0+14.0);
+                    Column EMA(close.size(), 0.0);
+                    for (size_t row = 0; row < close.size(); row++) {
+                        if (row < 14) {
+                            for (size_t i = 0; i < row; i++) {
+                                EMA[row] += close[row];
+                            }
+                            EMA[row] /= row;
+                        } else {
+                            EMA[row] = (close[row] * SMOOTHING_FACTOR + EMA[row-1] * (1-SMOOTHING_FACTOR));
+                        }
+                    }
+                    return EMA;
+                }});
+                g.push_back({"Close Change", {"Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    return map_rows(in, [&](const size_t r) { return (r > 0) ? close[r] - close[r-1] : 0.0; });
+                }});
+                g.push_back({"MACD", {"Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    const double SMOOTHING_FACTOR_12 = 2.0/(1.0+12.0);
+                    const double SMOOTHING_FACTOR_26 = 2.0/(1.0+26.0);
+                    double EMA_12_day = 0.0;
+                    double EMA_26_day = 0.0;
+                    Column MACD(close.size(), 0.0);
+                    for (size_t row = 0; row < close.size(); row++) {
+                        if (row < 12) {
+                            for (size_t i = 0; i < row; i++) {
+                                EMA_12_day += close[row];
+                            }
+                            EMA_12_day /= row;
+                            MACD[row] = EMA_12_day;
+                        } else if (row < 26) {
+                            EMA_12_day = (close[row] * SMOOTHING_FACTOR_12 + MACD[row-1] * (1-SMOOTHING_FACTOR_12));
+                            for (size_t i = 0; i < row; i++) {
+                                EMA_26_day += close[row];
+                            }
+                            EMA_26_day /= row;
+                            MACD[row] = EMA_26_day - EMA_12_day;
+                        } else {
+                            EMA_26_day = (close[row] * SMOOTHING_FACTOR_26 + EMA_26_day * (1-SMOOTHING_FACTOR_26));
+                            EMA_12_day = (close[row] * SMOOTHING_FACTOR_12 + EMA_12_day * (1-SMOOTHING_FACTOR_12));
+                            MACD[row] = EMA_26_day - EMA_12_day;
+                        }
+                    }
+                    return MACD;
+                }});
+                g.push_back({"14-Day High", {"High"}, [](const std::vector<const Column*>& in) {
+                    return rolling_extreme(*in[0], 14, [](const double kept, const double next) { return kept > next; });
+                }});
+                g.push_back({"14-Day Low", {"Low"}, [](const std::vector<const Column*>& in) {
+                    return rolling_extreme(*in[0], 14, [](const double kept, const double next) { return kept < next; });
+                }});
+                g.push_back({"Stochastic Osc", {"Close", "14-Day Low", "14-Day High"}, [](const std::vector<const Column*>& in) {
+                    const Column& close = *in[0];
+                    const Column& lowest = *in[1];
+                    const Column& highest = *in[2];
+                    return map_rows(in, [&](const size_t r) {
+                        return (r < 14) ? close[r] : (close[r] - lowest[r]) / (highest[r] - lowest[r]);
+                    });
+                }});
+                g.push_back({"True Range", {"High", "Low", "Close"}, [](const std::vector<const Column*>& in) {
+                    const Column& high = *in[0];
+                    const Column& low = *in[1];
+                    const Column& close = *in[2];
+                    return map_rows(in, [&](const size_t r) {
+                        return (r == 0) ? high[r] - low[r] : std::max({high[r] - low[r], high[r] - close[r-1], low[r] - close[r-1]});
+                    });
+                }});
+                g.push_back({"ATR", {"True Range"}, [](const std::vector<const Column*>& in) {
+                    const Column& true_range = *in[0];
+                    Column ATR(true_range.size(), 0.0);
+                    for (size_t row = 1; row < true_range.size(); row++) {
+                        if (row < 14) {
+                            for (size_t i = row; i > 0; i--) {
+                                ATR[row] += true_range[i];
+                            }
+                            ATR[row] /= row;
+                        } else {
+                            ATR[row] = (ATR[row-1] + true_range[row]) / 14;
+                        }
+                    }
+                    return ATR;
+                }});
+                g.push_back({"+DI", {"High", "ATR"}, [](const std::vector<const Column*>& in) {
+                    const Column& high = *in[0];
+                    return directional_index(*in[1], [&](const size_t i) { return high[i] - high[i-1]; });
+                }});
+                g.push_back({"-DI", {"Low", "ATR"}, [](const std::vector<const Column*>& in) {
+                    const Column& low = *in[0];
+                    return directional_index(*in[1], [&](const size_t i) { return low[i-1] - low[i]; });
+                }});
+                g.push_back({"ADX", {"+DI", "-DI"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) { return (*in[0])[r] - (*in[1])[r]; });
+                }});
+                g.push_back({"DMI", {"+DI", "-DI"}, [](const std::vector<const Column*>& in) {
+                    return map_rows(in, [&](const size_t r) { return ((*in[0])[r] - (*in[1])[r]) / ((*in[0])[r] + (*in[1])[r]); });
+                }});
+                return g;
+            }();
+            return nodes;
+        }
+
+        size_t node_index(const std::string& name) {
+            const std::vector<Node>& nodes = graph();
+            for (size_t i = 0; i < nodes.size(); i++) {
+                if (nodes[i].name == name) {
+                    return i;
+                }
+            }
+            throw std::logic_error("Feature graph has no node " + name);
+        }
+
+        //Nodes needed for requested grouped into levels: a node's level is one past the deepest of its inputs, so
+        //the nodes of a level only read earlier levels
+        std::vector<std::vector<size_t>> levels(const std::vector<std::string>& requested) {
+            const std::vector<std::string>& names = features();
+            for (const std::string& name : requested) {
+                if (std::find(names.begin(), names.end(), name) == names.end()) {
+                    throw std::invalid_argument("Unknown feature " + name);
+                }
+            }
+
+            const std::vector<Node>& nodes = graph();
+            std::vector<int> level(nodes.size(), -1);
+            std::function<int(size_t)> visit = [&](const size_t node) {
+                if (level[node] < 0) {
+                    int deepest = -1;
+                    for (const std::string& input : nodes[node].inputs) {
+                        deepest = std::max(deepest, visit(node_index(input)));
+                    }
+                    level[node] = deepest + 1;
+                }
+                return level[node];
+            };
+            for (const std::string& name : requested) {
+                visit(node_index(name));
+            }
+
+            std::vector<std::vector<size_t>> grouped;
+            for (size_t node = 0; node < nodes.size(); node++) {
+                if (level[node] >= 0) {
+                    grouped.resize(std::max<size_t>(grouped.size(), level[node] + 1));
+                    grouped[level[node]].push_back(node);
+                }
+            }
+            return grouped;
+        }
+    }
+
+    const std::vector<std::string>& features() {
+        static const std::vector<std::string> names = {
+            "Year", "Month", "Daily Var", "Timestamp", "7-Day SMA", "7-Day STD", "High-Close", "Low-Open",
+            "Cumul Return", "14-Day EMA", "Close Change", "MACD", "Stochastic Osc", "ATR", "ADX", "DMI"
+        };
+        return names;
+    }
+
+    std::vector<std::string> plan(const std::vector<std::string>& requested) {
+        std::vector<std::string> order;
+        for (const std::vector<size_t>& level : levels(requested)) {
+            for (const size_t node : level) {
+                order.push_back(graph()[node].name);
+            }
+        }
+        return order;
+    }
+
+    Matrix engineer(const Matrix& data, const std::vector<std::string>& requested) {
+        const std::vector<std::vector<size_t>> order = levels(requested);
+        if (data.empty() || order.empty()) {
+            return Matrix(data.size()); //No rows, or no features: (rows, 0)
+        }
+
+        //The leaves are the first level, read from the rows in one pass
+        const std::vector<Node>& nodes = graph();
+        std::vector<Column> columns(nodes.size());
+        for (const size_t leaf : order[0]) {
+            columns[leaf].resize(data.size());
+        }
+        for (size_t row = 0; row < data.size(); row++) {
+            for (const size_t leaf : order[0]) {
+                columns[leaf][row] = data[row][nodes[leaf].raw];
+            }
+        }
+
+        //Every other needed node is evaluated once into its own column, the nodes of a level in parallel
+        for (size_t l = 1; l < order.size(); l++) {
+            const std::vector<size_t>& level = order[l];
+            parallel::parallel_for(0, level.size(), 1, [&](const size_t first, const size_t last) {
+                for (size_t k = first; k < last; k++) {
+                    const Node& node = nodes[level[k]];
+                    std::vector<const Column*> inputs;
+                    for (const std::string& input : node.inputs) {
+                        inputs.push_back(&columns[node_index(input)]);
+                    }
+                    columns[level[k]] = node.compute(inputs);
+                }
+            });
+        }
+
+        //Filled row by row, reading the requested columns side by side
+        std::vector<const Column*> selected;
+        for (const std::string& name : requested) {
+            selected.push_back(&columns[node_index(name)]);
+        }
+        Matrix result(data.size(), std::vector<double>(requested.size()));
+        for (size_t row = 0; row < data.size(); row++) {
+            for (size_t j = 0; j < selected.size(); j++) {
+                result[row][j] = (*selected[j])[row];
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef FEATUREGRAPH_H
+#define FEATUREGRAPH_H
+
+#include <string>
+#include <vector>
+
+/*
+ * engineerData's features as a graph of column computations, evaluated lazily.
+ *
+ * Each feature is a node computing one column over the whole series from the columns of its inputs. engineer()
+ * evaluates only the nodes the requested features depend on, level by level, with the nodes of a level (the
+ * independent branches) running in parallel. Values are the same as the matching columns of engineerData on the
+ * whole series.
+ *
+ * Sharing is limited to the intermediates engineerData itself reuses: 7-Day SMA (for 7-Day STD), 14-Day High and
+ * Low (for Stochastic Osc), and True Range -> ATR -> +DI/-DI (for ADX and DMI), each computed once when several
+ * requested features read it. The EMA features are not shared: 14-Day EMA and MACD each run their own EMAs, which
+ * engineerData seeds differently, so there is no common EMA(n) node. When every feature is needed,
+ * engineerData's single pass over the rows is faster on one core.
+ */
+namespace FeatureGraph {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    //Feature names in engineerData's column order
+    const std::vector<std::string>& features();
+
+    //Requested features of a series in the parseData layout, (rows, requested.size()) in the order of requested.
+    //An empty request gives (rows, 0). Throws std::invalid_argument for names that are not in features()
+    Matrix engineer(const Matrix& data, const std::vector<std::string>& requested);
+
+    //Nodes engineer() evaluates for requested, in evaluation order
+    std::vector<std::string> plan(const std::vector<std::string>& requested);
+}
+
+#endif //FEATUREGRAPH_H
@@ -0,0 +1,253 @@
+#include "FeaturePipeline.h"
+#include "DataFramework.h"
+#include "FeatureCache.h"
+#include "../model/reductions.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <tuple>
+#include <stdexcept>
+
+namespace FeaturePipeline {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        constexpr char MAGIC[8] = {'Q', 'N', 'P', 'I', 'P', 'E', '0', '1'};
+
+        Matrix closeColumn(const Matrix& raw) {
+            Matrix close(raw.size(), std::vector<double>(1));
+            for (size_t i = 0; i < raw.size(); i++) {
+                close[i][0] = raw[i][6];
+            }
+            return close;
+        }
+
+        //Replaces a NaN extremum like the comparisons in reductions::min/max skip it
+        double mergeMin(const double current, const double batch) {
+            return (batch < current || std::isnan(current)) ? batch : current;
+        }
+
+        double mergeMax(const double current, const double batch) {
+            return (batch > current || std::isnan(current)) ? batch : current;
+        }
+
+        template <typename T>
+        void write_value(std::ostream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        T read_value(std::istream& in) {
+            T value;
+            if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+                throw std::runtime_error("Truncated pipeline state");
+            }
+            return value;
+        }
+
+        void write_vector(std::ostream& out, const std::vector<double>& values) {
+            write_value<uint64_t>(out, values.size());
+            out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)));
+        }
+
+        std::vector<double> read_vector(std::istream& in) {
+            std::vector<double> values(read_value<uint64_t>(in));
+            if (!in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)))) {
+                throw std::runtime_error("Truncated pipeline state");
+            }
+            return values;
+        }
+
+        void write_scaler(std::ostream& out, const Scaler& scaler) {
+            write_value<uint64_t>(out, scaler.count);
+            for (const std::vector<double>* values : {&scaler.mean, &scaler.m2, &scaler.min, &scaler.max}) {
+                write_vector(out, *values);
+            }
+        }
+
+        Scaler read_scaler(std::istream& in) {
+            Scaler scaler;
+            scaler.count = read_value<uint64_t>(in);
+            for (std::vector<double>* values : {&scaler.mean, &scaler.m2, &scaler.min, &scaler.max}) {
+                *values = read_vector(in);
+            }
+            return scaler;
+        }
+    }
+
+    void Scaler::update(const Matrix& rows) {
+        if (rows.empty()) {
+            return;
+        }
+        //Batch statistics with the same reductions standardizeData and normalizeData use, then merged (Chan et al.)
+        const double n_batch = static_cast<double>(rows.size());
+        const std::vector<double> batch_mean = reductions::mean(rows, 0)[0];
+        const std::vector<double> batch_variance = reductions::variance(rows, 0)[0];
+        const std::vector<double> batch_min = reductions::min(rows, 0)[0];
+        const std::vector<double> batch_max = reductions::max(rows, 0)[0];
+
+        if (count == 0) {
+            mean = batch_mean;
+            m2.resize(batch_variance.size());
+            for (size_t j = 0; j < m2.size(); j++) {
+                m2[j] = batch_variance[j] * n_batch;
+            }
+            min = batch_min;
+            max = batch_max;
+            count = rows.size();
+            return;
+        }
+        if (batch_mean.size() != mean.size()) {
+            throw std::invalid_argument("Scaler rows changed their number of columns");
+        }
+
+        const double n_total = static_cast<double>(count) + n_batch;
+        for (size_t j = 0; j < mean.size(); j++) {
+            const double delta = batch_mean[j] - mean[j];
+            mean[j] += delta * n_batch / n_total;
+            m2[j] += batch_variance[j] * n_batch + delta * delta * static_cast<double>(count) * n_batch / n_total;
+            min[j] = mergeMin(min[j], batch_min[j]);
+            max[j] = mergeMax(max[j], batch_max[j]);
+        }
+        count += rows.size();
+    }
+
+    Matrix Scaler::transform(const Matrix& rows) const {
+        Matrix result(rows.size(), std::vector<double>(mean.size(), 0.0));
+        for (size_t j = 0; j < mean.size(); j++) {
+            const double stdev = std::sqrt(m2[j] / static_cast<double>(count));
+            //Standardized range of the column, min-max scaling is then applied to the standardized value
+            const double z_min = (stdev == 0) ? 0.0 : (min[j] - mean[j]) / stdev;
+            const double z_range = (stdev == 0) ? 0.0 : (max[j] - mean[j]) / stdev - z_min;
+            for (size_t i = 0; i < rows.size(); i++) {
+                if (z_range == 0) {
+                    result[i][j] = 0.5; //Edge case: max = min
+                } else {
+                    result[i][j] = ((rows[i][j] - mean[j]) / stdev - z_min) / z_range;
+                }
+            }
+        }
+        return result;
+    }
+
+    size_t State::windows() const {
+        return indicators.rows >= static_cast<size_t>(timesteps) ? indicators.rows - timesteps + 1 : 0;
+    }
+
+    State build(const Matrix& raw, const std::string& cache, const int timesteps, const ScalerPolicy policy) {
+        if (timesteps <= 0) {
+            throw std::invalid_argument("Pipeline timesteps must be positive");
+        }
+        State state;
+        state.timesteps = timesteps;
+        state.policy = policy;
+
+        const Matrix features = DataFramework::engineerData(raw, state.indicators);
+        const Matrix close = closeColumn(raw);
+        state.features.update(features);
+        state.target.update(close);
+
+        std::remove(cache.c_str());
+        FeatureCache::append(cache, state.features.transform(features), state.target.transform(close));
+        return state;
+    }
+
+    State buildFromFile(const std::string& filename, const std::string& cache, const int timesteps, const ScalerPolicy policy) {
+        return build(DataFramework::parseData(filename), cache, timesteps, policy);
+    }
+
+    Appended append(State& state, const Matrix& raw, const std::string& cache) {
+        Appended appended;
+        appended.first_window = appended.end_window = state.windows();
+        if (raw.empty()) {
+            return appended;
+        }
+        if (FeatureCache::rows(cache) != state.indicators.rows) {
+            throw std::runtime_error("Feature cache " + cache + " is out of sync with the pipeline state");
+        }
+
+        const Matrix features = DataFramework::engineerData(raw, state.indicators);
+        const Matrix close = closeColumn(raw);
+        if (state.policy == ScalerPolicy::Update) {
+            state.features.update(features);
+            state.target.update(close);
+        }
+        FeatureCache::append(cache, state.features.transform(features), state.target.transform(close));
+
+        appended.rows = raw.size();
+        appended.end_window = state.windows();
+        return appended;
+    }
+
+    Appended appendFromFile(State& state, const std::string& filename, const std::string& cache) {
+        const Matrix parsed = DataFramework::parseData(filename);
+        if (state.indicators.history.empty()) {
+            return append(state, parsed, cache);
+        }
+        //Dates are the first three columns (the time of day is in the Day fraction), rows up to the last known
+        //date and time were already appended
+        const std::vector<double>& last = state.indicators.history.back();
+        const auto last_date = std::make_tuple(last[0], last[1], last[2]);
+        Matrix raw;
+        for (const std::vector<double>& row : parsed) {
+            if (std::make_tuple(row[0], row[1], row[2]) > last_date) {
+                raw.push_back(row);
+            }
+        }
+        return append(state, raw, cache);
+    }
+
+    void save(const std::string& path, const State& state) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open " + path + " for writing");
+        }
+        const DataFramework::IndicatorState& indicators = state.indicators;
+        file.write(MAGIC, sizeof(MAGIC));
+        write_value<int32_t>(file, state.timesteps);
+        write_value<uint8_t>(file, state.policy == ScalerPolicy::Update);
+        write_value<uint64_t>(file, indicators.rows);
+        write_value<double>(file, indicators.first_close);
+        write_value<double>(file, indicators.EMA_12_day);
+        write_value<double>(file, indicators.EMA_26_day);
+        write_vector(file, indicators.last_features);
+        write_value<uint64_t>(file, indicators.history.size());
+        for (const std::vector<double>& row : indicators.history) {
+            write_vector(file, row);
+        }
+        write_scaler(file, state.features);
+        write_scaler(file, state.target);
+        if (!file.good()) {
+            throw std::runtime_error("Failed writing pipeline state " + path);
+        }
+    }
+
+    State load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        if (!file.is_open() || !file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Not a pipeline state: " + path);
+        }
+        State state;
+        DataFramework::IndicatorState& indicators = state.indicators;
+        state.timesteps = read_value<int32_t>(file);
+        state.policy = read_value<uint8_t>(file) ? ScalerPolicy::Update : ScalerPolicy::Frozen;
+        indicators.rows = read_value<uint64_t>(file);
+        indicators.first_close = read_value<double>(file);
+        indicators.EMA_12_day = read_value<double>(file);
+        indicators.EMA_26_day = read_value<double>(file);
+        indicators.last_features = read_vector(file);
+        indicators.history.resize(read_value<uint64_t>(file));
+        for (std::vector<double>& row : indicators.history) {
+            row = read_vector(file);
+        }
+        state.features = read_scaler(file);
+        state.target = read_scaler(file);
+        return state;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef FEATUREPIPELINE_H
+#define FEATUREPIPELINE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "DataFramework.h"
+
+/*
+ * Incremental version of preprocessFeaturesFromFile that feeds a FeatureCache.
+ *
+ * build() engineers, scales and caches a full history once. After that, append() handles each batch of new raw
+ * bars on its own. It continues engineerData from the saved IndicatorState, scales the new rows with the saved
+ * statistics and appends them to the cache. Earlier rows are not read again. Windows are not stored: window w
+ * covers cache rows w .. w + timesteps - 1, so append() reports the range of windows the new rows complete.
+ *
+ * Scaling is normalizeData(standardizeData(x)) per column, computed from a running count, mean, sum of squared
+ * deviations, min and max. Under ScalerPolicy::Frozen the statistics fitted by build() are kept, so every cached
+ * row uses the same scale. Under ScalerPolicy::Update each appended batch is merged into the statistics before it
+ * is scaled. Rows that are already cached keep the scale they were written with.
+ */
+namespace FeaturePipeline {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    enum class ScalerPolicy { Frozen, Update };
+
+    //Per-column statistics of standardizeData followed by normalizeData, mergeable across batches
+    struct Scaler {
+        size_t count = 0;
+        std::vector<double> mean;
+        std::vector<double> m2; //Sum of squared deviations from the mean
+        std::vector<double> min;
+        std::vector<double> max;
+
+        void update(const Matrix& rows);
+        Matrix transform(const Matrix& rows) const;
+    };
+
+    struct State {
+        int timesteps = 30;
+        ScalerPolicy policy = ScalerPolicy::Frozen;
+        DataFramework::IndicatorState indicators; //indicators.rows is the number of cached rows
+        Scaler features;
+        Scaler target; //Close column
+
+        size_t windows() const;
+    };
+
+    //Rows added by one call and the windows they complete, [first_window, end_window)
+    struct Appended {
+        size_t rows = 0;
+        size_t first_window = 0;
+        size_t end_window = 0;
+    };
+
+    //Engineer, fit and cache a full history of raw rows (parseData layout), replacing any existing cache
+    State build(const Matrix& raw, const std::string& cache, const int timesteps = 30, const ScalerPolicy policy = ScalerPolicy::Frozen);
+    State buildFromFile(const std::string& filename, const std::string& cache, const int timesteps = 30, const ScalerPolicy policy = ScalerPolicy::Frozen);
+
+    //Continue the series with new raw rows
+    Appended append(State& state, const Matrix& raw, const std::string& cache);
+    //Parse a CSV and append only the rows dated after the last row already in the series
+    Appended appendFromFile(State& state, const std::string& filename, const std::string& cache);
+
+    void save(const std::string& path, const State& state);
+    State load(const std::string& path);
+}
+
+#endif //FEATUREPIPELINE_H
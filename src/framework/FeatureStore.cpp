@@ -0,0 +1,631 @@
+#include "FeatureStore.h"
+#include "../model/parallel.h"
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define QUANTNET_HAS_MMAP 1
+#endif
+
+typedef FeatureStore::Matrix Matrix;
+
+//One per block, in time order, so row and time lookups are binary searches over the mapped index
+struct FeatureStore::BlockEntry {
+    uint64_t first_row;
+    uint64_t offset; //Block start in the file
+    uint64_t size;   //Block bytes
+    int64_t first_timestamp;
+    int64_t last_timestamp;
+    uint32_t rows;
+    uint32_t reserved;
+};
+
+namespace {
+    constexpr char MAGIC[8] = {'Q', 'N', 'F', 'S', 'T', 'O', 'R', '1'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t ENDIAN_MARKER = 0x01020304; //Raw columns are stored in native byte order
+    constexpr size_t ALIGNMENT = 8;
+    constexpr size_t PADDING = 8;                  //Zero bytes after each column, BitReader loads 8 bytes at a time
+
+    enum Codec : uint32_t { RAW = 0, GORILLA = 1, DELTA = 2 };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t n_features;
+        uint32_t block_rows;
+        uint64_t rows;
+        uint64_t blocks;
+        uint64_t index_offset;
+    };
+
+    //A block starts with one entry per column: timestamps, the features, then the target
+    struct ColumnEntry {
+        uint32_t offset; //From the block start
+        uint32_t bytes;
+        uint32_t codec;
+        uint32_t reserved;
+    };
+
+    size_t align(const size_t n) {
+        return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    uint64_t bits_of(const double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double value_of(const uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    //Most significant bit first
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<unsigned char>& out) : out(out) {}
+
+        void write(uint64_t value, int n) { //Low n bits of value, 1 <= n <= 64
+            if (n > 32) {
+                write(value >> 32, n - 32);
+                value &= 0xffffffffULL;
+                n = 32;
+            }
+            acc = (acc << n) | (value & ((uint64_t(1) << n) - 1));
+            filled += n;
+            while (filled >= 8) {
+                filled -= 8;
+                out.push_back(static_cast<unsigned char>(acc >> filled));
+            }
+        }
+
+        void flush() {
+            if (filled > 0) {
+                out.push_back(static_cast<unsigned char>(acc << (8 - filled)));
+                filled = 0;
+            }
+        }
+
+    private:
+        std::vector<unsigned char>& out;
+        uint64_t acc = 0;
+        int filled = 0;
+    };
+
+    //Reads past the column's bytes throw instead of running into the next column, so corrupt payloads cannot
+    //read outside their block (the PADDING bytes cover the last 8-byte load)
+    class BitReader {
+    public:
+        BitReader(const unsigned char* data, const size_t bytes) : data(data), limit(bytes * 8) {}
+
+        uint64_t read(const int n) { //1 <= n <= 64
+            if (n > 32) {
+                const uint64_t high = read(n - 32);
+                return (high << 32) | read(32);
+            }
+            if (pos + n > limit) {
+                throw std::runtime_error("Corrupt feature store: column data out of range");
+            }
+            uint64_t word;
+            std::memcpy(&word, data + (pos >> 3), sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            const uint64_t value = (word << (pos & 7)) >> (64 - n);
+            pos += n;
+            return value;
+        }
+
+    private:
+        const unsigned char* data;
+        size_t limit; //In bits
+        size_t pos = 0; //In bits
+    };
+
+    //Gorilla XOR compression: a value equal to the previous one costs one bit, otherwise only the bits between
+    //the leading and trailing zeros of the XOR are stored, reusing the previous window when they fit in it
+    void encode_gorilla(const double* values, const size_t n, const size_t stride, std::vector<unsigned char>& out) {
+        BitWriter writer(out);
+        uint64_t previous = bits_of(values[0]);
+        writer.write(previous, 64);
+        int leading = -1;
+        int trailing = 0;
+        for (size_t i = 1; i < n; i++) {
+            const uint64_t current = bits_of(values[i * stride]);
+            const uint64_t x = current ^ previous;
+            previous = current;
+            if (x == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+            writer.write(1, 1);
+            const int l = std::min(__builtin_clzll(x), 31);
+            const int t = __builtin_ctzll(x);
+            if (leading >= 0 && l >= leading && t >= trailing) {
+                writer.write(0, 1);
+                writer.write(x >> trailing, 64 - leading - trailing);
+            } else {
+                leading = l;
+                trailing = t;
+                const int length = 64 - l - t;
+                writer.write(1, 1);
+                writer.write(static_cast<uint64_t>(l), 5);
+                writer.write(static_cast<uint64_t>(length - 1), 6);
+                writer.write(x >> t, length);
+            }
+        }
+        writer.flush();
+    }
+
+    //Decodes the first `end` values, storing those from `begin` on to out[(i - begin) * stride]
+    void decode_gorilla(const unsigned char* data, const size_t bytes, const size_t begin, const size_t end, double* out, const size_t stride) {
+        BitReader reader(data, bytes);
+        uint64_t previous = reader.read(64);
+        int leading = 0;
+        int trailing = 0;
+        for (size_t i = 0; i < end; i++) {
+            if (i > 0 && reader.read(1) != 0) {
+                if (reader.read(1) != 0) {
+                    leading = static_cast<int>(reader.read(5));
+                    const int length = static_cast<int>(reader.read(6)) + 1;
+                    //The encoder never writes more meaningful bits than fit after the leading zeros
+                    if (leading + length > 64) {
+                        throw std::runtime_error("Corrupt feature store: Gorilla value wider than 64 bits");
+                    }
+                    trailing = 64 - leading - length;
+                }
+                previous ^= reader.read(64 - leading - trailing) << trailing;
+            }
+            if (i >= begin) {
+                out[(i - begin) * stride] = value_of(previous);
+            }
+        }
+    }
+
+    void write_varint(uint64_t value, std::vector<unsigned char>& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    uint64_t read_varint(const unsigned char*& p, const unsigned char* end) {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p == end || shift >= 64) {
+                throw std::runtime_error("Corrupt feature store: column data out of range");
+            }
+            const unsigned char byte = *p++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    uint64_t zigzag(const int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t unzigzag(const uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    //First value, then the change of each delta from the previous one
+    void encode_timestamps(const int64_t* values, const size_t n, std::vector<unsigned char>& out) {
+        int64_t previous = values[0];
+        int64_t delta = 0;
+        write_varint(zigzag(previous), out);
+        for (size_t i = 1; i < n; i++) {
+            const int64_t current_delta = values[i] - previous;
+            write_varint(zigzag(current_delta - delta), out);
+            delta = current_delta;
+            previous = values[i];
+        }
+    }
+
+    void decode_timestamps(const unsigned char* data, const size_t bytes, const size_t begin, const size_t end, int64_t* out) {
+        const unsigned char* p = data;
+        const unsigned char* data_end = data + bytes;
+        int64_t value = unzigzag(read_varint(p, data_end));
+        int64_t delta = 0;
+        for (size_t i = 0; i < end; i++) {
+            if (i > 0) {
+                delta += unzigzag(read_varint(p, data_end));
+                value += delta;
+            }
+            if (i >= begin) {
+                out[i - begin] = value;
+            }
+        }
+    }
+
+    //Columns of rows [first, first + n): timestamps, features, target
+    std::vector<unsigned char> encode_block(const std::vector<int64_t>& timestamps, const Matrix& X, const Matrix& Y,
+                                            const size_t first, const size_t n, const size_t n_features, const bool compress) {
+        const size_t num_columns = n_features + 2;
+        std::vector<unsigned char> block(num_columns * sizeof(ColumnEntry));
+        std::vector<ColumnEntry> columns(num_columns);
+
+        std::vector<double> column(n);
+        std::vector<unsigned char> payload;
+        for (size_t c = 0; c < num_columns; c++) {
+            payload.clear();
+            uint32_t codec = RAW;
+            if (c == 0) {
+                encode_timestamps(timestamps.data() + first, n, payload);
+                codec = DELTA;
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    column[i] = (c <= n_features) ? X[first + i][c - 1] : Y[first + i][0];
+                }
+                if (compress) {
+                    encode_gorilla(column.data(), n, 1, payload);
+                    codec = GORILLA;
+                }
+                //Noisy columns can come out larger than the doubles themselves
+                if (!compress || payload.size() >= n * sizeof(double)) {
+                    payload.resize(n * sizeof(double));
+                    std::memcpy(payload.data(), column.data(), payload.size());
+                    codec = RAW;
+                }
+            }
+            //Column offsets and sizes are stored as 32-bit values
+            if (block.size() + payload.size() > UINT32_MAX) {
+                throw std::invalid_argument("Feature store block exceeds 4 GiB, use a smaller block_rows");
+            }
+            columns[c] = {static_cast<uint32_t>(block.size()), static_cast<uint32_t>(payload.size()), codec, 0};
+            block.insert(block.end(), payload.begin(), payload.end());
+            block.resize(align(block.size() + PADDING), 0);
+        }
+        std::memcpy(block.data(), columns.data(), num_columns * sizeof(ColumnEntry));
+        return block;
+    }
+
+    //Checks a block's column table against the block's own bounds: every column starts after the table, aligned,
+    //and ends (with its padding) inside the block, with the codec its position allows. RAW columns hold one double
+    //per row, compressed ones are bounded by their byte count when they are decoded
+    bool valid_columns(const unsigned char* data, const size_t size, const size_t rows, const size_t num_columns) {
+        const size_t columns_bytes = num_columns * sizeof(ColumnEntry);
+        if (size < columns_bytes) {
+            return false;
+        }
+        const ColumnEntry* columns = reinterpret_cast<const ColumnEntry*>(data);
+        for (size_t c = 0; c < num_columns; c++) {
+            const ColumnEntry& column = columns[c];
+            const bool codec_valid = (c == 0)
+                ? column.codec == DELTA && column.bytes > 0
+                : (column.codec == RAW && column.bytes == rows * sizeof(double)) || (column.codec == GORILLA && column.bytes >= sizeof(uint64_t));
+            if (!codec_valid || column.offset < columns_bytes || column.offset % ALIGNMENT != 0 || column.offset > size ||
+                static_cast<size_t>(column.bytes) + PADDING > size - column.offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double seconds_since(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void FeatureStore::write(const std::string& path, const std::vector<int64_t>& timestamps, const Matrix& X, const Matrix& Y, const Options& options) {
+    if (X.size() != Y.size() || X.size() != timestamps.size()) {
+        throw std::invalid_argument("Feature store rows need one timestamp and one target each");
+    }
+    const size_t n_features = X.empty() ? 0 : X[0].size();
+    for (size_t i = 0; i < X.size(); i++) {
+        if (X[i].size() != n_features || Y[i].empty()) {
+            throw std::invalid_argument("Feature store rows must all have the same shape");
+        }
+        if (i > 0 && timestamps[i] < timestamps[i - 1]) {
+            throw std::invalid_argument("Feature store timestamps must be non-decreasing");
+        }
+    }
+    const size_t block_rows = std::max<size_t>(options.block_rows, 1);
+    //The header and index store both as 32-bit values
+    if (block_rows > UINT32_MAX || n_features > UINT32_MAX - 2) {
+        throw std::invalid_argument("Feature store block_rows and feature count must fit in 32 bits");
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create feature store " + path);
+    }
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    //Blocks are encoded in parallel and written in order
+    const size_t num_blocks = (X.size() + block_rows - 1) / block_rows;
+    std::vector<std::vector<unsigned char>> encoded(num_blocks);
+    parallel::parallel_for(0, num_blocks, 1, [&](const size_t lo, const size_t hi) {
+        for (size_t b = lo; b < hi; b++) {
+            const size_t first = b * block_rows;
+            encoded[b] = encode_block(timestamps, X, Y, first, std::min(block_rows, X.size() - first), n_features, options.compress);
+        }
+    });
+
+    std::vector<BlockEntry> index(num_blocks);
+    size_t offset = align(sizeof(FileHeader));
+    for (size_t b = 0; b < num_blocks; b++) {
+        const size_t first = b * block_rows;
+        const size_t n = std::min(block_rows, X.size() - first);
+        index[b] = {first, offset, encoded[b].size(), timestamps[first], timestamps[first + n - 1], static_cast<uint32_t>(n), 0};
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(encoded[b].data()), static_cast<std::streamsize>(encoded[b].size()));
+        offset = align(offset + encoded[b].size());
+        std::vector<unsigned char>().swap(encoded[b]);
+    }
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = ENDIAN_MARKER;
+    header.n_features = static_cast<uint32_t>(n_features);
+    header.block_rows = static_cast<uint32_t>(block_rows);
+    header.rows = X.size();
+    header.blocks = num_blocks;
+    header.index_offset = offset;
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(BlockEntry)));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file.good()) {
+        throw std::runtime_error("Failed writing feature store " + path);
+    }
+}
+
+FeatureStore::FeatureStore(const std::string& path) {
+#ifdef QUANTNET_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open feature store " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("Feature store " + path + " is too small");
+    }
+    file_size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); //The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not memory-map feature store " + path);
+    }
+    base = static_cast<const unsigned char*>(mapping);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open feature store " + path);
+    }
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    base = fallback.data();
+    file_size = fallback.size();
+    if (file_size < sizeof(FileHeader)) {
+        throw std::runtime_error("Feature store " + path + " is too small");
+    }
+#endif
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 header.version == VERSION && header.byte_order == ENDIAN_MARKER &&
+                 header.index_offset % alignof(BlockEntry) == 0 && header.index_offset <= file_size &&
+                 header.blocks <= (file_size - header.index_offset) / sizeof(BlockEntry);
+    if (valid) {
+        index = reinterpret_cast<const BlockEntry*>(base + header.index_offset);
+        //Blocks tile the rows in order and lie before the index, and each one's columns lie inside it
+        uint64_t next_row = 0;
+        for (size_t b = 0; b < header.blocks && valid; b++) {
+            const BlockEntry& entry = index[b];
+            valid = entry.rows > 0 && entry.first_row == next_row && entry.first_timestamp <= entry.last_timestamp &&
+                    entry.offset % ALIGNMENT == 0 && entry.offset <= header.index_offset &&
+                    entry.size <= header.index_offset - entry.offset &&
+                    valid_columns(base + entry.offset, entry.size, entry.rows, header.n_features + 2);
+            next_row += entry.rows;
+        }
+        valid = valid && next_row == header.rows;
+    }
+    if (!valid) {
+#ifdef QUANTNET_HAS_MMAP
+        ::munmap(const_cast<unsigned char*>(base), file_size);
+#endif
+        throw std::runtime_error("Not a compatible feature store: " + path);
+    }
+    num_blocks = header.blocks;
+    num_rows = header.rows;
+    num_features = header.n_features;
+    timestamps_cache.resize(num_blocks);
+}
+
+FeatureStore::~FeatureStore() {
+#ifdef QUANTNET_HAS_MMAP
+    if (base != nullptr) {
+        ::munmap(const_cast<unsigned char*>(base), file_size);
+        base = nullptr;
+    }
+#endif
+}
+
+const std::vector<int64_t>& FeatureStore::block_timestamps(const size_t block) const {
+    std::lock_guard<std::mutex> lock(timestamps_mutex);
+    std::vector<int64_t>& timestamps = timestamps_cache[block];
+    if (timestamps.empty()) {
+        timestamps.resize(index[block].rows);
+        decode_block(block, index[block].first_row, index[block].first_row + index[block].rows, nullptr, nullptr, timestamps.data());
+    }
+    return timestamps;
+}
+
+size_t FeatureStore::lower_bound(const int64_t t) const {
+    const BlockEntry* block = std::partition_point(index, index + num_blocks, [t](const BlockEntry& entry) {
+        return entry.last_timestamp < t;
+    });
+    if (block == index + num_blocks) {
+        return num_rows;
+    }
+    if (block->first_timestamp >= t) {
+        return block->first_row;
+    }
+    const std::vector<int64_t>& timestamps = block_timestamps(block - index);
+    return block->first_row + (std::lower_bound(timestamps.begin(), timestamps.end(), t) - timestamps.begin());
+}
+
+std::pair<size_t, size_t> FeatureStore::range(const int64_t t0, const int64_t t1) const {
+    const size_t first = lower_bound(t0);
+    return {first, t1 > t0 ? std::max(first, lower_bound(t1)) : first};
+}
+
+FeatureStore::Slice FeatureStore::slice(const int64_t t0, const int64_t t1, const size_t timesteps) const {
+    const auto [first, last] = range(t0, t1);
+    Slice result;
+    result.timesteps = std::max<size_t>(timesteps, 1);
+    result.history = std::min(first, result.timesteps - 1);
+    result.first_row = first - result.history;
+    result.block = load(result.first_row, last);
+    return result;
+}
+
+size_t FeatureStore::Slice::windows() const {
+    return block.rows >= timesteps ? block.rows - timesteps + 1 : 0;
+}
+
+linalg::View FeatureStore::Slice::window(const size_t w) const {
+    return block.window(w, timesteps);
+}
+
+double FeatureStore::Slice::target(const size_t w) const {
+    return block.targets.at(w + timesteps - 1);
+}
+
+void FeatureStore::decode_block(const size_t block, const size_t from, const size_t to, double* features, double* targets, int64_t* timestamps) const {
+    const BlockEntry& entry = index[block];
+    const size_t begin = std::max<size_t>(from, entry.first_row) - entry.first_row;
+    const size_t end = std::min<size_t>(to, entry.first_row + entry.rows) - entry.first_row;
+    if (begin >= end) {
+        return;
+    }
+    //Output rows of this block start at row entry.first_row + begin
+    const size_t out_row = entry.first_row + begin - from;
+
+    const unsigned char* data = base + entry.offset;
+    const ColumnEntry* columns = reinterpret_cast<const ColumnEntry*>(data);
+    const size_t num_columns = num_features + 2;
+    for (size_t c = 0; c < num_columns; c++) {
+        const ColumnEntry& column = columns[c];
+        if (c == 0) {
+            if (timestamps != nullptr) {
+                decode_timestamps(data + column.offset, column.bytes, begin, end, timestamps + out_row);
+            }
+            continue;
+        }
+        double* out = (c <= num_features) ? (features != nullptr ? features + out_row * num_features + (c - 1) : nullptr)
+                                          : (targets != nullptr ? targets + out_row : nullptr);
+        if (out == nullptr) {
+            continue;
+        }
+        const size_t stride = (c <= num_features) ? num_features : 1;
+        if (column.codec == GORILLA) {
+            decode_gorilla(data + column.offset, column.bytes, begin, end, out, stride);
+        } else {
+            const double* raw = reinterpret_cast<const double*>(data + column.offset);
+            for (size_t i = begin; i < end; i++) {
+                out[(i - begin) * stride] = raw[i];
+            }
+        }
+    }
+}
+
+void FeatureStore::decode(const size_t from, const size_t to, double* features, double* targets, int64_t* timestamps) const {
+    if (from > to || to > num_rows) {
+        throw std::out_of_range("Rows [" + std::to_string(from) + ", " + std::to_string(to) + ") are outside the feature store");
+    }
+    if (from == to) {
+        return;
+    }
+    const size_t first = std::partition_point(index, index + num_blocks, [from](const BlockEntry& entry) {
+        return entry.first_row + entry.rows <= from;
+    }) - index;
+    const size_t last = std::partition_point(index, index + num_blocks, [to](const BlockEntry& entry) {
+        return entry.first_row < to;
+    }) - index;
+    parallel::parallel_for(first, last, 1, [&](const size_t lo, const size_t hi) {
+        for (size_t b = lo; b < hi; b++) {
+            decode_block(b, from, to, features, targets, timestamps);
+        }
+    });
+}
+
+FeatureCache::Block FeatureStore::load(const size_t from, const size_t to) const {
+    const size_t end = std::min(to, num_rows);
+    FeatureCache::Block block;
+    block.rows = from < end ? end - from : 0;
+    block.n_features = num_features;
+    block.features = memory::make_buffer<double>(block.rows * block.n_features);
+    block.targets.resize(block.rows);
+    if (block.rows > 0) { //from past the end gives an empty block, as FeatureCache::load does
+        decode(from, from + block.rows, block.features.get(), block.targets.data());
+    }
+    return block;
+}
+
+FeatureStore::Benchmark FeatureStore::benchmark(const std::vector<int64_t>& timestamps, const Matrix& X, const Matrix& Y,
+                                                const std::string& directory, const Options& options, const int repeats) {
+    const std::string cache_path = directory + "/benchmark.qnfeat";
+    const std::string store_path = directory + "/benchmark.qnstore";
+    std::remove(cache_path.c_str());
+    FeatureCache::append(cache_path, X, Y);
+
+    Benchmark result;
+    result.rows = X.size();
+    auto start = std::chrono::steady_clock::now();
+    write(store_path, timestamps, X, Y, options);
+    result.compress_seconds = seconds_since(start);
+
+    const double decoded_bytes = static_cast<double>(X.size() * ((X.empty() ? 0 : X[0].size()) + 1) * sizeof(double));
+    double raw_best = 0.0;
+    double decode_best = 0.0;
+    for (int r = 0; r < std::max(repeats, 1); r++) {
+        start = std::chrono::steady_clock::now();
+        const FeatureCache::Block raw = FeatureCache::load(cache_path);
+        const double raw_seconds = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        const FeatureStore store(store_path);
+        const FeatureCache::Block decoded = store.load();
+        const double decode_seconds = seconds_since(start);
+
+        if (r == 0) {
+            result.compressed_bytes = store.bytes();
+        }
+        raw_best = (r == 0) ? raw_seconds : std::min(raw_best, raw_seconds);
+        decode_best = (r == 0) ? decode_seconds : std::min(decode_best, decode_seconds);
+    }
+
+    std::ifstream cache(cache_path, std::ios::binary | std::ios::ate);
+    result.raw_bytes = static_cast<size_t>(cache.tellg());
+    result.ratio = result.compressed_bytes > 0 ? static_cast<double>(result.raw_bytes) / result.compressed_bytes : 0.0;
+    result.raw_load_gbps = raw_best > 0.0 ? decoded_bytes / raw_best / 1e9 : 0.0;
+    result.decode_gbps = decode_best > 0.0 ? decoded_bytes / decode_best / 1e9 : 0.0;
+
+    cache.close();
+    std::remove(cache_path.c_str());
+    std::remove(store_path.c_str());
+    return result;
+}
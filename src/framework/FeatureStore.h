@@ -0,0 +1,114 @@
+#ifndef FEATURESTORE_H
+#define FEATURESTORE_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include "FeatureCache.h"
+
+/*
+ * Block-compressed columnar alternative to FeatureCache for large feature histories, memory-mapped read-only.
+ *
+ * Layout: a fixed header, the blocks, then an index of one entry per block (first row, row count, first and last
+ * timestamp, byte range) in time order. A block holds block_rows consecutive rows stored column by column:
+ * - timestamps as delta-of-delta zigzag varints, one byte per row for regularly spaced bars
+ * - each feature column and the target XOR-compressed against the previous value (Gorilla), so repeated or slowly
+ *   moving values take a few bits; a column that does not shrink is stored raw
+ * Reading a row range or a time range touches only the blocks it overlaps, found through the index, and decodes
+ * them straight into the caller's row-major buffers. Training, validation and backtests select their data by
+ * time with range() and slice() instead of parsing and slicing the whole history.
+ */
+class FeatureStore {
+public:
+    typedef std::vector<std::vector<double>> Matrix;
+
+    //Initialised in the constructor rather than in-class, so Options() can be a default argument below
+    struct Options {
+        size_t block_rows;
+        bool compress; //false stores every column raw, e.g. as a baseline
+
+        Options() : block_rows(4096), compress(true) {}
+    };
+
+    //Write rows to a new store, replacing path. Timestamps must be non-decreasing, X is (n, n_features), Y is (n, 1).
+    //block_rows, and the byte offsets inside a block, must fit the format's 32-bit fields (std::invalid_argument)
+    static void write(const std::string& path, const std::vector<int64_t>& timestamps, const Matrix& X, const Matrix& Y, const Options& options = Options());
+
+    explicit FeatureStore(const std::string& path);
+    ~FeatureStore();
+
+    FeatureStore(const FeatureStore&) = delete;
+    FeatureStore& operator=(const FeatureStore&) = delete;
+
+    size_t rows() const { return num_rows; }
+    size_t n_features() const { return num_features; }
+    size_t blocks() const { return num_blocks; }
+    size_t bytes() const { return file_size; }
+
+    //First row with a timestamp >= t, rows() if there is none. The block is found by binary search in the index,
+    //then within the block's timestamps, which are decoded on first use and kept, so lookups are O(log n)
+    size_t lower_bound(const int64_t t) const;
+
+    //Rows [first, last) with t0 <= timestamp < t1
+    std::pair<size_t, size_t> range(const int64_t t0, const int64_t t1) const;
+
+    //The rows of [t0, t1) preceded by up to timesteps - 1 rows of history, so every row in the range ends a full
+    //window (except at the very start of the store). Only the blocks overlapping those rows are decoded, and
+    //windows spanning a block boundary are views into the same contiguous buffer
+    struct Slice {
+        FeatureCache::Block block;
+        size_t first_row = 0; //Store row of block row 0
+        size_t history = 0;   //Rows before t0 at the start of block
+        size_t timesteps = 1;
+
+        size_t windows() const; //Window w covers block rows w .. w + timesteps - 1 and ends in [t0, t1)
+        linalg::View window(const size_t w) const;
+        double target(const size_t w) const; //Target of the last row of window w
+    };
+    Slice slice(const int64_t t0, const int64_t t1, const size_t timesteps = 1) const;
+
+    //Rows [from, to) into features (to - from, n_features) row-major, targets (to - from) and optionally their
+    //timestamps. Blocks are decoded in parallel. Thread-safe
+    void decode(const size_t from, const size_t to, double* features, double* targets, int64_t* timestamps = nullptr) const;
+
+    //Rows [from, to) into a FeatureCache::Block, so windows are views as with FeatureCache::load. The range is clamped
+    //to rows() like FeatureCache::load, so from past the end gives an empty block
+    FeatureCache::Block load(const size_t from = 0, const size_t to = static_cast<size_t>(-1)) const;
+
+    //Size and speed of the store against FeatureCache for the same rows
+    struct Benchmark {
+        size_t rows = 0;
+        size_t raw_bytes = 0;          //FeatureCache file
+        size_t compressed_bytes = 0;   //FeatureStore file
+        double ratio = 0.0;            //raw_bytes / compressed_bytes
+        double compress_seconds = 0.0; //FeatureStore::write
+        double raw_load_gbps = 0.0;    //FeatureCache::load, GB/s of decoded doubles
+        double decode_gbps = 0.0;      //FeatureStore::decode of every row, GB/s of decoded doubles
+    };
+    static Benchmark benchmark(const std::vector<int64_t>& timestamps, const Matrix& X, const Matrix& Y,
+                               const std::string& directory, const Options& options = Options(), const int repeats = 5);
+
+private:
+    struct BlockEntry;
+
+    void decode_block(const size_t block, const size_t from, const size_t to, double* features, double* targets, int64_t* timestamps) const;
+    const std::vector<int64_t>& block_timestamps(const size_t block) const;
+
+    const unsigned char* base = nullptr;
+    size_t file_size = 0;
+    const BlockEntry* index = nullptr;
+    size_t num_blocks = 0;
+    size_t num_rows = 0;
+    size_t num_features = 0;
+    std::vector<unsigned char> fallback; //File contents when memory mapping is unavailable
+
+    //Decoded timestamps per block, empty until the block is first searched
+    mutable std::mutex timestamps_mutex;
+    mutable std::vector<std::vector<int64_t>> timestamps_cache;
+};
+
+#endif //FEATURESTORE_H
@@ -0,0 +1,126 @@
+#include "Backtest.h"
+#include "HybridModel.h"
+#include "LSTMCell.h"
+#include "ProjectionCache.h"
+#include "activations.h"
+#include "linalg.h"
+#include "../framework/DataFramework.h"
+
+#include <vector>
+#include <string>
+#include <tuple>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Backtest {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    Matrix stream(const HybridModel& model, const Matrix& rows, const Config& config) {
+        const std::vector<std::string>& layer_types = model.layers();
+        const std::vector<HybridModel::matrixDict>& params = model.parameters();
+        if (layer_types.empty() || layer_types[0] != "LSTM") {
+            throw std::invalid_argument("Backtest needs a model that starts with an LSTM layer");
+        }
+        //LSTM layers first, then the dense head, as HybridModel::forward assumes
+        const size_t n_lstm = std::find_if(layer_types.begin(), layer_types.end(), [](const std::string& type) { return type != "LSTM"; }) - layer_types.begin();
+        if (static_cast<size_t>(std::count(layer_types.begin(), layer_types.end(), "LSTM")) != n_lstm) {
+            throw std::invalid_argument("Backtest needs every LSTM layer before the dense layers");
+        }
+        if (n_lstm > 1 && config.reset_every == 0) {
+            throw std::invalid_argument("Backtest needs reset_every for stacked LSTM layers: later layers rerun the rows "
+                                        "of the current period, which is the whole history without resets");
+        }
+        if (rows.empty()) {
+            return Matrix{};
+        }
+        const size_t n = rows.size();
+        const size_t n_a = params[0].at("Wy1")[0].size();
+
+        //Hidden state of the current LSTM layer at every row, (n, n_a)
+        Matrix hidden(n, std::vector<double>(n_a));
+        Matrix a_out;
+        for (size_t i = 1; i <= layer_types.size(); i++) {
+            const std::string layer = std::to_string(i);
+            const HybridModel::matrixDict& p = params[i-1];
+
+            if (layer_types[i-1] == "LSTM") {
+                //Every LSTM layer reads the original input, so its input projections are known for all rows up front
+                const ProjectionCache::Table projections = ProjectionCache::build(rows, {0}, n, p, static_cast<int>(i));
+                const LSTMCell::CellWeights weights = LSTMCell::cell_weights(p, static_cast<int>(i));
+
+                if (i == 1) {
+                    Matrix a = linalg::generateZeros(1, n_a);
+                    Matrix c = linalg::generateZeros(1, n_a);
+                    for (size_t r = 0; r < n; r++) {
+                        if (config.reset_every != 0 && r % config.reset_every == 0) {
+                            a = linalg::generateZeros(1, n_a);
+                            c = linalg::generateZeros(1, n_a);
+                        }
+                        const LSTMCell::GateInputs x_proj = ProjectionCache::gather(projections, r);
+                        std::tie(a, c) = LSTMCell::lstm_cell_step(Matrix{rows[r]}, a, c, weights, &x_proj);
+                        hidden[r] = a[0];
+                    }
+                } else {
+                    //predict starts a later layer from the layer below's state at the end of the window, so at row r
+                    //this layer starts from the state below at r and reruns the period's rows up to r: at most
+                    //reset_every steps per row, the cost of windowed inference for this layer
+                    const Matrix below = hidden;
+                    for (size_t r = 0; r < n; r++) {
+                        Matrix a = Matrix{below[r]};
+                        Matrix c = linalg::generateZeros(1, n_a);
+                        for (size_t t = r - r % config.reset_every; t <= r; t++) {
+                            const LSTMCell::GateInputs x_proj = ProjectionCache::gather(projections, t);
+                            std::tie(a, c) = LSTMCell::lstm_cell_step(Matrix{rows[t]}, a, c, weights, &x_proj);
+                        }
+                        hidden[r] = a[0];
+                    }
+                }
+            } else {
+                //Dense head over every row at once, same layer rules as HybridModel::forward
+                const bool after_lstm = layer_types[i-2] == "LSTM";
+                const Matrix Z = linalg::add(linalg::matmul(p.at("W"+layer), after_lstm ? linalg::T(hidden) : linalg::View(a_out)), p.at("b"+layer));
+                a_out = (layer_types[i-1] == "Relu") ? activations::relu(Z) : Z;
+            }
+        }
+        return a_out;
+    }
+
+    Comparison compare(const HybridModel& model, const Matrix& rows, const int timesteps, const Config& config) {
+        if (timesteps <= 0 || rows.size() < static_cast<size_t>(timesteps)) {
+            throw std::invalid_argument("Backtest comparison needs at least timesteps rows");
+        }
+        Comparison comparison;
+        comparison.rows = rows.size();
+
+        auto start = std::chrono::steady_clock::now();
+        const Matrix streamed = stream(model, rows, config);
+        comparison.stream_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        const Matrix windowed = model.predict(DataFramework::generate_tensor(rows, timesteps));
+        comparison.windowed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        comparison.speedup = comparison.stream_seconds > 0.0 ? comparison.windowed_seconds / comparison.stream_seconds : 0.0;
+
+        comparison.windows = windowed.empty() ? 0 : windowed[0].size();
+        double total = 0.0;
+        for (size_t w = 0; w < comparison.windows; w++) {
+            const size_t r = w + timesteps - 1;
+            const bool period_end = config.reset_every != 0 && (r + 1) % config.reset_every == 0;
+            for (size_t k = 0; k < windowed.size(); k++) {
+                const double drift = std::abs(streamed[k][r] - windowed[k][w]);
+                comparison.max_drift = std::max(comparison.max_drift, drift);
+                total += drift;
+                if (period_end) {
+                    comparison.max_period_end_drift = std::max(comparison.max_period_end_drift, drift);
+                }
+            }
+        }
+        if (comparison.windows != 0) {
+            comparison.mean_drift = total / (comparison.windows * windowed.size());
+        }
+        return comparison;
+    }
+}
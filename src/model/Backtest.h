@@ -0,0 +1,54 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include <vector>
+#include <cstddef>
+
+#include "HybridModel.h"
+
+/*
+ * Stateful full-history inference for backtests.
+ *
+ * Windowed inference (DataFramework::generate_tensor + predict) restarts every LSTM layer from a zero state at
+ * each row and runs T cell steps per row, so a history of n rows costs n * T steps. stream() instead runs the
+ * first LSTM layer over the history once, carrying (a, c) from row to row, and emits a prediction at every row from
+ * the carried state: n steps. Each layer's input projections are computed for all rows in one matrix
+ * product per gate (ProjectionCache), and the dense head runs once over the hidden states of every row.
+ *
+ * With reset_every = T the states are zeroed at rows 0, T, 2T, ..., so the prediction at the last row of each
+ * period equals the windowed prediction for the window ending there. Rows in between see a shorter history than a
+ * window would, and without resets every row sees the whole history before it. compare() measures how far the two
+ * modes drift apart for a given model and history.
+ *
+ * Stacked LSTM layers need reset_every. Windowed inference starts each later LSTM layer from the previous layer's
+ * hidden state at the end of the window, so only the first layer is carried from row to row: a later layer starts
+ * at each row from the state below it there and reruns the rows of the current period, up to reset_every steps
+ * per row. Period ends still match the windowed predictions, and the saving is confined to the first layer.
+ */
+namespace Backtest {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    struct Config {
+        size_t reset_every = 0; //Zero the LSTM states every this many rows, 0 = never (single LSTM layer only)
+    };
+
+    //Predictions at every row of rows (n, n_x), in predict's layout: column r is the prediction at row r. The model's
+    //LSTM layers must come first, followed by Relu/Linear layers, as for HybridModel::forward. Throws
+    //std::invalid_argument otherwise, and for stacked LSTM layers without reset_every
+    Matrix stream(const HybridModel& model, const Matrix& rows, const Config& config = Config());
+
+    //stream() against predict on the windows of rows, whose window w ends at row w + timesteps - 1
+    struct Comparison {
+        size_t rows = 0;
+        size_t windows = 0;
+        double stream_seconds = 0.0;
+        double windowed_seconds = 0.0; //generate_tensor and predict
+        double speedup = 0.0;          //windowed_seconds / stream_seconds
+        double max_drift = 0.0;        //Largest |stream - windowed| over all window ends and outputs
+        double mean_drift = 0.0;
+        double max_period_end_drift = 0.0; //Same over rows that end a reset period, 0 for reset_every = timesteps
+    };
+    Comparison compare(const HybridModel& model, const Matrix& rows, const int timesteps, const Config& config = Config());
+}
+
+#endif //BACKTEST_H
@@ -0,0 +1,226 @@
+#include "Ensemble.h"
+#include "HybridModel.h"
+#include "linalg.h"
+#include "numa.h"
+#include "parallel.h"
+#include "reductions.h"
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+typedef Ensemble::Matrix Matrix;
+typedef Ensemble::Tensor3D Tensor3D;
+
+namespace {
+    inline double sigmoid(const double z) {
+        return 1 / (1 + std::exp(-z));
+    }
+
+    //Same architectures HybridModel::forward handles: LSTM layers first, then Relu layers, then one Linear output
+    void check_architecture(const std::vector<std::string>& layer_types) {
+        size_t i = 0;
+        while (i < layer_types.size() && layer_types[i] == "LSTM") {
+            i++;
+        }
+        if (i == 0 || i == layer_types.size() || layer_types.back() != "Linear") {
+            throw std::invalid_argument("Ensemble needs LSTM layers followed by Relu layers and a Linear output");
+        }
+        for (; i + 1 < layer_types.size(); i++) {
+            if (layer_types[i] != "Relu") {
+                throw std::invalid_argument("Ensemble needs LSTM layers followed by Relu layers and a Linear output");
+            }
+        }
+    }
+}
+
+Ensemble::Ensemble(const std::vector<HybridModel>& models) : K(models.size()) {
+    if (models.empty()) {
+        throw std::invalid_argument("Ensemble needs at least one model");
+    }
+    const std::vector<std::string>& layer_types = models[0].layers();
+    check_architecture(layer_types);
+    for (const HybridModel& model : models) {
+        if (model.layers() != layer_types || model.dimensions() != models[0].dimensions() || model.parameters().size() != layer_types.size()) {
+            throw std::invalid_argument("Ensemble models must share the same initialized architecture");
+        }
+    }
+
+    for (size_t i = 1; i <= layer_types.size(); i++) {
+        const std::string layer = std::to_string(i);
+
+        if (layer_types[i-1] == "LSTM") {
+            LSTMLayer packed;
+            packed.n_a = models[0].parameters()[i-1].at("Wy"+layer)[0].size();
+            packed.n_x = models[0].parameters()[i-1].at("Wf"+layer)[0].size() - packed.n_a;
+            const size_t n_a = packed.n_a, n_x = packed.n_x;
+            packed.Wx = linalg::generateZeros(K * 4 * n_a, n_x);
+
+            for (size_t k = 0; k < K; k++) {
+                const HybridModel::matrixDict& params = models[k].parameters()[i-1];
+                const Matrix* gates[4] = {&params.at("Wf"+layer), &params.at("Wi"+layer), &params.at("Wc"+layer), &params.at("Wo"+layer)};
+                if (gates[0]->size() != n_a || (*gates[0])[0].size() != n_a + n_x) {
+                    throw std::invalid_argument("Ensemble models must have identically shaped weights");
+                }
+
+                //Gate weights are (n_a, n_a + n_x) over the concatenation [a_prev, x_t], split into both halves
+                Matrix Wa(4 * n_a, std::vector<double>(n_a));
+                for (size_t g = 0; g < 4; g++) {
+                    for (size_t j = 0; j < n_a; j++) {
+                        const std::vector<double>& row = (*gates[g])[j];
+                        std::copy(row.begin(), row.begin() + n_a, Wa[g * n_a + j].begin());
+                        std::copy(row.begin() + n_a, row.end(), packed.Wx[(k * 4 + g) * n_a + j].begin());
+                    }
+                }
+                packed.Wa.push_back(std::move(Wa));
+
+                Matrix bias(4, std::vector<double>(n_a));
+                const std::string names[4] = {"bf", "bi", "bc", "bo"};
+                for (size_t g = 0; g < 4; g++) {
+                    const Matrix& b = params.at(names[g]+layer);
+                    for (size_t j = 0; j < n_a; j++) {
+                        bias[g][j] = b[j][0];
+                    }
+                }
+                packed.bias.push_back(std::move(bias));
+            }
+            lstm_layers.push_back(std::move(packed));
+
+        } else {
+            DenseLayer packed;
+            packed.relu = layer_types[i-1] == "Relu";
+            for (size_t k = 0; k < K; k++) {
+                packed.W.push_back(models[k].parameters()[i-1].at("W"+layer));
+                packed.b.push_back(models[k].parameters()[i-1].at("b"+layer));
+            }
+            dense_layers.push_back(std::move(packed));
+        }
+    }
+
+    if (dense_layers.back().W[0].size() != 1) {
+        throw std::invalid_argument("Ensemble supports single-output models only");
+    }
+}
+
+Matrix Ensemble::predict_all(const Tensor3D& x) const {
+    const size_t m = x.size(), timesteps = x[0].size(), n_x = x[0][0].size();
+    if (n_x != lstm_layers[0].n_x) {
+        throw std::invalid_argument("Ensemble input has " + std::to_string(n_x) + " features, models expect " + std::to_string(lstm_layers[0].n_x));
+    }
+
+    //Every LSTM layer of HybridModel reads the original input, so the timestep slices are built once
+    std::vector<Matrix> x_t(timesteps, Matrix(m, std::vector<double>(n_x)));
+    for (size_t i = 0; i < m; i++) {
+        for (size_t t = 0; t < timesteps; t++) {
+            x_t[t][i] = x[i][t];
+        }
+    }
+
+    //Hidden state per model, the first layer starts from zeros and later layers from the previous layer's last state
+    std::vector<Matrix> a(K, linalg::generateZeros(m, lstm_layers[0].n_a));
+
+    for (const LSTMLayer& layer : lstm_layers) {
+        const size_t n_a = layer.n_a;
+        std::vector<Matrix> c(K, linalg::generateZeros(m, n_a));
+
+        for (size_t t = 0; t < timesteps; t++) {
+            //Input projection of every model and gate at once, (m, K * 4 * n_a)
+            const Matrix G = linalg::matmul(x_t[t], linalg::T(layer.Wx));
+
+            //Grouped recurrent products and the fused gate/state update, one model per chunk. The recurrent product
+            //goes to the worker's node-local arena instead of a fresh matrix per model and timestep
+            parallel::parallel_for(0, K, 1, [&](const size_t lo, const size_t hi) {
+                numa::Arena& arena = numa::local_arena();
+                const size_t gates = 4 * n_a;
+                for (size_t k = lo; k < hi; k++) {
+                    //a[k] * Wa[k]^T, (m, 4 * n_a) row-major, summed in matmul's order so the result is unchanged
+                    double* H = arena.allocate(m * gates);
+                    for (size_t s = 0; s < m; s++) {
+                        const double* a_row = a[k][s].data();
+                        for (size_t r = 0; r < gates; r++) {
+                            const double* w_row = layer.Wa[k][r].data();
+                            double sum = 0.0;
+                            for (size_t v = 0; v < n_a; v++) {
+                                sum += a_row[v] * w_row[v];
+                            }
+                            H[s * gates + r] = sum;
+                        }
+                    }
+                    const Matrix& bias = layer.bias[k];
+                    const size_t base = k * gates;
+
+                    for (size_t s = 0; s < m; s++) {
+                        const std::vector<double>& g = G[s];
+                        const double* h = H + s * gates;
+                        std::vector<double>& c_s = c[k][s];
+                        std::vector<double>& a_s = a[k][s];
+                        for (size_t j = 0; j < n_a; j++) {
+                            const double forget_gate = sigmoid(g[base + j] + h[j] + bias[0][j]);
+                            const double update_gate = sigmoid(g[base + n_a + j] + h[n_a + j] + bias[1][j]);
+                            const double candidate = std::tanh(g[base + 2 * n_a + j] + h[2 * n_a + j] + bias[2][j]);
+                            const double output_gate = sigmoid(g[base + 3 * n_a + j] + h[3 * n_a + j] + bias[3][j]);
+
+                            c_s[j] = update_gate * candidate + forget_gate * c_s[j];
+                            a_s[j] = output_gate * std::tanh(c_s[j]);
+                        }
+                    }
+                    arena.reset();
+                }
+            });
+        }
+    }
+
+    //Dense stack per model, the last layer writes its (1, m) output straight into row k
+    Matrix predictions(K);
+    parallel::parallel_for(0, K, 1, [&](const size_t lo, const size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            Matrix Z = linalg::add(linalg::matmul(dense_layers[0].W[k], linalg::T(a[k])), dense_layers[0].b[k]);
+            for (size_t l = 0; ; l++) {
+                if (dense_layers[l].relu) {
+                    for (std::vector<double>& row : Z) {
+                        for (double& value : row) {
+                            value = std::max(0.0, value);
+                        }
+                    }
+                }
+                if (l + 1 == dense_layers.size()) {
+                    break;
+                }
+                Z = linalg::add(linalg::matmul(dense_layers[l+1].W[k], Z), dense_layers[l+1].b[k]);
+            }
+            predictions[k] = std::move(Z[0]);
+        }
+    });
+
+    return predictions;
+}
+
+Matrix Ensemble::predict(const Tensor3D& x, const Aggregate aggregate) const {
+    const Matrix predictions = predict_all(x);
+    const size_t m = predictions[0].size();
+    Matrix result(1, std::vector<double>(m));
+
+    parallel::parallel_for(0, m, 1024, [&](const size_t lo, const size_t hi) {
+        std::vector<double> column(K);
+        for (size_t s = lo; s < hi; s++) {
+            if (aggregate == Aggregate::Mean) {
+                result[0][s] = reductions::pairwiseSum(K, [&](const size_t k) { return predictions[k][s]; }) / K;
+                continue;
+            }
+            for (size_t k = 0; k < K; k++) {
+                column[k] = predictions[k][s];
+            }
+            const size_t mid = K / 2;
+            std::nth_element(column.begin(), column.begin() + mid, column.end());
+            double median = column[mid];
+            if (K % 2 == 0) {
+                median = (median + *std::max_element(column.begin(), column.begin() + mid)) / 2;
+            }
+            result[0][s] = median;
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,57 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <vector>
+#include <string>
+
+#include "HybridModel.h"
+
+/*
+ * Batched inference for K HybridModels with identical architecture.
+ *
+ * Running K small models one at a time leaves every GEMM tiny. The ensemble packs the models' weights once:
+ * the input-side LSTM gate weights of all K models are stacked into one matrix, so each timestep projects the
+ * shared input x_t for every model and gate with a single (m, n_x) x (n_x, K * 4 * n_a) GEMM. The recurrent and
+ * dense products, which have a different input per model, run as one grouped pass over the K models in parallel.
+ * The final layer writes straight into a (K, m) stack that is reduced to the ensemble prediction column by column.
+ *
+ * Supported architectures are those HybridModel::predict runs: one or more LSTM layers followed by Relu layers
+ * and a final single-output Linear layer.
+ */
+class Ensemble {
+public:
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    enum class Aggregate { Mean, Median };
+
+    //Copies and packs the weights, the models are not referenced afterwards
+    explicit Ensemble(const std::vector<HybridModel>& models);
+
+    size_t size() const { return K; }
+
+    //Row k holds model k's predictions, shape (K, m). Thread-safe
+    Matrix predict_all(const Tensor3D& x) const;
+    //Aggregated ensemble prediction, shape (1, m). Thread-safe
+    Matrix predict(const Tensor3D& x, const Aggregate aggregate = Aggregate::Mean) const;
+
+private:
+    struct LSTMLayer {
+        size_t n_a = 0, n_x = 0;
+        Matrix Wx;                 //(K * 4 * n_a, n_x): forget, update, candidate and output gate input weights of every model
+        std::vector<Matrix> Wa;    //Per model (4 * n_a, n_a): the same gates' recurrent weights
+        std::vector<Matrix> bias;  //Per model (4, n_a): bf, bi, bc, bo
+    };
+
+    struct DenseLayer {
+        bool relu = true;
+        std::vector<Matrix> W;
+        std::vector<Matrix> b;
+    };
+
+    size_t K = 0;
+    std::vector<LSTMLayer> lstm_layers;
+    std::vector<DenseLayer> dense_layers;
+};
+
+#endif //ENSEMBLE_H
@@ -0,0 +1,118 @@
+#include "FineTune.h"
+#include "HybridModel.h"
+#include "parallel.h"
+#include "../framework/DataFramework.h"
+#include "../framework/FeatureCache.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <variant>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+
+namespace FineTune {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    namespace {
+        constexpr char MAGIC[8] = {'Q', 'N', 'T', 'U', 'N', 'E', '0', '1'};
+    }
+
+    void save(const std::string& path, const HybridModel& model, const size_t trained_rows) {
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + temporary + " for writing");
+            }
+            const uint64_t rows = trained_rows;
+            file.write(MAGIC, sizeof(MAGIC));
+            file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+            model.save_checkpoint(file);
+            file.flush();
+            if (!file.good()) {
+                throw std::runtime_error("Failed writing checkpoint " + temporary);
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Could not replace checkpoint " + path);
+        }
+    }
+
+    size_t load(const std::string& path, HybridModel& model) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open checkpoint " + path);
+        }
+        char magic[sizeof(MAGIC)];
+        uint64_t rows = 0;
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            !file.read(reinterpret_cast<char*>(&rows), sizeof(rows))) {
+            throw std::runtime_error("Not a fine-tuning checkpoint: " + path);
+        }
+        model.load_checkpoint(file);
+        return rows;
+    }
+
+    Result run(const Job& job, const Config& config) {
+        if (config.timesteps <= 0 || config.epochs <= 0 || config.batch_size <= 0) {
+            throw std::invalid_argument("Fine-tuning timesteps, epochs and batch_size must be positive");
+        }
+        Result result;
+        HybridModel model;
+        const size_t trained_rows = load(job.checkpoint, model);
+        if (model.layers().empty()) {
+            throw std::runtime_error("Checkpoint " + job.checkpoint + " holds no model");
+        }
+        const size_t total_rows = FeatureCache::rows(job.cache);
+        const size_t T = config.timesteps;
+
+        result.new_rows = total_rows > trained_rows ? total_rows - trained_rows : 0;
+        //The first window to train ends on the first new row, earlier rows are only read as its history
+        const size_t first = trained_rows >= T - 1 ? trained_rows - (T - 1) : 0;
+        if (result.new_rows == 0 || total_rows - first < T) {
+            result.completed = true; //Nothing to train on yet, the rows are picked up by a later run
+            return result;
+        }
+
+        auto [x_features, Y] = FeatureCache::read(job.cache, first, total_rows);
+        auto X = std::make_shared<const HybridModel::variantTensor>(DataFramework::generate_tensor(x_features, T));
+        const Tensor3D& windows = std::get<Tensor3D>(*X);
+        result.windows = windows.size();
+        Y.resize(windows.size()); //Window i is paired with row i, as in preprocessDataFromFile
+        auto targets = std::make_shared<const Matrix>(std::move(Y));
+
+        model.init_data(X, targets, config.batch_size);
+        if (config.learning_rate > 0) {
+            model.init_learning_rate(config.learning_rate);
+        }
+
+        for (int epoch = 0; epoch < config.epochs; epoch++) {
+            model.train_epoch(windows, *targets, config.seed + epoch);
+        }
+        result.loss = model.return_avg_loss();
+
+        save(job.output.empty() ? job.checkpoint : job.output, model, total_rows);
+        result.completed = true;
+        return result;
+    }
+
+    std::vector<Result> run_all(const std::vector<Job>& jobs, const Config& config) {
+        std::vector<Result> results(jobs.size());
+        parallel::parallel_for(0, jobs.size(), 1, [&](const size_t lo, const size_t hi) {
+            for (size_t k = lo; k < hi; k++) {
+                try {
+                    results[k] = run(jobs[k], config);
+                } catch (const std::exception& e) {
+                    results[k].error = e.what();
+                }
+            }
+        });
+        return results;
+    }
+}
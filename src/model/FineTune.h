@@ -0,0 +1,50 @@
+#ifndef FINETUNE_H
+#define FINETUNE_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include "HybridModel.h"
+
+/*
+ * Warm-start fine-tuning of trained models on newly appended bars.
+ *
+ * A fine-tuning checkpoint is a HybridModel checkpoint (parameters, Adam moments and step count) together with
+ * the number of feature cache rows the model has been trained on. A nightly run loads it, reads only the rows
+ * appended since then plus the timesteps - 1 rows before them from the FeatureCache, and trains on the windows
+ * that contain at least one new row. Optimization resumes exactly where the last run stopped, so there is no
+ * retraining from initialize_network. Jobs are independent and run concurrently on parallel::pool().
+ */
+namespace FineTune {
+    struct Config {
+        int timesteps = 30;
+        int epochs = 1;
+        int batch_size = 32;
+        int seed = 10;              //Minibatch shuffling seed of the first epoch
+        double learning_rate = 0.0; //0 keeps the checkpoint's learning rate
+    };
+
+    struct Job {
+        std::string checkpoint; //Fine-tuning checkpoint to resume from
+        std::string cache;      //FeatureCache of this model's series
+        std::string output;     //Where the updated checkpoint goes, empty = replace the input checkpoint
+    };
+
+    struct Result {
+        bool completed = false;
+        std::string error;      //Set when the job failed, its checkpoint is left untouched
+        size_t new_rows = 0;    //Rows appended since the checkpoint
+        size_t windows = 0;     //Training windows containing new rows
+        double loss = 0.0;      //HybridModel::return_avg_loss after training
+    };
+
+    //Checkpoint I/O. save writes to a temporary file and renames it, so a crash never leaves a partial checkpoint
+    void save(const std::string& path, const HybridModel& model, const size_t trained_rows);
+    size_t load(const std::string& path, HybridModel& model); //Returns the trained row count
+
+    Result run(const Job& job, const Config& config);
+    std::vector<Result> run_all(const std::vector<Job>& jobs, const Config& config);
+}
+
+#endif //FINETUNE_H
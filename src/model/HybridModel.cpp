@@ -1,569 +1,668 @@
 #include "HybridModel.h"
 #include "MLP.h"
 #include "LSTMNetwork.h"
+#include "LSTMCell.h"
+#include "ProjectionCache.h"
 #include "activations.h"
 
 #include <cmath>
 #include <vector>
 #include <map>
-#include <random>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <tuple>
 
 #include "linalg.h"
+#include "expressions.h"
+#include "reductions.h"
+#include "rng.h"
+
+typedef HybridModel::Matrix Matrix;
+typedef HybridModel::Tensor3D Tensor3D;
+typedef HybridModel::variantTensor variantTensor;
+typedef HybridModel::matrixDict matrixDict;
+typedef HybridModel::minibatch minibatch;
+
+//Checkpoint serialization: native-endian binary, strings and matrices are length-prefixed
+namespace {
+    constexpr char CHECKPOINT_MAGIC[8] = {'Q', 'N', 'C', 'K', 'P', 'T', '0', '1'};
+    constexpr uint32_t CHECKPOINT_VERSION = 2; //2: the candidate gate reads Wc, version 1 models computed it from Wi
+
+    template <typename T>
+    void write_value(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
 
-namespace HybridModel {
-    typedef std::vector<std::vector<double>> Matrix;
-    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
-    typedef std::variant<Matrix, Tensor3D> variantTensor;
-    typedef std::map<std::string, Matrix> matrixDict; //Global params
-    typedef std::vector<matrixDict> MLPCache; //cache for forward prop
-    typedef std::tuple<Tensor3D, Matrix> minibatch;
-
-    //LSTM
-    typedef std::tuple<Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, matrixDict> cacheTuple;
-    typedef std::tuple<Tensor3D, Tensor3D, Tensor3D, std::tuple<std::vector<cacheTuple>, Tensor3D>> LSTMCache;
-
-    //Backprop
-    //Variant since it can be either a Tensor3D gradient with timesteps or Matrix gradients
-    typedef std::map<std::string, variantTensor> gradientDict;
+    template <typename T>
+    T read_value(std::istream& in) {
+        T value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        return value;
+    }
 
-    //Unified cache structure
-    struct UnifiedCache {
-        std::vector<std::variant<LSTMCache, matrixDict>> cache;
-    };
+    void write_string(std::ostream& out, const std::string& value) {
+        write_value<uint32_t>(out, value.size());
+        out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
 
-    //Unified gradient structure
-    struct UnifiedGradients {
-        std::vector<std::variant<gradientDict, matrixDict>> grads;
-    };
+    std::string read_string(std::istream& in) {
+        std::string value(read_value<uint32_t>(in), '\0');
+        if (!in.read(value.data(), static_cast<std::streamsize>(value.size()))) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        return value;
+    }
 
-    //Anonymous namespace for private variables
-    namespace {
-        // Global model parameters
-        std::vector<std::string> layer_types = {};
-        std::vector<int> layer_dims = {};
-        std::vector<matrixDict> layer_params;
-        double learning_rate;
-
-        //Forward prop variables
-        UnifiedCache cache;
-        Matrix finalPrediction; //Linear output matrix, shape(m,1)
-
-        //Loss
-        double accumulated_loss = 0.0;
-
-        //Data, x_train and y_train. NOTE: x_train and y_train have to be generated by minibatches
-        variantTensor x_train;
-        Matrix y_train = {{}}; //shape (m,1)
-        int BATCH_SIZE;
-        int n_hidden; //Number of LSTM units.
-
-        //Backprop variables
-        UnifiedGradients grads;
-
-        //Adam optimizer variables
-        std::vector<std::vector<matrixDict>> Adam_params; //2D to store v and s
-        int t = 0;
-        const double beta1 = 0.9;
-        const double beta2 = 0.999;
-        const double epsilon = 1e-8;
-    }
-
-    // Minibatch generation
-    std::vector<minibatch> generate_minibatches(const Tensor3D& X, const Matrix& Y, const int batch_size, const int seed) {
-        //Training examples
-        size_t m = X.size();
-
-        // Generate permutations for each index
-        std::vector<int> permutation(m);
-        for (int i = 0; i < m; i++) {
-            permutation[i] = i;
+    void write_dict(std::ostream& out, const matrixDict& dict) {
+        write_value<uint32_t>(out, dict.size());
+        for (const auto& [name, matrix] : dict) {
+            write_string(out, name);
+            write_value<uint32_t>(out, matrix.size());
+            write_value<uint32_t>(out, matrix.empty() ? 0 : matrix[0].size());
+            for (const std::vector<double>& row : matrix) {
+                out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(double)));
+            }
         }
-        std::mt19937 perm(seed);
-        std::shuffle(permutation.begin(), permutation.end(), perm);
-
-        // Shuffle the dataset using the permutations
-        Tensor3D shuffled_X(m, Matrix(X[0].size(), std::vector<double>(X[0][0].size())));
-        Matrix shuffled_Y(m, std::vector<double>(1));
-        for (size_t i = 0; i < m; i++) {
-            shuffled_X[i] = X[permutation[i]];
-            shuffled_Y[i] = Y[permutation[i]];
+    }
+
+    matrixDict read_dict(std::istream& in) {
+        matrixDict dict;
+        const uint32_t count = read_value<uint32_t>(in);
+        for (uint32_t k = 0; k < count; k++) {
+            const std::string name = read_string(in);
+            const uint32_t rows = read_value<uint32_t>(in);
+            const uint32_t cols = read_value<uint32_t>(in);
+            Matrix matrix(rows, std::vector<double>(cols));
+            for (std::vector<double>& row : matrix) {
+                if (!in.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(cols * sizeof(double)))) {
+                    throw std::runtime_error("Truncated checkpoint");
+                }
+            }
+            dict.emplace(name, std::move(matrix));
         }
+        return dict;
+    }
+}
 
-        std::vector<minibatch> minibatches;
-        for (size_t k = 0; k < m; k += batch_size) {
-            int end = std::min(k + batch_size, m);
+// Minibatch generation
+std::vector<minibatch> HybridModel::generate_minibatches(const Tensor3D& X, const Matrix& Y, const int batch_size, const int seed) {
+    //Training examples
+    size_t m = X.size();
 
-            // Correctly allocate batch size
-            Tensor3D minibatch_X(end-k, Matrix(X[0].size(), std::vector<double>(X[0][0].size())));
-            Matrix minibatch_Y(end-k, std::vector<double>(1));
+    // Generate permutations for each index (same order on every platform, unlike std::shuffle)
+    const std::vector<int> permutation = rng::permutation(static_cast<int>(m), seed);
 
-            for (int i = k; i < end; i++) {
-                minibatch_X[i - k] = shuffled_X[i];
-                minibatch_Y[i - k] = shuffled_Y[i];
-            }
+    // Shuffle the dataset using the permutations
+    Tensor3D shuffled_X(m, Matrix(X[0].size(), std::vector<double>(X[0][0].size())));
+    Matrix shuffled_Y(m, std::vector<double>(1));
+    for (size_t i = 0; i < m; i++) {
+        shuffled_X[i] = X[permutation[i]];
+        shuffled_Y[i] = Y[permutation[i]];
+    }
 
-            minibatches.emplace_back(std::move(minibatch_X), std::move(minibatch_Y));
+    std::vector<minibatch> minibatches;
+    for (size_t k = 0; k < m; k += batch_size) {
+        int end = std::min(k + batch_size, m);
+
+        // Correctly allocate batch size
+        Tensor3D minibatch_X(end-k, Matrix(X[0].size(), std::vector<double>(X[0][0].size())));
+        Matrix minibatch_Y(end-k, std::vector<double>(1));
+
+        for (int i = k; i < end; i++) {
+            minibatch_X[i - k] = shuffled_X[i];
+            minibatch_Y[i - k] = shuffled_Y[i];
         }
 
-        return minibatches;
+        minibatches.emplace_back(std::move(minibatch_X), std::move(minibatch_Y));
     }
 
+    return minibatches;
+}
 
-    // MSE loss function
-    double MSE(const std::vector<double>& pred, const std::vector<double>& target) {
-        if (pred.size() != target.size()) {
-            throw std::invalid_argument("Prediction and target sizes do not match");
-        }
 
-        double loss = 0.0;
-        for (size_t i = 0; i < pred.size(); i++) {
-            loss += std::pow(pred[i] - target[i], 2);
-        }
-        return loss/(2*pred.size());
+// MSE loss function
+double HybridModel::MSE(const std::vector<double>& pred, const std::vector<double>& target) {
+    if (pred.size() != target.size()) {
+        throw std::invalid_argument("Prediction and target sizes do not match");
     }
 
-    //Inputting X and Y datasets:
-    void init_data(const variantTensor& X, const Matrix& Y, const int batch_size) {
-        x_train = X;
-        y_train = Y;
-        BATCH_SIZE = batch_size;
-    }
+    const double loss = reductions::pairwiseSum(pred.size(), [&](const size_t i) {
+        const double error = pred[i] - target[i];
+        return error * error;
+    });
+    return loss/(2*pred.size());
+}
 
-    //Layer types and dimensions (setters)
-    void init_layers(const std::vector<std::string>& layer_type, const std::vector<int>& layer_dim) {
-        layer_types = layer_type;
-        layer_dims = layer_dim;
-    }
+//Inputting X and Y datasets:
+void HybridModel::init_data(std::shared_ptr<const variantTensor> X, std::shared_ptr<const Matrix> Y, const int batch_size) {
+    x_train = std::move(X);
+    y_train = std::move(Y);
+    BATCH_SIZE = batch_size;
+}
 
-    // Initialization of the number of LSTM Cells/Units:
-    void init_hidden_units(const int numUnits) {
-        n_hidden = numUnits;
-    }
+void HybridModel::init_data(const variantTensor& X, const Matrix& Y, const int batch_size) {
+    x_train = std::make_shared<const variantTensor>(X);
+    y_train = std::make_shared<const Matrix>(Y);
+    BATCH_SIZE = batch_size;
+}
 
-    // Initialization of the learning rate
-    void init_learning_rate(const double lr = 3e-4) {
-        learning_rate = lr;
-    }
+//Layer types and dimensions (setters)
+void HybridModel::init_layers(const std::vector<std::string>& layer_type, const std::vector<int>& layer_dim) {
+    layer_types = layer_type;
+    layer_dims = layer_dim;
+}
 
-    //LSTM/MLP Network initialization
-    void initialize_network() {
-        std::cout << "initialize_network - n_hidden: " << n_hidden << std::endl;
-        //NOTE: layer_type and layer_dims should have the same shape
-        for (int i = 1; i <= layer_types.size(); i++) {
-            matrixDict current_params;
-            std::cout << "Layer " << i << ": " << layer_types[i-1] << std::endl;
+// Initialization of the number of LSTM Cells/Units:
+void HybridModel::init_hidden_units(const int numUnits) {
+    n_hidden = numUnits;
+}
 
-            if (layer_types[i-1] == "LSTM") {
-                if (std::holds_alternative<Tensor3D>(x_train)) {
-                    Tensor3D x = std::get<Tensor3D>(x_train);
-                    int n_input = (i == 1) ? x[0][0].size() : layer_dims[i-2]; //Input features : output layers
-                    current_params = LSTMNetwork::init_params(n_input, n_hidden, layer_dims[i-1], i);
-                    std::cout << "LSTM init successful" << std::endl;
-                } else {
-                    std::cout << "Requires Tensor3D input for init" << std::endl;
-                    linalg::printMatrix(std::get<Matrix>(x_train));
-                }
-            } else if (layer_types[i-1] == "Relu" || layer_types[i-1] == "Linear") {
-                current_params = MLP::init_mlp_params(layer_dims, i-1);
-                std::cout << "MLP init successful" << std::endl;
+// Initialization of the learning rate
+void HybridModel::init_learning_rate(const double lr) {
+    learning_rate = lr;
+}
+
+//LSTM/MLP Network initialization
+void HybridModel::initialize_network() {
+    initialize_network(rng::next_model_id());
+}
+
+void HybridModel::initialize_network(const uint64_t init_seed) {
+    const uint64_t seed = rng::derive_seed(rng::seed(), init_seed);
+    std::cout << "initialize_network - n_hidden: " << n_hidden << std::endl;
+    //NOTE: layer_type and layer_dims should have the same shape
+    for (int i = 1; i <= layer_types.size(); i++) {
+        matrixDict current_params;
+        std::cout << "Layer " << i << ": " << layer_types[i-1] << std::endl;
+
+        if (layer_types[i-1] == "LSTM") {
+            if (std::holds_alternative<Tensor3D>(*x_train)) {
+                const Tensor3D& x = std::get<Tensor3D>(*x_train);
+                int n_input = (i == 1) ? x[0][0].size() : layer_dims[i-2]; //Input features : output layers
+                current_params = LSTMNetwork::init_params(n_input, n_hidden, layer_dims[i-1], i, seed);
+                std::cout << "LSTM init successful" << std::endl;
+            } else {
+                std::cout << "Requires Tensor3D input for init" << std::endl;
+                linalg::printMatrix(std::get<Matrix>(*x_train));
             }
-            layer_params.push_back(current_params);
+        } else if (layer_types[i-1] == "Relu" || layer_types[i-1] == "Linear") {
+            current_params = MLP::init_mlp_params(layer_dims, i-1, seed);
+            std::cout << "MLP init successful" << std::endl;
         }
+        layer_params.push_back(current_params);
     }
+}
 
-    //Tensor3D --> Matrix conversion based on last timestep output
-    Matrix reshape_last_timestep(const Tensor3D& hidden_state) {
-        int batch_size = hidden_state.size();
-        int hidden_units = hidden_state[0][0].size();
-        Matrix reshaped_matrix(batch_size, std::vector<double>(hidden_units));
-
-        // Extract the last timestep for each example in the batch
-        for (int i = 0; i < batch_size; ++i) {
-            if (hidden_state[i].empty()) {
-                throw std::invalid_argument("Hidden state is empty");
-            }
+//Tensor3D --> Matrix conversion based on last timestep output
+Matrix HybridModel::reshape_last_timestep(const Tensor3D& hidden_state) const {
+    int batch_size = hidden_state.size();
+    int hidden_units = hidden_state[0][0].size();
+    Matrix reshaped_matrix(batch_size, std::vector<double>(hidden_units));
 
-            reshaped_matrix[i] = hidden_state[i].back();  // return the last timestep in the sequence
+    // Extract the last timestep for each example in the batch
+    for (int i = 0; i < batch_size; ++i) {
+        if (hidden_state[i].empty()) {
+            throw std::invalid_argument("Hidden state is empty");
         }
-        return reshaped_matrix;
-    }
 
-    //Matrix --> Tensor3D conversion with number of timesteps initialized in x_train
-    Tensor3D reshape_last_timestep(const Matrix& hidden_state) {
-        int batch_size = hidden_state.size();
-        int hidden_units = hidden_state[0].size();
-        const int TIMESTEPS = std::get<Tensor3D>(x_train)[0].size();
-        Tensor3D reshaped_tensor(batch_size, Matrix(TIMESTEPS, std::vector<double>(hidden_units, 0.0)));
+        reshaped_matrix[i] = hidden_state[i].back();  // return the last timestep in the sequence
+    }
+    return reshaped_matrix;
+}
 
-        // Reshape:
-        for (int i = 0; i < batch_size; i++) {
-            for (int t = 0; t < TIMESTEPS; t++) {
-                reshaped_tensor[i][t] = hidden_state[i];
-            }
+//Matrix --> Tensor3D conversion with number of timesteps initialized in x_train
+Tensor3D HybridModel::reshape_last_timestep(const Matrix& hidden_state) const {
+    int batch_size = hidden_state.size();
+    int hidden_units = hidden_state[0].size();
+    const int TIMESTEPS = std::get<Tensor3D>(*x_train)[0].size();
+    Tensor3D reshaped_tensor(batch_size, Matrix(TIMESTEPS, std::vector<double>(hidden_units, 0.0)));
+
+    // Reshape:
+    for (int i = 0; i < batch_size; i++) {
+        for (int t = 0; t < TIMESTEPS; t++) {
+            reshaped_tensor[i][t] = hidden_state[i];
         }
+    }
 
-        return reshaped_tensor;
-    }
-
-        void forward_prop(std::variant<Tensor3D, Matrix> x_train) {
-        /*
-        NOTE: Right now, function assumes that the first inputs are LSTMs and last inputs are MLP.
-              - e.g: Relu->Relu->LSTM->LSTM is not supported, because LSTMs are placed last
-              - e.g: LSTM->LSTM->Relu->Linear is supported, because LSTMs are placed before MLP in the network
-              Architectures that are "mixed" is not supported
-              - e.g: LSTM->Relu->LSTM->Linear
-         */
-        Matrix Wy = layer_params[0]["Wy1"];
-        int n_a = Wy[0].size();
-        std::cout << "HybridModel::forward_prop - n_a (derived from Wy[0].size()): " << n_a << std::endl; // Print n_a
-
-        //MLP
-        Matrix a_out;
-        bool first_mlp_encountered = false;
-
-        //LSTM
-        Matrix a_initial = linalg::generateZeros(std::get<Tensor3D>(x_train).size(), n_a); //Initially, a0 is a Matrix of zeros with shape (m, n_a)
-        //std::cout << "Shape of a_initial BEFORE lstm_forward: " << linalg::shape(a_initial) << std::endl;
-        Tensor3D new_x_state;
-        Tensor3D new_hidden_state;
-
-        std::cout << "Forward prop initialization successful" << std::endl;
-
-        for (int i = 1; i <= layer_types.size(); i++) {
-            std::cout << "Layer " << i << ": " << layer_types[i-1] << std::endl;
-            if (layer_types[i-1] == "LSTM") {
-                if (i == 1) {
-                    //Initialize parameters in the function and forward prop through the network once
-                    LSTMCache current_lstm_tuple = LSTMNetwork::lstm_forward(std::get<Tensor3D>(x_train), a_initial, layer_params[i-1], i);
-                    new_x_state = std::get<1>(std::get<3>(current_lstm_tuple));
-                    new_hidden_state = std::get<0>(current_lstm_tuple);
-                    
-                    if (cache.cache.size() == layer_types.size()) { //Replacing (current iteration != 1st iteration)
-                        cache.cache[i] = current_lstm_tuple;
-                    } else { //First iteration
-                        cache.cache.push_back(current_lstm_tuple);
-                    }
+    return reshaped_tensor;
+}
 
-                    std::cout << "LSTM forward, layer 1 --> successful" << std::endl;
-                } else {
-                    LSTMCache current_lstm_tuple = LSTMNetwork::lstm_forward(new_x_state, reshape_last_timestep(new_hidden_state), layer_params[i-1], i);
-                    new_x_state = std::get<1>(std::get<3>(current_lstm_tuple));
-                    new_hidden_state = std::get<0>(current_lstm_tuple);
+void HybridModel::forward_prop(const std::variant<Tensor3D, Matrix>& x_train) {
+    //Training pass: keeps every layer's cache for back_prop
+    finalPrediction = forward(x_train, &cache);
+}
 
-                    if (cache.cache.size() == layer_types.size()) { 
-                        cache.cache[i] = current_lstm_tuple;
-                    } else {
-                        cache.cache.push_back(current_lstm_tuple);
-                    }
+void HybridModel::forward_prop(const Tensor3D& x_batch, const ProjectionCache::Table& projections) {
+    if (layer_types.empty() || layer_types[0] != "LSTM") {
+        throw std::logic_error("Input projections need an LSTM first layer");
+    }
+    finalPrediction = forward(x_batch, &cache, &projections);
+}
 
-                    std::cout << "LSTM forward, all other layers successful" << std::endl;
-                }
-            } else if (layer_types[i-1] == "Relu") {
-                // Reshape a_out using the last timestepped hidden state from LSTM_forward
-                if (layer_types[i-2] == "LSTM" && i != 1) {
-                    a_out = reshape_last_timestep(new_hidden_state);
-                    first_mlp_encountered = true;
-                } else {
-                    first_mlp_encountered = false;
-                }
+HybridModel::Matrix HybridModel::predict(const Tensor3D& x) const {
+    //Inference pass: only reads the parameters, so any number of threads may call it on the same model
+    return forward(x, nullptr);
+}
 
-                if (i == 1) {
-                    //Input x is a Matrix
-                    std::tuple<Matrix, matrixDict> current_dense_tuple = MLP::Dense(std::get<Matrix>(x_train), layer_params[i-1], activations::relu, i, first_mlp_encountered);
-                    a_out = std::get<0>(current_dense_tuple);
-                    matrixDict current_mlp_cache = std::get<1>(current_dense_tuple);
+HybridModel::Matrix HybridModel::forward(const std::variant<Tensor3D, Matrix>& x_train, UnifiedCache* layer_cache, const ProjectionCache::Table* projections) const {
+    /*
+    NOTE: Right now, function assumes that the first inputs are LSTMs and last inputs are MLP.
+          - e.g: Relu->Relu->LSTM->LSTM is not supported, because LSTMs are placed last
+          - e.g: LSTM->LSTM->Relu->Linear is supported, because LSTMs are placed before MLP in the network
+          Architectures that are "mixed" is not supported
+          - e.g: LSTM->Relu->LSTM->Linear
+     */
+    const Matrix& Wy = layer_params[0].at("Wy1");
+    int n_a = Wy[0].size();
+
+    //MLP
+    Matrix a_out;
+    bool first_mlp_encountered = false;
 
-                    if (cache.cache.size() == layer_types.size()) {
-                        cache.cache[i] = current_mlp_cache;
-                    } else {
-                        cache.cache.push_back(current_mlp_cache);
-                    }
+    //LSTM
+    Matrix a_initial = linalg::generateZeros(std::get<Tensor3D>(x_train).size(), n_a); //Initially, a0 is a Matrix of zeros with shape (m, n_a)
+    Tensor3D new_x_state;
+    Tensor3D new_hidden_state;
+    Matrix last_hidden; //Last timestep of the latest LSTM layer, (m, n_a)
+    std::vector<Matrix> x_t; //Timestep slices of the input, (m, n_x) each, built once for the cache-free pass
+
+    //Store the cache of layer i (1-indexed) when training, replacing the previous batch's entry
+    auto store = [&](const int i, std::variant<LSTMCache, matrixDict> layer_entry) {
+        if (layer_cache == nullptr) {
+            return;
+        }
+        if (layer_cache->cache.size() == layer_types.size()) { //Replacing (current iteration != 1st iteration)
+            layer_cache->cache[i-1] = std::move(layer_entry);
+        } else { //First iteration
+            layer_cache->cache.push_back(std::move(layer_entry));
+        }
+    };
 
-                } else {
-                    std::tuple<Matrix, matrixDict> current_dense_tuple = MLP::Dense(a_out, layer_params[i-1], activations::relu, i, first_mlp_encountered);
-                    a_out = std::get<0>(current_dense_tuple);
-                    matrixDict current_mlp_cache = std::get<1>(current_dense_tuple);
-                    
-                    if (cache.cache.size() == layer_types.size()) {
-                        cache.cache[i] = current_mlp_cache;
-                    } else {
-                        cache.cache.push_back(current_mlp_cache);
+    for (int i = 1; i <= layer_types.size(); i++) {
+        if (layer_types[i-1] == "LSTM") {
+            //The first layer starts from a zero hidden state, later layers from the last timestep of the previous one
+            if (layer_cache == nullptr) {
+                //Inference only needs the running state: step the cell over the timesteps without building the
+                //per-timestep sequences and backprop cache of lstm_forward. Every LSTM layer reads the original input
+                const Tensor3D& x = std::get<Tensor3D>(x_train);
+                if (x_t.empty()) {
+                    x_t.assign(x[0].size(), Matrix(x.size()));
+                    for (size_t s = 0; s < x.size(); s++) {
+                        for (size_t t = 0; t < x_t.size(); t++) {
+                            x_t[t][s] = x[s][t];
+                        }
                     }
                 }
-            } else if (layer_types[i-1] == "Linear") {
-                // Reshape a_out using the last timestepped hidden state from LSTM_forward
-                if (layer_types[i-1] == "LSTM" && i != 1) {
-                    a_out = reshape_last_timestep(new_hidden_state);
-                    first_mlp_encountered = true;
-                } else {
-                    first_mlp_encountered = false;
+                const LSTMCell::CellWeights weights = LSTMCell::cell_weights(layer_params[i-1], i);
+                Matrix a = (i == 1) ? a_initial : last_hidden;
+                Matrix c = linalg::generateZeros(a.size(), a[0].size());
+                for (size_t t = 0; t < x_t.size(); t++) {
+                    LSTMCell::GateInputs x_proj;
+                    const bool projected = i == 1 && projections != nullptr;
+                    if (projected) {
+                        x_proj = ProjectionCache::gather(*projections, t);
+                    }
+                    std::tie(a, c) = LSTMCell::lstm_cell_step(x_t[t], a, c, weights, projected ? &x_proj : nullptr);
                 }
+                last_hidden = std::move(a);
+                continue;
+            }
 
-                std::tuple<Matrix, matrixDict> current_dense_tuple = MLP::Dense(a_out, layer_params[i-1], activations::linear, i, first_mlp_encountered);
-                a_out = std::get<0>(current_dense_tuple);
-                matrixDict current_mlp_cache = std::get<1>(current_dense_tuple);
-                
-                if (cache.cache.size() == layer_types.size()) {
-                    cache.cache[i] = current_mlp_cache;
-                } else {
-                    cache.cache.push_back(current_mlp_cache);
-                }
+            LSTMCache current_lstm_tuple = (i == 1)
+                ? LSTMNetwork::lstm_forward(std::get<Tensor3D>(x_train), a_initial, layer_params[i-1], i, projections)
+                : LSTMNetwork::lstm_forward(new_x_state, last_hidden, layer_params[i-1], i);
+            new_x_state = std::get<1>(std::get<3>(current_lstm_tuple));
+            new_hidden_state = std::get<0>(current_lstm_tuple);
+            last_hidden = reshape_last_timestep(new_hidden_state);
+            store(i, std::move(current_lstm_tuple));
+
+        } else if (layer_types[i-1] == "Relu") {
+            // Reshape a_out using the last timestepped hidden state from LSTM_forward
+            if (i != 1 && layer_types[i-2] == "LSTM") {
+                a_out = last_hidden;
+                first_mlp_encountered = true;
+            } else {
+                first_mlp_encountered = false;
             }
+
+            //Input x is a Matrix for the first layer
+            std::tuple<Matrix, matrixDict> current_dense_tuple = MLP::Dense((i == 1) ? std::get<Matrix>(x_train) : a_out, layer_params[i-1], activations::relu, i, first_mlp_encountered);
+            a_out = std::get<0>(current_dense_tuple);
+            store(i, std::move(std::get<1>(current_dense_tuple)));
+
+        } else if (layer_types[i-1] == "Linear") {
+            // Reshape a_out using the last timestepped hidden state from LSTM_forward
+            if (i != 1 && layer_types[i-2] == "LSTM") {
+                a_out = last_hidden;
+                first_mlp_encountered = true;
+            } else {
+                first_mlp_encountered = false;
+            }
+
+            std::tuple<Matrix, matrixDict> current_dense_tuple = MLP::Dense(a_out, layer_params[i-1], activations::linear, i, first_mlp_encountered);
+            a_out = std::get<0>(current_dense_tuple);
+            store(i, std::move(std::get<1>(current_dense_tuple)));
         }
-        //Set the final prediction matrix
-        finalPrediction = a_out;
     }
+    //The final prediction matrix
+    return a_out;
+}
 
-    void loss(Matrix y_train) {
-        //Automatic transposition to correct shape
-        if (finalPrediction.size() == 1 && finalPrediction[0].size() == BATCH_SIZE) {
-            finalPrediction = linalg::transpose(finalPrediction);
-        }
-        if (y_train.size() == 1 && y_train[0].size() == BATCH_SIZE) {
-            y_train = linalg::transpose(y_train);
-        }
+void HybridModel::loss(const Matrix& y_train) {
+    //Automatic transposition to correct shape, (1, m) rows are read through transposed views.
+    //m is this batch's sample count, the last minibatch is shorter than BATCH_SIZE when it does not divide the data
+    const size_t m = y_train.size() == 1 ? y_train[0].size() : y_train.size();
+    const bool prediction_is_row = finalPrediction.size() == 1 && finalPrediction[0].size() == m;
+    const bool target_is_row = y_train.size() == 1 && y_train[0].size() == m;
+
+    //Reshape predictions and targets
+    std::vector<double> predictions = linalg::reshape(prediction_is_row ? linalg::T(finalPrediction) : linalg::View(finalPrediction));
+    std::vector<double> targets = linalg::reshape(target_is_row ? linalg::T(y_train) : linalg::View(y_train));
+
+    //predictions and current y_train are of the same mini-batch:
+    accumulated_loss.add(MSE(predictions, targets));
+
+    //d(MSE)/d(prediction) in finalPrediction's layout, where back_prop starts. Both vectors follow its row-major order
+    const size_t cols = finalPrediction[0].size();
+    output_gradient.assign(finalPrediction.size(), std::vector<double>(cols));
+    for (size_t k = 0; k < predictions.size(); k++) {
+        output_gradient[k / cols][k % cols] = (predictions[k] - targets[k]) / predictions.size();
+    }
+    //std::cout << "Loss: " << accumulated_loss << std::endl;
+}
 
-        //Reshape predictions and targets
-        std::vector<double> predictions = linalg::reshape(finalPrediction);
-        std::vector<double> targets = linalg::reshape(y_train);
+double HybridModel::return_avg_loss() {
+    return accumulated_loss.value() / (std::holds_alternative<Tensor3D>(*x_train) ? std::get<Tensor3D>(*x_train).size() : std::get<Matrix>(*x_train).size());
+}
 
-        std::cout << predictions.size() << std::endl;
-        std::cout << targets.size() << std::endl;
+void HybridModel::back_prop() {
+    //Walks the layers of the last forward_prop from the output down, starting from loss()'s gradient of the output.
+    //Layer i's gradients are stored in grads.grads[i-1], the layout optimize reads
+    const int L = layer_types.size(); //num of layers
+    grads.grads.resize(L);
 
-        //predictions and current y_train are of the same mini-batch (BATCH_SIZE = 64):
-        accumulated_loss += MSE(predictions, targets);
-        //std::cout << "Loss: " << accumulated_loss << std::endl;
-    }
+    // Derivatives
+    Matrix dA_matrix = output_gradient; //Gradient of the current dense layer's output, (n_out, m)
+    Matrix da_last;                     //Gradient of the current LSTM layer's last hidden state, (m, n_a)
 
-    double return_avg_loss() {
-        return accumulated_loss / (std::holds_alternative<Tensor3D>(x_train) ? std::get<Tensor3D>(x_train).size() : std::get<Matrix>(x_train).size());
-    }
+    for (int layer = L; layer >= 1; layer--) {
+        const std::string l = std::to_string(layer);
+
+        if (layer_types[layer-1] == "LSTM") {
+            const LSTMCache& lstm_cache = std::get<LSTMCache>(cache.cache[layer-1]);
+            const Tensor3D& hidden_state = std::get<0>(lstm_cache);
+            if (layer == L) {
+                throw std::logic_error("back_prop needs a dense output layer after the LSTM layers");
+            }
+
+            //Dense layers read only the last timestep of the hidden state, the next LSTM layer only starts from it.
+            //A dense layer's (n_a, m) gradient is read through a transposed view
+            const linalg::View da = (layer_types[layer] != "LSTM") ? linalg::T(dA_matrix) : linalg::View(da_last);
+            Tensor3D dA_tensor = linalg::generateZeros(hidden_state.size(), hidden_state[0].size(), hidden_state[0][0].size());
+            for (size_t i = 0; i < dA_tensor.size(); i++) {
+                std::vector<double>& last = dA_tensor[i].back();
+                for (size_t j = 0; j < last.size(); j++) {
+                    last[j] = da.at(i, j);
+                }
+            }
 
-    void back_prop() {
-        gradientDict gradients;
-        const int L = layer_types.size(); //num of layers
-        const int m = std::get<Tensor3D>(x_train).size();
-        Matrix a_in_matrix = reshape_last_timestep(std::get<Tensor3D>(x_train));
+            gradientDict current_lstm_grads = LSTMNetwork::lstm_backprop(dA_tensor, std::get<3>(lstm_cache), layer);
 
-        // Derivatives
-        Matrix dA_matrix;
-        //if (std::holds_alternative<matrixDict>(cache.cache[L-1])) {
-            //Access the cache at L
-        std::cerr << "DEBUG: back_prop - Layer " << L << " cache variant index: " << cache.cache.size() << std::endl; // Print variant index
-        matrixDict& layer_cache = std::get<matrixDict>(cache.cache[L-1]);
+            //The layer's initial state is the last hidden state of the LSTM layer below. Its input x is the
+            //network's input for every LSTM layer, so dx is not propagated
+            da_last = std::get<Matrix>(current_lstm_grads["da0"+l]);
+            grads.grads[layer-1] = std::move(current_lstm_grads);
 
-        // Check if the key exists
-        auto item = layer_cache.find("A"+std::to_string(L-1));
-        if (item != layer_cache.end()) {
-            dA_matrix = item -> second;
+        } else if (layer_types[layer-1] == "Relu" || layer_types[layer-1] == "Linear") {
+            if (layer == 1) {
+                throw std::logic_error("back_prop needs an LSTM first layer");
+            }
+
+            //Input of the layer as Dense multiplied it, (n_in, m): the transposed last timestep of an LSTM layer below,
+            //otherwise the dense layer below's activations
+            const bool after_lstm = layer_types[layer-2] == "LSTM";
+            const Matrix last_hidden = after_lstm ? reshape_last_timestep(std::get<0>(std::get<LSTMCache>(cache.cache[layer-2]))) : Matrix();
+            const linalg::View a_in = after_lstm
+                ? linalg::T(last_hidden)
+                : linalg::View(std::get<matrixDict>(cache.cache[layer-2]).at("A"+std::to_string(layer-1)));
+
+            //Compute gradients
+            matrixDict current_mlp_grads = MLP::mlp_backward(
+                a_in, dA_matrix,
+                std::get<matrixDict>(cache.cache[layer-1]), layer,
+                (layer_types[layer-1] == "Relu") ? activations::relu_prime : activations::linear_prime); //Ternary operator between Relu and Linear
+
+            dA_matrix = current_mlp_grads["dA"+l];
+            grads.grads[layer-1] = std::move(current_mlp_grads);
         }
+    }
+}
 
-        dA_matrix = linalg::division(linalg::subtract(dA_matrix, y_train), m); //Init gradient for the last layer (derivative of loss function)
-        //}
-        Tensor3D dA_tensor; //To store reshaped LSTM gradients
+void HybridModel::init_Adam() {
+    Adam_params.resize(layer_types.size()); // Initialize Adam_params size
+
+    for (int i = 1; i <= layer_types.size(); i++) {
+        matrixDict v; //Momentum
+        matrixDict s; //Root Mean Square Propagation (RMSP)
+        //std::cout << "Layer " << i << ": " << layer_types[i-1] << std::endl;
+
+        if (layer_types[i-1] == "LSTM") {
+            // Forget gates
+            v["dWf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)][0].size()));
+            v["dbf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)][0].size()));
+            s["dWf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)][0].size()));
+            s["dbf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)][0].size()));
+
+            // Update (input) gates
+            v["dWi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)][0].size()));
+            v["dbi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)][0].size()));
+            s["dWi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)][0].size()));
+            s["dbi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)][0].size()));
+
+            // Candidate/memory cells
+            v["dWc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)][0].size()));
+            v["dbc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)][0].size()));
+            s["dWc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)][0].size()));
+            s["dbc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)][0].size()));
+
+            //Output gates
+            v["dWo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)][0].size()));
+            v["dbo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)][0].size()));
+            s["dWo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)][0].size()));
+            s["dbo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)][0].size()));
+
+            //Predictions
+            v["dWy"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)][0].size()));
+            v["dby"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["by"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["by"+std::to_string(i)][0].size()));
+            s["dWy"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)][0].size()));
+            s["dby"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["by"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["by"+std::to_string(i)][0].size()));
+
+        } else if (layer_types[i-1] == "Relu" || layer_types[i-1] == "Linear") {
+            v["dW"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["W"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["W"+std::to_string(i)][0].size()));
+            v["db"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["b"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["b"+std::to_string(i)][0].size()));
+            s["dW"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["W"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["W"+std::to_string(i)][0].size()));
+            s["db"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["b"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["b"+std::to_string(i)][0].size()));
+        }
+        Adam_params[i-1] = {v, s};
+    }
+    std::cout << "Adam parameter initialization successful" << std::endl;
+}
 
-        for (int layer = L; layer >= 1; layer--) {
-            if (layer_types[layer-1] == "LSTM") {
-                if (layer == L) {
-                    continue; //Skip, assume last layer is always a linear/MLP output
-                }
+//Adam update of a single parameter. Each of v, s and the parameter is written in place by one fused expression
+void HybridModel::adam_update(Matrix& param, Matrix& v, Matrix& s, const Matrix& grad) {
+    using linalg::expr::lazy;
+    const double v_correction = 1 - std::pow(beta1, t);
+    const double s_correction = 1 - std::pow(beta2, t);
 
-                //Reshape from Matrix to Tensor3D if last backpropagated layer wasn't LSTM with Tensor3D
-                if (layer_types[layer-1] == "Relu" || layer_types[layer-1] == "Linear") {
-                    dA_tensor = reshape_last_timestep(dA_matrix);
-                }
+    // Momentum with beta1, RMSProp with beta2
+    linalg::eval_into(v, beta1 * lazy(v) + (1-beta1) * lazy(grad));
+    linalg::eval_into(s, beta2 * lazy(s) + (1-beta2) * lazy(grad) * lazy(grad));
 
-                if (std::holds_alternative<LSTMCache>(cache.cache[layer])) { //Check for correct type
-                    //Get the current LSTM cache
-                    LSTMCache lstm_cache = std::get<LSTMCache>(cache.cache[layer]);
-                    gradientDict current_lstm_grads = LSTMNetwork::lstm_backprop(
-                        dA_tensor,
-                        std::make_tuple(
-                            std::get<0>(std::get<3>(lstm_cache)),  // Extracts the vector<cacheTuple>
-                            std::get<1>(std::get<3>(lstm_cache))   // Extracts the Tensor3D
-                        ),
-                        layer
-                    );
-
-                    // Update the new activation derivative
-                    dA_tensor = std::get<Tensor3D>(current_lstm_grads["da0"+std::to_string(layer)]);
-
-                    //Store gradients
-                    if (grads.grads.size() == layer_types.size()) {
-                        grads.grads[layer] = current_lstm_grads;
-                    } else {
-                        grads.grads.push_back(current_lstm_grads);
-                    }
-                    
-                }
+    // Update in place with the bias-corrected moments
+    linalg::eval_into(param, lazy(param) - learning_rate * (lazy(v) / v_correction) / (linalg::expr::sqrt(lazy(s) / s_correction) + epsilon));
+}
 
-            } else if (layer_types[layer-1] == "Relu" || layer_types[layer-1] == "Linear") {
-                if (layer == L) {
-                    continue;
-                }
-                // Reshape dA to a matrix using the last timestepped hidden state from LSTM gradients
-                if (layer_types[layer-1] == "LSTM") {
-                    dA_matrix = reshape_last_timestep(dA_tensor);
-                }
+void HybridModel::optimize() {
+    t += 1; //Adam steps are counted from 1 so the bias corrections are never zero
 
-                //Compute gradients
-                matrixDict current_mlp_grads = MLP::mlp_backward(
-                    a_in_matrix, dA_matrix, y_train,
-                    std::get<matrixDict>(cache.cache[layer-1]), layer,
-                    (layer_types[layer-1] == "Relu") ? activations::relu : activations::linear); //Ternary operator between Relu and Linear
-
-                //Store gradients
-                if (grads.grads.size() == layer_types.size()) {
-                    grads.grads[layer] = current_mlp_grads;
-                } else {
-                    grads.grads.push_back(current_mlp_grads);
-                }
+    for (int l = 1; l <= layer_types.size(); l++) {
+        matrixDict& v = Adam_params[l-1][0];
+        matrixDict& s = Adam_params[l-1][1];
+
+        if (layer_types[l-1] == "LSTM") {
+            auto& grad_map = std::get<gradientDict>(grads.grads[l-1]);
+            for (const char* name : {"Wf", "bf", "Wi", "bi", "Wc", "bc", "Wo", "bo", "Wy", "by"}) {
+                const std::string key = std::string(name) + std::to_string(l);
+                adam_update(layer_params[l-1][key], v["d"+key], s["d"+key], std::get<Matrix>(grad_map["d"+key]));
+            }
+        } else if (layer_types[l-1] == "Relu" || layer_types[l-1] == "Linear") {
+            auto& grad_map = std::get<matrixDict>(grads.grads[l-1]);
+            for (const char* name : {"W", "b"}) {
+                const std::string key = std::string(name) + std::to_string(l);
+                adam_update(layer_params[l-1][key], v["d"+key], s["d"+key], grad_map["d"+key]);
             }
         }
     }
+}
+
+void HybridModel::train_epoch(const Tensor3D& X, const Matrix& Y, const int seed) {
+    accumulated_loss.reset(); //return_avg_loss() reports this epoch only
+    for (const auto& [X_batch, Y_batch] : generate_minibatches(X, Y, BATCH_SIZE, seed)) {
+        forward_prop(X_batch);
+        loss(Y_batch);
+        back_prop();
+        optimize();
+    }
+}
 
-    void init_Adam() {
-        Adam_params.resize(layer_types.size()); // Initialize Adam_params size
-    
-        for (int i = 1; i <= layer_types.size(); i++) {
-            matrixDict v; //Momentum
-            matrixDict s; //Root Mean Square Propagation (RMSP)
-            //std::cout << "Layer " << i << ": " << layer_types[i-1] << std::endl;
-
-            if (layer_types[i-1] == "LSTM") {
-                // Forget gates
-                v["dWf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)][0].size()));
-                v["dbf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)][0].size()));
-                s["dWf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wf"+std::to_string(i)][0].size()));
-                s["dbf"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bf"+std::to_string(i)][0].size()));
-
-                // Update (input) gates
-                v["dWi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)][0].size()));
-                v["dbi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)][0].size()));
-                s["dWi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wi"+std::to_string(i)][0].size()));
-                s["dbi"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bi"+std::to_string(i)][0].size()));
-
-                // Candidate/memory cells
-                v["dWc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)][0].size()));
-                v["dbc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)][0].size()));
-                s["dWc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wc"+std::to_string(i)][0].size()));
-                s["dbc"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bc"+std::to_string(i)][0].size()));
-
-                //Output gates
-                v["dWo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)][0].size()));
-                v["dbo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)][0].size()));
-                s["dWo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wo"+std::to_string(i)][0].size()));
-                s["dbo"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["bo"+std::to_string(i)][0].size()));
-
-                //Predictions
-                v["dWy"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)][0].size()));
-                v["dby"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["by"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["by"+std::to_string(i)][0].size()));
-                s["dWy"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["Wy"+std::to_string(i)][0].size()));
-                s["dby"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["by"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["by"+std::to_string(i)][0].size()));
-
-            } else if (layer_types[i-1] == "Relu" || layer_types[i-1] == "Linear") {
-                v["dW"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["W"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["W"+std::to_string(i)][0].size()));
-                v["db"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["b"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["b"+std::to_string(i)][0].size()));
-                s["dW"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["W"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["W"+std::to_string(i)][0].size()));
-                s["db"+std::to_string(i)] = linalg::generateZeros(static_cast<int>(layer_params[i-1]["b"+std::to_string(i)].size()), static_cast<int>(layer_params[i-1]["b"+std::to_string(i)][0].size()));
+void HybridModel::train_epoch(const Matrix& rows, const Matrix& Y, const int timesteps, const int seed) {
+    accumulated_loss.reset();
+    if (timesteps <= 0 || rows.size() < static_cast<size_t>(timesteps)) {
+        return;
+    }
+    const size_t T = timesteps;
+    const size_t windows = rows.size() - T + 1;
+    if (Y.size() < windows) {
+        throw std::invalid_argument("train_epoch needs a target for each of the " + std::to_string(windows) + " windows, got " + std::to_string(Y.size()));
+    }
+    const size_t batch_size = BATCH_SIZE > 0 ? BATCH_SIZE : windows;
+    const size_t num_batches = (windows + batch_size - 1) / batch_size;
+
+    for (const int b : rng::permutation(static_cast<int>(num_batches), seed)) {
+        const size_t first = b * batch_size;
+        const size_t last = std::min(windows, first + batch_size);
+
+        std::vector<size_t> starts(last - first);
+        Tensor3D X_batch(last - first, Matrix(T));
+        Matrix Y_batch(last - first);
+        for (size_t k = 0; k < starts.size(); k++) {
+            starts[k] = first + k;
+            for (size_t t = 0; t < T; t++) {
+                X_batch[k][t] = rows[first + k + t]; //Still needed by the backprop caches
             }
-            Adam_params[i-1] = {v, s};
+            Y_batch[k] = Y[first + k];
         }
-        std::cout << "Adam parameter initialization successful" << std::endl;
-    }
-
-    void optimize() {
-        for (int l = 1; l <= layer_types.size(); l++) {
-            matrixDict v = Adam_params[l][0];
-            matrixDict s = Adam_params[l][1];
-            matrixDict v_corrected = {};
-            matrixDict s_corrected = {};
-
-            if (layer_types[l-1] == "LSTM") {
-                // Calculate momentums with beta1
-                auto& grad_map = std::get<gradientDict>(grads.grads[l-1]);
-                v["dWf"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dWf"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dWf"+std::to_string(l+1)])));
-                v["dbf"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dbf"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dbf"+std::to_string(l+1)])));
-                v["dWi"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dWi"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dWi"+std::to_string(l+1)])));
-                v["dbi"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dbi"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dbi"+std::to_string(l+1)])));
-                v["dWc"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dWc"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dWc"+std::to_string(l+1)])));
-                v["dbc"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dbc"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dbc"+std::to_string(l+1)])));
-                v["dWo"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dWo"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dWo"+std::to_string(l+1)])));
-                v["dbo"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dbo"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dbo"+std::to_string(l+1)])));
-                v["dWy"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dWy"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dWy"+std::to_string(l+1)])));
-                v["dby"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dby"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dby"+std::to_string(l+1)])));
-
-                // Calculate corrected v values:
-                v_corrected["dWf"+std::to_string(l+1)] = linalg::division(v["dWf"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dbf"+std::to_string(l+1)] = linalg::division(v["dbf"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dWi"+std::to_string(l+1)] = linalg::division(v["dWi"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dbi"+std::to_string(l+1)] = linalg::division(v["dbi"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dWc"+std::to_string(l+1)] = linalg::division(v["dWc"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dbc"+std::to_string(l+1)] = linalg::division(v["dbc"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dWo"+std::to_string(l+1)] = linalg::division(v["dWo"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dbo"+std::to_string(l+1)] = linalg::division(v["dbo"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dWy"+std::to_string(l+1)] = linalg::division(v["dWy"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["dby"+std::to_string(l+1)] = linalg::division(v["dby"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-
-                // Calculate the RMSProps with beta2
-                s["dWf"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dWf"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dWf"+std::to_string(l+1)]), 2.0)));
-                s["dbf"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dbf"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dbf"+std::to_string(l+1)]), 2.0)));
-                s["dWi"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dWi"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dWi"+std::to_string(l+1)]), 2.0)));
-                s["dbi"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dbi"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dbi"+std::to_string(l+1)]), 2.0)));
-                s["dWc"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dWc"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dWc"+std::to_string(l+1)]), 2.0)));
-                s["dbc"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dbc"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dbc"+std::to_string(l+1)]), 2.0)));
-                s["dWo"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dWo"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dWo"+std::to_string(l+1)]), 2.0)));
-                s["dbo"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dbo"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dbo"+std::to_string(l+1)]), 2.0)));
-                s["dWy"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dWy"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dWy"+std::to_string(l+1)]), 2.0)));
-                s["dby"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dby"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dby"+std::to_string(l+1)]), 2.0)));
-
-                // Calculate corrected s values:
-                s_corrected["dWf"+std::to_string(l+1)] = linalg::division(s["dWf"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dbf"+std::to_string(l+1)] = linalg::division(s["dbf"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dWi"+std::to_string(l+1)] = linalg::division(s["dWi"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dbi"+std::to_string(l+1)] = linalg::division(s["dbi"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dWc"+std::to_string(l+1)] = linalg::division(s["dWc"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dbc"+std::to_string(l+1)] = linalg::division(s["dbc"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dWo"+std::to_string(l+1)] = linalg::division(s["dWo"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dbo"+std::to_string(l+1)] = linalg::division(s["dbo"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dWy"+std::to_string(l+1)] = linalg::division(s["dWy"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["dby"+std::to_string(l+1)] = linalg::division(s["dby"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-
-                // Update parameters
-                layer_params[l-1]["Wf"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["Wf"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dWf"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dWf"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["bf"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["bf"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dbf"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dbf"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["Wi"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["Wi"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dWi"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dWi"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["bi"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["bi"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dbi"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dbi"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["Wc"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["Wc"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dWc"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dWc"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["bc"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["bc"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dbc"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dbc"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["Wo"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["Wo"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dWo"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dWo"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["bo"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["bo"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dbo"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dbo"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["Wy"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["Wy"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dWy"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dWy"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["by"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["by"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dby"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dby"+std::to_string(l+1)]), epsilon)));
-            
-            } else if (layer_types[l-1] == "Relu" || layer_types[l-1] == "Linear") {
-                // Calculate momentums with beta1
-                auto& grad_map = std::get<gradientDict>(grads.grads[l-1]);
-                v["dW"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["dW"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["dW"+std::to_string(l+1)])));
-                v["db"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta1, v["db"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta1), std::get<Matrix>(grad_map["db"+std::to_string(l+1)])));
-
-                // Calculate corrected v values:
-                v_corrected["dW"+std::to_string(l+1)] = linalg::division(v["dW"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-                v_corrected["db"+std::to_string(l+1)] = linalg::division(v["db"+std::to_string(l+1)], (1-std::pow(beta1, t)));
-
-                // Calculate the RMSProps with beta2
-                s["dW"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["dW"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["dW"+std::to_string(l+1)]), 2.0)));
-                s["db"+std::to_string(l+1)] = linalg::add(linalg::scalarMultiply(beta2, s["db"+std::to_string(l+1)]), linalg::scalarMultiply((1-beta2), linalg::pow(std::get<Matrix>(grad_map["db"+std::to_string(l+1)]), 2.0)));
-
-                // Calculate corrected s values:
-                s_corrected["dW"+std::to_string(l+1)] = linalg::division(s["dW"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-                s_corrected["db"+std::to_string(l+1)] = linalg::division(s["db"+std::to_string(l+1)], (1-std::pow(beta2, t)));
-
-                // Update parameters
-                layer_params[l-1]["W"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["W"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["dW"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["dW"+std::to_string(l+1)]), epsilon)));
-                layer_params[l-1]["b"+std::to_string(l+1)] = linalg::subtract(layer_params[l-1]["b"+std::to_string(l+1)], linalg::division(linalg::scalarMultiply(learning_rate, v_corrected["db"+std::to_string(l+1)]), linalg::add(linalg::sqrt(s_corrected["db"+std::to_string(l+1)]), epsilon)));
-            }
+
+        //The parameters change with every step, so the projections are rebuilt per batch
+        const ProjectionCache::Table projections = ProjectionCache::build(rows, starts, T, layer_params[0], 1);
+        forward_prop(X_batch, projections);
+        loss(Y_batch);
+        back_prop();
+        optimize();
+    }
+}
+
+void HybridModel::save_checkpoint(std::ostream& out) const {
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    write_value<uint32_t>(out, CHECKPOINT_VERSION);
+    write_value<uint32_t>(out, layer_types.size());
+    write_value<int32_t>(out, n_hidden);
+    write_value<double>(out, learning_rate);
+    write_value<int64_t>(out, t);
+    for (const std::string& type : layer_types) {
+        write_string(out, type);
+    }
+    write_value<uint32_t>(out, layer_dims.size());
+    for (const int dim : layer_dims) {
+        write_value<int32_t>(out, dim);
+    }
+
+    //Moments are only present once init_Adam has run
+    const bool has_adam = Adam_params.size() == layer_types.size();
+    write_value<uint8_t>(out, has_adam);
+    for (size_t l = 0; l < layer_types.size(); l++) {
+        write_dict(out, layer_params.at(l));
+        if (has_adam) {
+            write_dict(out, Adam_params[l][0]);
+            write_dict(out, Adam_params[l][1]);
+        }
+    }
+    if (!out.good()) {
+        throw std::runtime_error("Failed writing checkpoint");
+    }
+}
+
+void HybridModel::load_checkpoint(std::istream& in) {
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a compatible checkpoint");
+    }
+    const uint32_t version = read_value<uint32_t>(in);
+    if (version != CHECKPOINT_VERSION) {
+        throw std::runtime_error("Checkpoint version " + std::to_string(version) + " is not supported (expected " +
+                                 std::to_string(CHECKPOINT_VERSION) + "), version 1 predates the separate candidate gate weights");
+    }
+    const uint32_t num_layers = read_value<uint32_t>(in);
+    n_hidden = read_value<int32_t>(in);
+    learning_rate = read_value<double>(in);
+    t = static_cast<int>(read_value<int64_t>(in));
+
+    layer_types.clear();
+    for (uint32_t l = 0; l < num_layers; l++) {
+        layer_types.push_back(read_string(in));
+    }
+    layer_dims.assign(read_value<uint32_t>(in), 0);
+    for (int& dim : layer_dims) {
+        dim = read_value<int32_t>(in);
+    }
+
+    const bool has_adam = read_value<uint8_t>(in) != 0;
+    layer_params.clear();
+    Adam_params.clear();
+    for (uint32_t l = 0; l < num_layers; l++) {
+        layer_params.push_back(read_dict(in));
+        if (has_adam) {
+            matrixDict v = read_dict(in);
+            Adam_params.push_back({std::move(v), read_dict(in)});
         }
-        t += 1;
     }
+
+    //Caches and gradients belong to the previous run, they are rebuilt by the next training step
+    cache.cache.clear();
+    grads.grads.clear();
+    accumulated_loss.reset();
+}
+
+void HybridModel::save_checkpoint(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+    save_checkpoint(file);
+}
+
+void HybridModel::load_checkpoint(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open checkpoint " + path);
+    }
+    load_checkpoint(file);
 }
@@ -2,26 +2,136 @@
 #define HYBRIDMODEL_H
 
 #include <vector>
+#include <map>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
 
-namespace HybridModel {
+#include "reductions.h"
+
+namespace ProjectionCache {
+    struct Table;
+}
+
+//A single LSTM/MLP network with its own parameters, caches and optimizer state. Separate instances share nothing,
+//so several models can be trained concurrently on different threads. Training methods mutate the instance and
+//must not overlap on one model; const methods (predict, parameters) may be called from any number of threads
+//at once as long as no training step runs on that model at the same time
+class HybridModel {
+public:
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+    typedef std::variant<Matrix, Tensor3D> variantTensor;
+    typedef std::map<std::string, Matrix> matrixDict; //Global params
     typedef std::tuple<Tensor3D, Matrix> minibatch;
 
-    std::vector<minibatch> generate_minibatches(const Tensor3D& X, const Matrix& Y, int batch_size, int seed);
-    double MSE(const std::vector<double>& pred, const std::vector<double>& target);
+    static std::vector<minibatch> generate_minibatches(const Tensor3D& X, const Matrix& Y, int batch_size, int seed);
+    static double MSE(const std::vector<double>& pred, const std::vector<double>& target);
+
     void init_data(const std::variant<Matrix, Tensor3D>& X, const Matrix& Y, const int batch_size);
+    //Share one read-only dataset between many models instead of copying it into each
+    void init_data(std::shared_ptr<const variantTensor> X, std::shared_ptr<const Matrix> Y, const int batch_size);
     void init_layers(const std::vector<std::string>& layer_type, const std::vector<int>& layer_dim);
     void init_hidden_units(const int numUnits);
-    void init_learning_rate(const double lr);
+    void init_learning_rate(const double lr = 3e-4);
+    //Weights are drawn under rng::derive_seed(rng::seed(), init_seed): equal init_seeds give identical weights,
+    //different ones independent weights. Without one, each call takes the next rng::next_model_id(), so models
+    //initialised one after another differ; callers that initialise models concurrently pass their own ids
     void initialize_network();
-    Matrix reshape_last_timestep(const Tensor3D& hidden_state);
-    void forward_prop(std::variant<Tensor3D, Matrix> x_train); //x_train = x_batch
-    void loss(Matrix y_train); //y_train = y_batch
+    void initialize_network(const uint64_t init_seed);
+    Matrix reshape_last_timestep(const Tensor3D& hidden_state) const;
+    void forward_prop(const std::variant<Tensor3D, Matrix>& x_train); //x_train = x_batch
+    //Training pass whose first LSTM layer takes its input projections from a table built for x_batch's windows
+    void forward_prop(const Tensor3D& x_batch, const ProjectionCache::Table& projections);
+    void loss(const Matrix& y_train); //y_train = y_batch
     double return_avg_loss();
     void back_prop();
     void init_Adam();
     void optimize();
-}
+
+    //One pass over (X, Y) in shuffled minibatches: forward_prop, loss, back_prop and optimize per batch. Both
+    //overloads restart the accumulated loss, so return_avg_loss() afterwards is the loss of that epoch alone
+    void train_epoch(const Tensor3D& X, const Matrix& Y, const int seed);
+    //One pass over the windows of `rows` (window k covers rows k .. k + timesteps - 1 and is paired with Y[k]) in
+    //contiguous minibatches, whose order is shuffled by seed. Neighbouring windows of a batch share rows, so the
+    //first LSTM layer's input projections are computed once per distinct row per step (ProjectionCache.h) instead
+    //of once per window and timestep. Windows are not shuffled across batches, which is what makes them overlap.
+    //Throws std::invalid_argument when Y holds fewer rows than there are windows
+    void train_epoch(const Matrix& rows, const Matrix& Y, const int timesteps, const int seed);
+
+    //Checkpoint of the architecture, parameters and Adam state (moments and step count), so training can resume
+    //where it stopped instead of starting over from initialize_network. Data must be set again with init_data
+    void save_checkpoint(std::ostream& out) const;
+    void load_checkpoint(std::istream& in);
+    void save_checkpoint(const std::string& path) const;
+    void load_checkpoint(const std::string& path);
+
+    //Output of the last forward_prop, shape (1, m)
+    const Matrix& prediction() const { return finalPrediction; }
+
+    //Thread-safe inference: forward pass without caches, returns the predictions of shape (1, m)
+    Matrix predict(const Tensor3D& x) const;
+
+    const std::vector<matrixDict>& parameters() const { return layer_params; }
+    const std::vector<std::string>& layers() const { return layer_types; }
+    const std::vector<int>& dimensions() const { return layer_dims; }
+
+private:
+    //LSTM
+    typedef std::tuple<Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, Matrix, matrixDict> cacheTuple;
+    typedef std::tuple<Tensor3D, Tensor3D, Tensor3D, std::tuple<std::vector<cacheTuple>, Tensor3D>> LSTMCache;
+
+    //Backprop
+    //Variant since it can be either a Tensor3D gradient with timesteps or Matrix gradients
+    typedef std::map<std::string, variantTensor> gradientDict;
+
+    //Unified cache structure
+    struct UnifiedCache {
+        std::vector<std::variant<LSTMCache, matrixDict>> cache;
+    };
+
+    //Unified gradient structure
+    struct UnifiedGradients {
+        std::vector<std::variant<gradientDict, matrixDict>> grads;
+    };
+
+    Tensor3D reshape_last_timestep(const Matrix& hidden_state) const;
+    //Shared forward pass, fills layer_cache when it is given (training)
+    Matrix forward(const std::variant<Tensor3D, Matrix>& x_train, UnifiedCache* layer_cache, const ProjectionCache::Table* projections = nullptr) const;
+    void adam_update(Matrix& param, Matrix& v, Matrix& s, const Matrix& grad);
+
+    // Model parameters
+    std::vector<std::string> layer_types = {};
+    std::vector<int> layer_dims = {};
+    std::vector<matrixDict> layer_params;
+    double learning_rate = 3e-4;
+
+    //Forward prop variables
+    UnifiedCache cache;
+    Matrix finalPrediction; //Linear output matrix, shape(m,1)
+    Matrix output_gradient; //Gradient of the loss w.r.t. finalPrediction, set by loss() for back_prop
+
+    //Loss
+    reductions::KahanAccumulator accumulated_loss; //Compensated, many small batch losses are summed
+
+    //Data, x_train and y_train. NOTE: x_train and y_train have to be generated by minibatches
+    std::shared_ptr<const variantTensor> x_train = std::make_shared<const variantTensor>();
+    std::shared_ptr<const Matrix> y_train = std::make_shared<const Matrix>(Matrix{{}}); //shape (m,1)
+    int BATCH_SIZE = 0;
+    int n_hidden = 0; //Number of LSTM units.
+
+    //Backprop variables
+    UnifiedGradients grads;
+
+    //Adam optimizer variables
+    std::vector<std::vector<matrixDict>> Adam_params; //2D to store v and s
+    int t = 0;
+    static constexpr double beta1 = 0.9;
+    static constexpr double beta2 = 0.999;
+    static constexpr double epsilon = 1e-8;
+};
 
 #endif //HYBRIDMODEL_H
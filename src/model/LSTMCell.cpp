@@ -1,4 +1,5 @@
 #include "linalg.h"
+#include "expressions.h"
 #include "activations.h"
 #include "LSTMCell.h"
 #include <vector>
@@ -17,7 +18,78 @@ namespace LSTMCell {
     typedef std::map<std::string, variantTensor> gradientDict;
     typedef std::vector<cacheTuple> forwardCaches;
 
-    forwardTuple lstm_cell_forward(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, matrixDict& params, const int layer) {
+    CellWeights cell_weights(const matrixDict& params, const int layer) {
+        const std::string l = std::to_string(layer);
+        return CellWeights{params.at("Wf"+l), params.at("bf"+l), params.at("Wi"+l), params.at("bi"+l),
+                           params.at("Wc"+l), params.at("bc"+l), params.at("Wo"+l), params.at("bo"+l)};
+    }
+
+    namespace {
+        //Gates and next state of one cell, shared by the training forward pass and the cache-free inference step
+        struct CellState {
+            Matrix candidate, update_gate, forget_gate, output_gate; //(n_a, m)
+            Matrix c_next, a_next;                                   //(m, n_a)
+        };
+
+        //x_proj, when given, replaces the input half of the gate products W_g * [a_prev, x_t]^T
+        CellState cell_state(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, const CellWeights& w, const GateInputs* x_proj = nullptr) {
+            //Get the dimensions of shapes x_t, W_f
+            const int M = x_t.size(), N_X = x_t[0].size(); //Num of exs, features at current timestep
+            const int N_A = w.Wf.rows();                     //Num of hidden states
+
+            CellState state;
+            if (x_proj == nullptr) {
+                //Concatenate activation/hidden state of the previous state and the current input x_t
+                Matrix concat = linalg::generateZeros(M, N_X+N_A);
+                for (size_t i = 0; i < M; ++i) {
+                    for (size_t j = 0; j < N_A; ++j) {
+                        concat[i][j] = a_prev[i][j];
+                    }
+                }
+                for (size_t i = 0; i < M; ++i) {
+                    for (size_t j = 0; j < N_X; ++j) {
+                        concat[i][N_A + j] = x_t[i][j];
+                    }
+                }
+
+                //Compute the forward pass activations using LSTM formulas:
+                const linalg::View concat_T = linalg::T(concat);
+                state.candidate = activations::tanh(linalg::add(linalg::matmul(w.Wc, concat_T), w.bc));
+                state.update_gate = activations::sigmoid(linalg::add(linalg::matmul(w.Wi, concat_T), w.bi));
+                state.forget_gate = activations::sigmoid(linalg::add(linalg::matmul(w.Wf, concat_T), w.bf));
+                state.output_gate = activations::sigmoid(linalg::add(linalg::matmul(w.Wo, concat_T), w.bo));
+            } else {
+                //Only the recurrent half W_g[:, :n_a] * a_prev^T is left to compute per timestep
+                const linalg::View a_prev_T = linalg::T(a_prev);
+                auto gate = [&](const linalg::View& W, const Matrix& projected, const linalg::View& b) {
+                    Matrix z = linalg::matmul(linalg::sliceColsView(W, 0, N_A), a_prev_T);
+                    linalg::add_inplace(z, projected);
+                    return linalg::add(z, b);
+                };
+                state.candidate = activations::tanh(gate(w.Wc, x_proj->c, w.bc));
+                state.update_gate = activations::sigmoid(gate(w.Wi, x_proj->i, w.bi));
+                state.forget_gate = activations::sigmoid(gate(w.Wf, x_proj->f, w.bf));
+                state.output_gate = activations::sigmoid(gate(w.Wo, x_proj->o, w.bo));
+            }
+
+            //Gates are (n_a, m) and the states are (m, n_a), so the gates are read transposed and fused into one pass each
+            using linalg::expr::transposed;
+            state.c_next = linalg::eval(transposed(state.update_gate) * transposed(state.candidate) + transposed(state.forget_gate) * c_prev);
+            state.a_next = linalg::eval(transposed(state.output_gate) * linalg::expr::tanh(state.c_next));
+            return state;
+        }
+    }
+
+    std::tuple<Matrix, Matrix> lstm_cell_step(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, const CellWeights& weights, const GateInputs* x_proj) {
+        CellState state = cell_state(x_t, a_prev, c_prev, weights, x_proj);
+        return std::make_tuple(std::move(state.a_next), std::move(state.c_next));
+    }
+
+    forwardTuple lstm_cell_forward(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, const matrixDict& params, const int layer) {
+        return lstm_cell_forward(x_t, nullptr, a_prev, c_prev, params, layer);
+    }
+
+    forwardTuple lstm_cell_forward(const Matrix& x_t, const GateInputs* x_proj, const Matrix& a_prev, const Matrix& c_prev, const matrixDict& params, const int layer) {
             /* Inputs:
              * - x_t: current x-input timestep
              * - a_prev: hidden/activation state in the previous timestep
@@ -36,61 +108,18 @@ namespace LSTMCell {
              * - cache = cached values for backprop -- tuple(a_next, c_next, a_prev, c_prev, x_t, parameters)
              */
 
-            // Get the parameters from params
-            Matrix Wf = params["Wf"+std::to_string(layer)]; //Forget gates
-            Matrix Bf = params["bf"+std::to_string(layer)];
-            Matrix Wi = params["Wi"+std::to_string(layer)]; //Update gates
-            Matrix Bi = params["bi"+std::to_string(layer)];
-            Matrix Wc = params["Wc"+std::to_string(layer)]; //Candidate/memory gates
-            Matrix Bc = params["bc"+std::to_string(layer)];
-            Matrix Wo = params["Wo"+std::to_string(layer)]; //Output gates
-            Matrix Bo = params["bo"+std::to_string(layer)];
-            Matrix Wy = params["Wy"+std::to_string(layer)]; //Prediction weights
-            Matrix By = params["by"+std::to_string(layer)];
-
-            //Get the dimensions of shapes x_t, W_y
-            const int M = x_t.size(), N_X = x_t[0].size(); //Num of exs, features at current timestep
-            const int N_A = Wy[0].size(), N_Y = Wy.size(); //Num of hidden states, num of outputs
-
-            // std::cout << " DEBUG - Checking shapes in LSTMCell Forward" << std::endl;
-            // std::cout << "  Shape of x_t: " << linalg::shape(x_t) << std::endl;
-            // std::cout << "  Shape of a_prev: " << linalg::shape(a_prev) << std::endl;
-            // std::cout << "  Shape of c_prev (input): " << linalg::shape(c_prev) << std::endl;
-            // std::cout << "  Shape of Wf: " << linalg::shape(Wf) << std::endl;
-            // std::cout << "  Shape of Bf: " << linalg::shape(Bf) << std::endl;
-            // std::cout << "  Shape of Wi: " << linalg::shape(Wi) << std::endl;
-            // std::cout << "  Shape of Bi: " << linalg::shape(Bi) << std::endl;
-            // std::cout << "  Shape of Wc: " << linalg::shape(Wc) << std::endl;
-            // std::cout << "  Shape of Bc: " << linalg::shape(Bc) << std::endl;
-            // std::cout << "  Shape of Wo: " << linalg::shape(Wo) << std::endl;
-            // std::cout << "  Shape of Bo: " << linalg::shape(Bo) << std::endl;
-
-            //Concatenate activation/hidden state of the previous state and the current input x_t
-            Matrix concat = linalg::generateZeros(M, N_X+N_A);
-            for (size_t i = 0; i < M; ++i) {
-                for (size_t j = 0; j < N_A; ++j) {
-                    concat[i][j] = a_prev[i][j];
-                }
-            }
-            for (size_t i = 0; i < M; ++i) {
-                for (size_t j = 0; j < N_X; ++j) {
-                    concat[i][N_A + j] = x_t[i][j];
-                }
-            }
-            // std::cout << " DEBUG - Shape of concat: " << linalg::shape(concat) << std::endl;
-
-            // std::cout << "LSTM-Cell Forward concat successful" << std::endl;
+            // Get the parameters from params (read-only, so concurrent forward passes can share them)
+            const CellWeights weights = cell_weights(params, layer);
+            const Matrix& Wy = params.at("Wy"+std::to_string(layer)); //Prediction weights
+            const Matrix& By = params.at("by"+std::to_string(layer));
 
-            //Compute the forward pass activations using LSTM formulas:
-            // std::cerr << "DEBUG: LSTMCell - Shape of Wi: " << linalg::shape(Wi) << std::endl;
-            // std::cerr << "DEBUG: LSTMCell - Shape of transpose(concat): " << linalg::shape(linalg::transpose(concat)) << std::endl;
-            Matrix concat_T = linalg::transpose(concat);
-            Matrix candidate = activations::tanh(linalg::add(linalg::matmul(Wi, concat_T), Bc));
-            Matrix update_gate = activations::sigmoid(linalg::add(linalg::matmul(Wi, linalg::transpose(concat)), Bi));
-            Matrix forget_gate = activations::sigmoid(linalg::add(linalg::matmul(Wf, linalg::transpose(concat)), Bf));
-            Matrix output_gate = activations::sigmoid(linalg::add(linalg::matmul(Wo, linalg::transpose(concat)), Bo));
-            Matrix c_next = linalg::transpose(linalg::add(linalg::elementMultiply(update_gate, candidate), linalg::transpose(linalg::elementMultiply(linalg::transpose(forget_gate), c_prev))));
-            Matrix a_next = linalg::transpose(linalg::elementMultiply(output_gate, linalg::transpose(activations::tanh(c_next))));
+            const CellState state = cell_state(x_t, a_prev, c_prev, weights, x_proj);
+            const Matrix& candidate = state.candidate;
+            const Matrix& update_gate = state.update_gate;
+            const Matrix& forget_gate = state.forget_gate;
+            const Matrix& output_gate = state.output_gate;
+            const Matrix& c_next = state.c_next;
+            const Matrix& a_next = state.a_next;
 
             // if (Wy[0].size() == a_next[0].size()) {
             //     a_next = linalg::transpose(a_next);
@@ -100,7 +129,8 @@ namespace LSTMCell {
             // std::cout << "  Shape of a_next: " << linalg::shape(a_next) << std::endl;
 
             //Compute the prediction of the LSTM Cell:
-            Matrix yt_pred = linalg::transpose(activations::linear(linalg::add(linalg::matmul(Wy, linalg::transpose(a_next)), By)));
+            //(a_next * Wy^T) + By^T is (Wy * a_next^T + By)^T computed directly in (m, n_y) layout, By^T broadcasts down the rows
+            Matrix yt_pred = activations::linear(linalg::add(linalg::matmul(a_next, linalg::T(Wy)), linalg::T(By)));
 
             //Return next cell parameters and cached values for backprop
             auto params_tuple = std::make_tuple(a_next, c_next, a_prev, c_prev, forget_gate, update_gate, candidate, output_gate, x_t, params);
@@ -109,149 +139,92 @@ namespace LSTMCell {
     }
 
     //Compute back propagation for a single LSTM cell
-    gradientDict lstm_cell_backward(const Matrix& da_next, const Matrix& dc_next, const cacheTuple& cache) {
+    gradientDict lstm_cell_backward(const Matrix& da_next, const Matrix& dc_next, const cacheTuple& cache, const int layer) {
             /* Inputs:
              * - da_next, gradients of next hidden state, Matrix (m, n_a)
              * - dc_next, gradients of next candidate/memory state, Matrix (m, n_a)
              * - cache, forward pass tuple
+             * - layer, the layer the cache belongs to (for the parameter and gradient keys)
              */
             //Retrieve forward prop information
-            Matrix a_next = std::get<0>(cache);
-            Matrix c_next = std::get<1>(cache);
-            Matrix a_prev = std::get<2>(cache);
-            Matrix c_prev = std::get<3>(cache);
-            Matrix f_gate = std::get<4>(cache);
-            Matrix u_gate = std::get<5>(cache);
-            Matrix candidate = std::get<6>(cache);
-            Matrix o_gate = std::get<7>(cache);
-            Matrix x_t = std::get<8>(cache);
-            matrixDict params = std::get<9>(cache);
+            const Matrix& c_next = std::get<1>(cache);
+            const Matrix& a_prev = std::get<2>(cache);
+            const Matrix& c_prev = std::get<3>(cache);
+            const Matrix& f_gate = std::get<4>(cache);
+            const Matrix& u_gate = std::get<5>(cache);
+            const Matrix& candidate = std::get<6>(cache);
+            const Matrix& o_gate = std::get<7>(cache);
+            const Matrix& x_t = std::get<8>(cache);
+            const CellWeights w = cell_weights(std::get<9>(cache), layer);
+            const std::string l = std::to_string(layer);
 
             //Retrieve shapes
-            const int m_x = x_t.size(), m_a = a_next.size(), n_x = x_t[0].size(), n_a = a_next[0].size();
-
-            //Compute gate derivatives
-            Matrix do_gate_t = linalg::elementMultiply(
-                                linalg::elementMultiply(
-                                    linalg::elementMultiply(da_next, activations::tanh(c_next)), o_gate),
-                                    linalg::subtract(
-                                        linalg::generateOnes(o_gate.size(), o_gate[0].size()), o_gate));
-
-            Matrix dcc_t = linalg::add(
-                            linalg::elementMultiply(dc_next, u_gate),
-                              linalg::elementMultiply(
-                                linalg::elementMultiply(
-                                    linalg::elementMultiply(
-                                        linalg::elementMultiply(
-                                            linalg::elementMultiply(
-                                                o_gate,
-                                                activations::tanh_prime(c_next)
-                                                ),
-                                                u_gate
-                                            ),
-                                            da_next
-                                        ),
-                                        candidate
-                                    ),
-                                    activations::tanh_prime(candidate)
-                                )
-                              );
-
-            Matrix du_gate_t = linalg::elementMultiply(
-                                linalg::elementMultiply(
-                                    linalg::elementMultiply(
-                                        linalg::add(
-                                            linalg::elementMultiply(activations::tanh_prime(c_next),
-                                                linalg::elementMultiply(
-                                                    o_gate, da_next)
-                                                ), dc_next),
-                                            candidate),
-                                        u_gate),
-                                    linalg::subtract(
-                                        linalg::generateOnes(u_gate.size(), u_gate[0].size()), u_gate));
-
-            Matrix df_gate_t = linalg::elementMultiply(
-                                linalg::elementMultiply(
-                                    linalg::elementMultiply(
-                                        linalg::add(
-                                            linalg::elementMultiply(activations::tanh_prime(c_next),
-                                                linalg::elementMultiply(
-                                                    o_gate, da_next)
-                                                ), dc_next),
-                                            c_prev),
-                                        f_gate),
-                                    linalg::subtract(
-                                        linalg::generateOnes(f_gate.size(), f_gate[0].size()), f_gate));
-
-            //Concatenate activation/hidden state of the previous state and the input x_t for derivatives of weight gates on axis=0:
-            const int concat_cols = std::max(n_a, n_x);
-            Matrix concat = linalg::generateZeros(m_a+m_x, concat_cols);
-
-            for (size_t i = 0; i < m_a; i++) {
-                for (size_t j = 0; j < concat_cols; j++) {
-                    if (j < n_a) {
-                        concat[i][j] = a_prev[i][j];
-                    }
-                }
-            }
+            const int m = x_t.size(), n_x = x_t[0].size(), n_a = a_prev[0].size();
 
-            // Copy x_t into the bottom part of concat, padding if necessary
-            for (size_t i = 0; i < m_x; i++) {
-                for (size_t j = 0; j < concat_cols; j++) {
-                    if (j < n_x) {
-                        concat[m_a + i][j] = x_t[i][j];
-                    }
+            //Compute gate derivatives. Gate derivatives keep the (n_a, m) gate layout, the (m, n_a) states are read transposed
+            using linalg::expr::lazy;
+            using linalg::expr::transposed;
+            using linalg::expr::tanh_prime;
+            const auto da = transposed(da_next);
+
+            //Gradient reaching c_next, directly from the next timestep and through a_next = o * tanh(c_next)
+            const Matrix dc = linalg::eval(transposed(dc_next) + da * o_gate * tanh_prime(transposed(c_next)));
+
+            Matrix do_gate_t = linalg::eval(da * linalg::expr::tanh(transposed(c_next)) * o_gate * (1.0 - lazy(o_gate)));
+
+            Matrix dcc_t = linalg::eval(lazy(dc) * u_gate * (1.0 - lazy(candidate) * candidate)); //candidate is already tanh'd
+
+            Matrix du_gate_t = linalg::eval(lazy(dc) * candidate * u_gate * (1.0 - lazy(u_gate)));
+
+            Matrix df_gate_t = linalg::eval(lazy(dc) * transposed(c_prev) * f_gate * (1.0 - lazy(f_gate)));
+
+            //Concatenate activation/hidden state of the previous state and the input x_t as in the forward pass, (m, n_a+n_x)
+            Matrix concat = linalg::generateZeros(m, n_a+n_x);
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < n_a; j++) {
+                    concat[i][j] = a_prev[i][j];
+                }
+                for (size_t j = 0; j < n_x; j++) {
+                    concat[i][n_a + j] = x_t[i][j];
                 }
             }
 
             //Compute parameter derivatives with gate derivatives
-            Matrix dWf = linalg::matmul(df_gate_t, linalg::transpose(concat));
-            Matrix dWi = linalg::matmul(du_gate_t, linalg::transpose(concat));
-            Matrix dWc = linalg::matmul(dcc_t, linalg::transpose(concat));
-            Matrix dWo = linalg::matmul(do_gate_t, linalg::transpose(concat));
+            Matrix dWf = linalg::matmul(df_gate_t, concat);
+            Matrix dWi = linalg::matmul(du_gate_t, concat);
+            Matrix dWc = linalg::matmul(dcc_t, concat);
+            Matrix dWo = linalg::matmul(do_gate_t, concat);
             Matrix dbf = linalg::sum(df_gate_t, 1);
             Matrix dbi = linalg::sum(du_gate_t, 1);
             Matrix dbc = linalg::sum(dcc_t, 1);
             Matrix dbo = linalg::sum(do_gate_t, 1);
 
-            //Compute the final derivatives of the previous memory and hidden states, and the input
-            Matrix da_prev1 = linalg::add(
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wf"], 0, n_a)), df_gate_t),
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wi"], 0, n_a)), du_gate_t));
-            Matrix da_prev2 = linalg::add(
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wc"], 0, n_a)), dcc_t),
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wo"], 0, n_a)), do_gate_t));
-            Matrix da_prev = linalg::add(da_prev1, da_prev2);
-
-            Matrix dc_prev = linalg::add(
-                                linalg::elementMultiply(dc_next, f_gate),
-                                linalg::elementMultiply(
-                                    linalg::elementMultiply(
-                                        linalg::elementMultiply(f_gate, da_next),
-                                        activations::tanh_prime(c_next)
-                                    ), o_gate)
-                                );
-
-            Matrix dx_t1 = linalg::add(
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wf"], n_a, params["Wf"][0].size())), df_gate_t),
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wi"], n_a, params["Wi"][0].size())), du_gate_t));
-            Matrix dx_t2 = linalg::add(
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wc"], n_a, params["Wc"][0].size())), dcc_t),
-                            linalg::matmul(linalg::transpose(linalg::sliceCols(params["Wo"], n_a, params["Wo"][0].size())), do_gate_t));
-            Matrix dx_t = linalg::add(dx_t1, dx_t2);
+            //Compute the final derivatives of the previous memory and hidden states, and the input, all (m, cols): the
+            //a_prev columns of the gate weights for da_prev, the x_t columns for dx_t
+            auto through_gates = [&](const size_t first_col, const size_t last_col) {
+                Matrix result = linalg::matmul(linalg::T(df_gate_t), linalg::sliceColsView(w.Wf, first_col, last_col));
+                linalg::add_inplace(result, linalg::matmul(linalg::T(du_gate_t), linalg::sliceColsView(w.Wi, first_col, last_col)));
+                linalg::add_inplace(result, linalg::matmul(linalg::T(dcc_t), linalg::sliceColsView(w.Wc, first_col, last_col)));
+                linalg::add_inplace(result, linalg::matmul(linalg::T(do_gate_t), linalg::sliceColsView(w.Wo, first_col, last_col)));
+                return result;
+            };
+            Matrix da_prev = through_gates(0, n_a);
+            Matrix dx_t = through_gates(n_a, n_a+n_x);
+
+            Matrix dc_prev = linalg::eval(transposed(dc) * transposed(f_gate));
 
             gradientDict gradients;
-            gradients["dxt"] = dx_t;
-            gradients["da_prev"] = da_prev;
-            gradients["dc_prev"] = dc_prev;
-            gradients["dWf"] = dWf;
-            gradients["dbf"] = dbf;
-            gradients["dWi"] = dWi;
-            gradients["dbi"] = dbi;
-            gradients["dWc"] = dWc;
-            gradients["dbc"] = dbc;
-            gradients["dWo"] = dWo;
-            gradients["dbo"] = dbo;
+            gradients["dxt"+l] = dx_t;
+            gradients["da_prev"+l] = da_prev;
+            gradients["dc_prev"+l] = dc_prev;
+            gradients["dWf"+l] = dWf;
+            gradients["dbf"+l] = dbf;
+            gradients["dWi"+l] = dWi;
+            gradients["dbi"+l] = dbi;
+            gradients["dWc"+l] = dWc;
+            gradients["dbc"+l] = dbc;
+            gradients["dWo"+l] = dWo;
+            gradients["dbo"+l] = dbo;
 
             return gradients;
     }
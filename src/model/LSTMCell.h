@@ -6,6 +6,8 @@
 #include <variant>
 #include <valarray>
 
+#include "linalg.h"
+
 namespace LSTMCell {
     //Type definitions
     typedef std::vector<std::vector<double>> Matrix;
@@ -18,9 +20,28 @@ namespace LSTMCell {
     typedef std::variant<Matrix, Tensor3D> variantTensor;
     typedef std::map<std::string, variantTensor> gradientDict;
 
+    //Read-only gate weights and biases of one cell, viewed in place (from a matrixDict or external storage)
+    struct CellWeights {
+        linalg::View Wf, bf, Wi, bi, Wc, bc, Wo, bo;
+    };
+
+    //Input halves W_g[:, n_a:] * x_t^T of the forget, update, candidate and output gate products for one timestep,
+    //each (n_a, m). Precomputed once per dataset row by ProjectionCache instead of once per window
+    struct GateInputs {
+        Matrix f, i, c, o;
+    };
+
     //Function declarations
-    forwardTuple lstm_cell_forward(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, matrixDict& params, const int layer);
-    gradientDict lstm_cell_backward(const Matrix& da_next, const Matrix& dc_next, const cacheTuple& cache);
+    CellWeights cell_weights(const matrixDict& params, const int layer);
+    //Inference-only step, returns (a_next, c_next) without building the backprop cache. x_proj, when given,
+    //replaces the input half of the gate products as in lstm_cell_forward
+    std::tuple<Matrix, Matrix> lstm_cell_step(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, const CellWeights& weights, const GateInputs* x_proj = nullptr);
+    forwardTuple lstm_cell_forward(const Matrix& x_t, const Matrix& a_prev, const Matrix& c_prev, const matrixDict& params, const int layer);
+    //Same, taking the input half of the gate products from x_proj when it is not null. x_t is still kept in the
+    //cache for lstm_cell_backward
+    forwardTuple lstm_cell_forward(const Matrix& x_t, const GateInputs* x_proj, const Matrix& a_prev, const Matrix& c_prev, const matrixDict& params, const int layer);
+    //Gradients of one cell's gates, previous states and input, keyed with layer like the parameters
+    gradientDict lstm_cell_backward(const Matrix& da_next, const Matrix& dc_next, const cacheTuple& cache, const int layer);
 }
 
 #endif //LSTMCELL_H
@@ -2,6 +2,7 @@
 #include <map>
 #include "LSTMNetwork.h"
 #include "LSTMCell.h"
+#include "ProjectionCache.h"
 #include "linalg.h"
 
 namespace LSTMNetwork {
@@ -16,7 +17,7 @@ namespace LSTMNetwork {
     typedef std::variant<Matrix, Tensor3D> variantTensor;
     typedef std::map<std::string, variantTensor> gradientDict;
 
-    matrixDict init_params(const int n_input, const int n_hidden, const int n_output, const int layer) {
+    matrixDict init_params(const int n_input, const int n_hidden, const int n_output, const int layer, const uint64_t seed) {
 
             // std::cout << "LSTMCell::init_params - n_input: " << n_input << ", n_hidden: " << n_hidden << ", n_output: " << n_output << ", layer: " << layer << std::endl; // Print n_input, n_hidden
             //NOTE: n represents the columns / num of features in the data
@@ -25,23 +26,23 @@ namespace LSTMNetwork {
             //Initialize parameters to have small values
             //NOTE: We might need to transpose all these values
             //Forget gate:
-            params["Wf"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input));
+            params["Wf"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input, "Wf"+std::to_string(layer), seed));
             params["bf"+std::to_string(layer)] = linalg::generateZeros(n_hidden, 1);
 
             //Update (input) gate:
-            params["Wi"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input));
+            params["Wi"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input, "Wi"+std::to_string(layer), seed));
             params["bi"+std::to_string(layer)] = linalg::generateZeros(n_hidden, 1);
 
             //Candidate/memory cells
-            params["Wc"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input));
+            params["Wc"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input, "Wc"+std::to_string(layer), seed));
             params["bc"+std::to_string(layer)] = linalg::generateZeros(n_hidden, 1);
 
             //Output gate:
-            params["Wo"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input));
+            params["Wo"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_hidden, n_hidden+n_input, "Wo"+std::to_string(layer), seed));
             params["bo"+std::to_string(layer)] = linalg::generateZeros(n_hidden, 1);
 
             //Predictions
-            params["Wy"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_output, n_hidden));
+            params["Wy"+std::to_string(layer)] = linalg::scalarMultiply(0.01, linalg::randn(n_output, n_hidden, "Wy"+std::to_string(layer), seed));
             params["by"+std::to_string(layer)] = linalg::generateZeros(n_output, 1);
 
             return params;
@@ -49,7 +50,7 @@ namespace LSTMNetwork {
 
     //Iterate through each cell at their respective timesteps
     std::tuple<Tensor3D, Tensor3D, Tensor3D, std::tuple<std::vector<cacheTuple>, Tensor3D>>
-    lstm_forward(const Tensor3D& x, const Matrix& a_initial, matrixDict& params, const int layer) {
+    lstm_forward(const Tensor3D& x, const Matrix& a_initial, const matrixDict& params, const int layer, const ProjectionCache::Table* projections) {
             /* Inputs:
              * - x: input data, 3D Tensor of shape (num exs, num feats, timestep (days))
              * - a_initial: Initial hidden state
@@ -59,11 +60,10 @@ namespace LSTMNetwork {
             //NOTE: if hybrid with MLP, cache may not be empty.
             std::vector<cacheTuple> cache;
 
-            Matrix Wy = params["Wy"+std::to_string(layer)]; //Get the weight matrix for the prediction
+            const Matrix& Wy = params.at("Wy"+std::to_string(layer)); //Get the weight matrix for the prediction
 
             //Init shapes. NOTE: n_a, n_y might need to be reversed
             const int m = x.size(), n_x = x[0][0].size(), timesteps = x[0].size(), n_y = Wy.size(), n_a = Wy[0].size();
-            std::cout << "LSTM-Forward - n_a (calculated from Wy[0].size()): " << n_a << std::endl; // Print n_a
 
             /* Init states
                 * Hidden state `a` = {n_a, m, timestep}
@@ -80,8 +80,6 @@ namespace LSTMNetwork {
             Matrix a_next = a_initial;
             Matrix c_next = linalg::generateZeros(m, n_a);
 
-            std::cout << "LSTM Forward initialization successful" << std::endl;
-
             //Forward pass for every timestep
             for (size_t timestep = 0; timestep < timesteps; timestep++) {
                 // Slice the input data at the specific timestep:
@@ -93,9 +91,15 @@ namespace LSTMNetwork {
                 }
                 // std::cout << "LSTM Forward slice successful" << std::endl;
 
+                //Input projections of this timestep's rows, looked up instead of recomputed when a table is given
+                LSTMCell::GateInputs x_proj;
+                if (projections != nullptr) {
+                    x_proj = ProjectionCache::gather(*projections, timestep);
+                }
+
                 //Compute the matrices and parameters for the current timestep cell
                 std::tuple< Matrix, Matrix, Matrix, cacheTuple >
-                cell_state = LSTMCell::lstm_cell_forward(x_t, a_next, c_next, params, layer);
+                cell_state = LSTMCell::lstm_cell_forward(x_t, (projections != nullptr) ? &x_proj : nullptr, a_next, c_next, params, layer);
 
                 // std::cout << "LSTM-Cell Forward successful" << std::endl;
 
@@ -136,16 +140,16 @@ namespace LSTMNetwork {
             return std::make_tuple(hidden_state, prediction, candidate, std::make_tuple(cache, x));
         }
 
-    gradientDict lstm_backprop(Tensor3D da, std::tuple<std::vector<cacheTuple>, Tensor3D> fwd_prop_cache, const int layer) {
-            std::vector<cacheTuple> cache = std::get<0>(fwd_prop_cache);
-            Tensor3D x = std::get<1>(fwd_prop_cache); // Input
+    gradientDict lstm_backprop(const Tensor3D& da, const std::tuple<std::vector<cacheTuple>, Tensor3D>& fwd_prop_cache, const int layer) {
+            const std::vector<cacheTuple>& cache = std::get<0>(fwd_prop_cache);
+            const Tensor3D& x = std::get<1>(fwd_prop_cache); // Input
+            const std::string l = std::to_string(layer);
 
             //Initialize gradients and sizes
             const int m = da.size(), T_x = da[0].size(), n_a = da[0][0].size();
             const int n_x = x[0][0].size();
 
             Tensor3D dx = linalg::generateZeros(m, T_x, n_x);
-            Matrix da_initial = linalg::generateZeros(m, n_a);
             Matrix da_prev_t = linalg::generateZeros(m, n_a);
             Matrix dc_prev_t = linalg::generateZeros(m, n_a);
             Matrix dWf = linalg::generateZeros(n_a, n_a+n_x);
@@ -157,56 +161,65 @@ namespace LSTMNetwork {
             Matrix dbc = linalg::generateZeros(n_a, 1);
             Matrix dbo = linalg::generateZeros(n_a, 1);
 
-            //Initialize gradients variable
-            gradientDict gradients;
+            //Per-timestep slice, reused across iterations
+            Matrix da_t(m, std::vector<double>(n_a));
 
-            //Backprop iteration through each timestep cell
-            for (size_t timestep = T_x; timestep > 0; timestep--) {
-                //Compute gradients for each timestep cell
-                //Slice the activation data:
-                Matrix da_t(m, std::vector<double>(n_a));
+            //Backprop iteration through each timestep cell, last to first
+            for (int timestep = T_x - 1; timestep >= 0; timestep--) {
+                //Gradient of this timestep's hidden state: from the layer above plus from the next timestep's cell
                 for (size_t i = 0; i < m; i++) {
-                    for (size_t j = 0; j < n_x; j++) {
-                        da_t[i][j] = x[i][timestep][j];
+                    for (size_t j = 0; j < n_a; j++) {
+                        da_t[i][j] = da[i][timestep][j] + da_prev_t[i][j];
                     }
                 }
-                //Get the cache tuple for the current timestep
-                cacheTuple cache_t = cache.at(timestep);
 
                 //Compute gradients for the current timestep cell
-                gradients = LSTMCell::lstm_cell_backward(linalg::add(da_t, da_prev_t), dc_prev_t, cache_t);
+                gradientDict gradients = LSTMCell::lstm_cell_backward(da_t, dc_prev_t, cache.at(timestep), layer);
 
                 //Store the dx gradient
+                const Matrix& dx_t = std::get<Matrix>(gradients["dxt"+l]);
                 for (size_t i = 0; i < m; i++) {
                     for (size_t j = 0; j < n_x; j++) {
-                        dx[i][timestep][j] = std::get<Matrix>(gradients["dxt"+std::to_string(layer)])[i][j];
+                        dx[i][timestep][j] = dx_t[i][j];
                     }
                 }
 
                 //Add the gradient to the parameter's previous timestep gradients
-                dWf = linalg::add(std::get<Matrix>(gradients["dWf"+std::to_string(layer)]), dWf);
-                dWi = linalg::add(std::get<Matrix>(gradients["dWi"+std::to_string(layer)]), dWi);
-                dWc = linalg::add(std::get<Matrix>(gradients["dWc"+std::to_string(layer)]), dWc);
-                dWo = linalg::add(std::get<Matrix>(gradients["dWo"+std::to_string(layer)]), dWo);
-                dbf = linalg::add(std::get<Matrix>(gradients["dbf"+std::to_string(layer)]), dbf);
-                dbi = linalg::add(std::get<Matrix>(gradients["dbi"+std::to_string(layer)]), dbi);
-                dbc = linalg::add(std::get<Matrix>(gradients["dbc"+std::to_string(layer)]), dbc);
-                dbo = linalg::add(std::get<Matrix>(gradients["dbo"+std::to_string(layer)]), dbo);
+                linalg::add_inplace(dWf, std::get<Matrix>(gradients["dWf"+l]));
+                linalg::add_inplace(dWi, std::get<Matrix>(gradients["dWi"+l]));
+                linalg::add_inplace(dWc, std::get<Matrix>(gradients["dWc"+l]));
+                linalg::add_inplace(dWo, std::get<Matrix>(gradients["dWo"+l]));
+                linalg::add_inplace(dbf, std::get<Matrix>(gradients["dbf"+l]));
+                linalg::add_inplace(dbi, std::get<Matrix>(gradients["dbi"+l]));
+                linalg::add_inplace(dbc, std::get<Matrix>(gradients["dbc"+l]));
+                linalg::add_inplace(dbo, std::get<Matrix>(gradients["dbo"+l]));
+
+                //Carry the state gradients to the previous timestep
+                da_prev_t = std::move(std::get<Matrix>(gradients["da_prev"+l]));
+                dc_prev_t = std::move(std::get<Matrix>(gradients["dc_prev"+l]));
             }
 
+            //The per-timestep predictions Wy * a + by are not read by the layers above, so they get zero gradients
+            const matrixDict& params = std::get<9>(cache.front());
+            const Matrix& Wy = params.at("Wy"+l);
+            const Matrix& by = params.at("by"+l);
+
+            //Initialize gradients variable
+            gradientDict gradients;
+
             // Set the first activation's gradient to backpropagated da_prev gradient
-            da_initial = std::get<Matrix>(gradients["da_prev"+std::to_string(layer)]);
-
-            gradients["dx"+std::to_string(layer)] = dx;
-            gradients["da0"+std::to_string(layer)] = da_initial;
-            gradients["dWf"+std::to_string(layer)] = dWf;
-            gradients["dbf"+std::to_string(layer)] = dbf;
-            gradients["dWi"+std::to_string(layer)] = dWi;
-            gradients["dbi"+std::to_string(layer)] = dbi;
-            gradients["dWc"+std::to_string(layer)] = dWc;
-            gradients["dbc"+std::to_string(layer)] = dbc;
-            gradients["dWo"+std::to_string(layer)] = dWo;
-            gradients["dbo"+std::to_string(layer)] = dbo;
+            gradients["dx"+l] = dx;
+            gradients["da0"+l] = da_prev_t;
+            gradients["dWf"+l] = dWf;
+            gradients["dbf"+l] = dbf;
+            gradients["dWi"+l] = dWi;
+            gradients["dbi"+l] = dbi;
+            gradients["dWc"+l] = dWc;
+            gradients["dbc"+l] = dbc;
+            gradients["dWo"+l] = dWo;
+            gradients["dbo"+l] = dbo;
+            gradients["dWy"+l] = linalg::generateZeros(Wy.size(), Wy[0].size());
+            gradients["dby"+l] = linalg::generateZeros(by.size(), by[0].size());
 
             return gradients;
     }
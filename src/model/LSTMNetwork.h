@@ -4,6 +4,11 @@
 #include <vector>
 #include <map>
 #include <variant>
+#include <cstdint>
+
+namespace ProjectionCache {
+    struct Table;
+}
 
 namespace LSTMNetwork {
 
@@ -18,12 +23,16 @@ namespace LSTMNetwork {
     typedef std::variant<Matrix, Tensor3D> variantTensor;
     typedef std::map<std::string, variantTensor> gradientDict;
 
-    matrixDict init_params(const int n_input, const int n_hidden, const int n_output, const int layer);
+    //Weights are drawn under seed (HybridModel derives one per model), biases start at zero
+    matrixDict init_params(const int n_input, const int n_hidden, const int n_output, const int layer, const uint64_t seed);
 
     std::tuple<Tensor3D, Tensor3D, Tensor3D, std::tuple<std::vector<cacheTuple>, Tensor3D>>
-    lstm_forward(const Tensor3D& x, const Matrix& a_initial, matrixDict& params, const int layer);
+    lstm_forward(const Tensor3D& x, const Matrix& a_initial, const matrixDict& params, const int layer,
+                 const ProjectionCache::Table* projections = nullptr); //Input projections of x's windows, built from params
 
-    gradientDict lstm_backprop(Tensor3D da, std::tuple<std::vector<cacheTuple>, Tensor3D> fwd_prop_cache, const int layer);
+    //Backprop through time. da is the gradient of every timestep's hidden state (m, timesteps, n_a); returns the
+    //parameter gradients, dx (the input's) and da0 (the initial hidden state's), keyed with layer
+    gradientDict lstm_backprop(const Tensor3D& da, const std::tuple<std::vector<cacheTuple>, Tensor3D>& fwd_prop_cache, const int layer);
 }
 
 #endif //LSTMNETWORK_H
@@ -1,33 +1,31 @@
 #include "MLP.h"
 #include "linalg.h"
+#include "rng.h"
 
 #include <vector>
 #include <map>
-#include <__random/random_device.h>
-#include <random>
+#include <string>
+#include <cmath>
 
 namespace MLP {
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::map<std::string, Matrix> matrixDict; //Forward cache and gradients for mlp
 
     // Use W_y, a_next, b_y as Dense's weights, hidden state (a), biases
-    Matrix he_normalization(const int rows, const int cols) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
+    Matrix he_normalization(const int rows, const int cols, const std::string& name) {
+        return he_normalization(rows, cols, name, rng::seed());
+    }
 
+    Matrix he_normalization(const int rows, const int cols, const std::string& name, const uint64_t seed) {
         double stdev = std::sqrt(2.0 / rows);
-        std::normal_distribution<double> distrib(0, stdev);
         std::vector <std::vector <double> > result(rows, std::vector<double>(cols));
-        for (size_t i = 0; i < rows; i++) {
-            for (size_t j = 0; j < cols; j++) {
-                result[i][j] = distrib(gen); //Random values for He
-             }
-        }
+        //Random values for He, reproducible for a given seed and filled in parallel for large layers
+        rng::fillNormal(result, seed, name.empty() ? rng::next_tensor_id() : rng::tensor_id(name), 0.0, stdev);
 
         return result;
     }
 
-    matrixDict init_mlp_params(const std::vector<int>& layer_dimensions, const int layer) {
+    matrixDict init_mlp_params(const std::vector<int>& layer_dimensions, const int layer, const uint64_t seed) {
         /*
         Inputs:
         layer_dimensions -- array containing the dimensions of each layer in the NN
@@ -45,7 +43,7 @@ namespace MLP {
 
         /* Init the weight matrix of the current MLP layer */
         //std::cout << "He Normalizing:" << std::endl;
-        params["W"+std::to_string(layer+1)] = he_normalization(layer_dimensions[layer], layer_dimensions[layer-1]);
+        params["W"+std::to_string(layer+1)] = he_normalization(layer_dimensions[layer], layer_dimensions[layer-1], "W"+std::to_string(layer+1), seed);
         // std::cout << "MLP Weights initialized successfully" << std::endl;
 
         /* Init the bias matrix of the current bias layer. Generates a matrix of shape[num units in current layer, 1 value] */
@@ -55,19 +53,18 @@ namespace MLP {
     }
 
     //Dense layer (MLP)
-    std::tuple<Matrix, matrixDict> Dense(Matrix a_in, matrixDict& params, const std::function<Matrix(Matrix)>& activation, const int layer, bool encountered) {
-        const Matrix W = params["W"+std::to_string(layer)];
-        Matrix b = params["b"+std::to_string(layer)];
+    std::tuple<Matrix, matrixDict> Dense(const Matrix& a_in, const matrixDict& params, const std::function<Matrix(Matrix)>& activation, const int layer, bool encountered) {
+        const Matrix& W = params.at("W"+std::to_string(layer));
+        const Matrix& b = params.at("b"+std::to_string(layer));
         matrixDict cache;
 
-        if (layer == 1 || encountered == true) {
-            a_in = linalg::transpose(a_in);
-        }
+        //Inputs arriving as (m, n) are read through a transposed view
+        const linalg::View input = (layer == 1 || encountered == true) ? linalg::T(a_in) : linalg::View(a_in);
 
         // std::cout << linalg::shape(W) << std::endl;
-        // std::cout << linalg::shape(a_in) << std::endl;
+        // std::cout << linalg::shape(input) << std::endl;
 
-        const Matrix Z = linalg::add(linalg::matmul(W, a_in), b);
+        const Matrix Z = linalg::add(linalg::matmul(W, input), b);
         const Matrix a_out = activation(Z);
 
         cache["Z"+std::to_string(layer)] = Z;
@@ -79,16 +76,16 @@ namespace MLP {
     }
 
     //Backprop one step (MLP)
-    matrixDict mlp_backward(Matrix a_in, Matrix dA, Matrix targets, matrixDict mlp_cache, const int layer, const std::function<Matrix(Matrix)>& prime_activation) {
+    matrixDict mlp_backward(const linalg::View& a_in, const Matrix& dA, const matrixDict& mlp_cache, const int layer, const std::function<Matrix(Matrix)>& prime_activation) {
         //Z derivative
-        const Matrix dZ = linalg::elementMultiply(dA, prime_activation(mlp_cache["Z"+std::to_string(layer)]));
+        const Matrix dZ = linalg::elementMultiply(dA, prime_activation(mlp_cache.at("Z"+std::to_string(layer))));
 
-        //(W)eight derivative
-        const Matrix dW = (layer == 1) ? linalg::matmul(dZ, mlp_cache["A"+std::to_string(layer)]) : linalg::matmul(dZ, a_in); //Use the original input for the last layer
+        //(W)eight derivative, dZ (n_out, m) against the layer's input (n_in, m)
+        const Matrix dW = linalg::matmul(dZ, linalg::T(a_in));
 
         // Update B and A gradients
         const Matrix dB = linalg::sum(dZ, 1); //Sum over dZ's columns
-        const Matrix dA_prev = linalg::matmul(mlp_cache["W"+std::to_string(layer)], dZ);
+        const Matrix dA_prev = linalg::matmul(linalg::T(mlp_cache.at("W"+std::to_string(layer))), dZ);
 
         // Storing gradients to return:
         matrixDict gradients;
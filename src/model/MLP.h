@@ -3,15 +3,22 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <cstdint>
+
+#include "linalg.h"
 
 namespace MLP {
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::map<std::string, Matrix> matrixDict;
 
-    Matrix he_normalization(const int rows, const int cols);
-    matrixDict init_mlp_params(const std::vector<int>& layer_dimensions, const int layer);
-    std::tuple<Matrix, matrixDict> Dense(Matrix a_in, matrixDict& params, const std::function<Matrix(Matrix)>& activation, const int layer, bool encountered);
-    matrixDict mlp_backward(Matrix a_in, Matrix dA, Matrix targets, matrixDict mlp_cache, const int layer, const std::function<Matrix(Matrix)>& prime_activation);
+    Matrix he_normalization(const int rows, const int cols, const std::string& name = "");
+    Matrix he_normalization(const int rows, const int cols, const std::string& name, const uint64_t seed);
+    matrixDict init_mlp_params(const std::vector<int>& layer_dimensions, const int layer, const uint64_t seed);
+    std::tuple<Matrix, matrixDict> Dense(const Matrix& a_in, const matrixDict& params, const std::function<Matrix(Matrix)>& activation, const int layer, bool encountered);
+    //a_in is the layer's input as Dense multiplied it (n_in, m), usually a transposed view, and dA its output's gradient (n_out, m). The returned
+    //"dA<layer>" is the gradient of a_in, which the layer below continues from
+    matrixDict mlp_backward(const linalg::View& a_in, const Matrix& dA, const matrixDict& mlp_cache, const int layer, const std::function<Matrix(Matrix)>& prime_activation);
 };
 
 #endif //MLP_H
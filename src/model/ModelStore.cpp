@@ -0,0 +1,384 @@
+#include "ModelStore.h"
+#include "LSTMCell.h"
+#include "activations.h"
+#include "linalg.h"
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define QUANTNET_HAS_MMAP 1
+#endif
+
+typedef ModelStore::Matrix Matrix;
+typedef ModelStore::Tensor3D Tensor3D;
+
+//Index entries are fixed-size and sorted by key, so a lookup is a binary search straight over the mapped file
+struct ModelStore::IndexEntry {
+    char key[MAX_KEY];
+    uint64_t offset; //Record start in the file
+    uint64_t size;   //Record bytes, including its weights
+};
+
+namespace {
+    constexpr char MAGIC[8] = {'Q', 'N', 'S', 'T', 'O', 'R', 'E', '1'};
+    constexpr uint32_t VERSION = 2; //2: the candidate gate reads Wc, version 1 models computed it from Wi
+    constexpr uint32_t ENDIAN_MARKER = 0x01020304; //Read back reversed on a machine of the other endianness
+    constexpr size_t ALIGNMENT = 64;            //Records and weight arrays start on cache-line boundaries
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t count;
+        uint64_t index_offset;
+    };
+
+    struct RecordHeader {
+        uint32_t num_layers;
+        uint32_t num_tensors;
+        int32_t input_dim; //Input features, Wf1's columns after the hidden state
+        uint32_t reserved;
+    };
+
+    struct LayerEntry {
+        uint32_t type; //LayerType
+        int32_t dim;   //layer_dims[i], the model's size for this layer
+    };
+
+    struct TensorEntry {
+        uint32_t layer;
+        uint32_t rows;
+        uint32_t cols;
+        char name[20];
+        uint64_t offset; //Weights in the file, rows * cols doubles, row-major
+    };
+
+    enum LayerType : uint32_t { LSTM = 0, RELU = 1, LINEAR = 2 };
+
+    uint32_t layerType(const std::string& type) {
+        if (type == "LSTM") return LSTM;
+        if (type == "Relu") return RELU;
+        if (type == "Linear") return LINEAR;
+        throw std::invalid_argument("Unknown layer type for the model store: " + type);
+    }
+
+    std::string layerName(const uint32_t type) {
+        switch (type) {
+            case LSTM: return "LSTM";
+            case RELU: return "Relu";
+            case LINEAR: return "Linear";
+            default: throw std::runtime_error("Corrupt model store: unknown layer type");
+        }
+    }
+
+    size_t alignUp(const size_t n) {
+        return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    void pad(std::ofstream& file, const size_t to) {
+        static const char zeros[ALIGNMENT] = {};
+        const size_t position = static_cast<size_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(to - position));
+    }
+
+    int compareKey(const std::string& key, const char* stored) {
+        return std::strncmp(key.c_str(), stored, ModelStore::MAX_KEY);
+    }
+}
+
+void ModelStore::write(const std::string& path, const std::vector<std::pair<std::string, const HybridModel*>>& models) {
+    std::vector<std::pair<std::string, const HybridModel*>> sorted = models;
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i].first.empty() || sorted[i].first.size() >= MAX_KEY) {
+            throw std::invalid_argument("Model store keys must be 1 to " + std::to_string(MAX_KEY - 1) + " characters: " + sorted[i].first);
+        }
+        if (i > 0 && sorted[i].first == sorted[i-1].first) {
+            throw std::invalid_argument("Duplicate model store key: " + sorted[i].first);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = ENDIAN_MARKER;
+    header.count = sorted.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<IndexEntry> index(sorted.size());
+    for (size_t k = 0; k < sorted.size(); k++) {
+        const HybridModel& model = *sorted[k].second;
+        const std::vector<std::string>& layer_types = model.layers();
+        const std::vector<HybridModel::matrixDict>& params = model.parameters();
+        if (params.size() != layer_types.size() || model.dimensions().size() != layer_types.size()) {
+            throw std::invalid_argument("Model " + sorted[k].first + " is not initialized");
+        }
+        if (layer_types.empty() || layer_types[0] != "LSTM") {
+            throw std::invalid_argument("Model " + sorted[k].first + " must start with an LSTM layer");
+        }
+
+        pad(file, alignUp(static_cast<size_t>(file.tellp())));
+        const size_t record_offset = static_cast<size_t>(file.tellp());
+
+        //Metadata first, then every weight array on its own aligned offset
+        std::vector<LayerEntry> layers;
+        std::vector<TensorEntry> tensors;
+        std::vector<const Matrix*> tensor_data;
+        for (size_t l = 0; l < layer_types.size(); l++) {
+            layers.push_back(LayerEntry{layerType(layer_types[l]), model.dimensions()[l]});
+            for (const auto& [name, matrix] : params[l]) {
+                TensorEntry entry = {};
+                if (name.size() >= sizeof(entry.name)) {
+                    throw std::invalid_argument("Parameter name too long for the model store: " + name);
+                }
+                entry.layer = static_cast<uint32_t>(l);
+                entry.rows = static_cast<uint32_t>(matrix.size());
+                entry.cols = static_cast<uint32_t>(matrix.empty() ? 0 : matrix[0].size());
+                std::memcpy(entry.name, name.c_str(), name.size());
+                tensors.push_back(entry);
+                tensor_data.push_back(&matrix);
+            }
+        }
+
+        size_t position = alignUp(record_offset + sizeof(RecordHeader) + layers.size() * sizeof(LayerEntry) + tensors.size() * sizeof(TensorEntry));
+        for (TensorEntry& entry : tensors) {
+            entry.offset = position;
+            position = alignUp(position + static_cast<size_t>(entry.rows) * entry.cols * sizeof(double));
+        }
+
+        const Matrix& Wf = params[0].at("Wf1");
+        const int32_t input_dim = static_cast<int32_t>(Wf[0].size() - Wf.size());
+        const RecordHeader record = {static_cast<uint32_t>(layers.size()), static_cast<uint32_t>(tensors.size()), input_dim, 0};
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        file.write(reinterpret_cast<const char*>(layers.data()), static_cast<std::streamsize>(layers.size() * sizeof(LayerEntry)));
+        file.write(reinterpret_cast<const char*>(tensors.data()), static_cast<std::streamsize>(tensors.size() * sizeof(TensorEntry)));
+        for (size_t t = 0; t < tensors.size(); t++) {
+            pad(file, tensors[t].offset);
+            for (const std::vector<double>& row : *tensor_data[t]) {
+                file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(double)));
+            }
+        }
+
+        IndexEntry& entry = index[k];
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.key, sorted[k].first.c_str(), sorted[k].first.size());
+        entry.offset = record_offset;
+        entry.size = static_cast<size_t>(file.tellp()) - record_offset;
+    }
+
+    pad(file, alignUp(static_cast<size_t>(file.tellp())));
+    header.index_offset = static_cast<uint64_t>(file.tellp());
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file.good()) {
+        throw std::runtime_error("Failed writing model store " + path);
+    }
+}
+
+ModelStore::ModelStore(const std::string& path, const size_t capacity) : capacity(std::max<size_t>(1, capacity)) {
+#ifdef QUANTNET_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open model store " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("Model store " + path + " is too small");
+    }
+    file_size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); //The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not memory-map model store " + path);
+    }
+    base = static_cast<const unsigned char*>(mapping);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open model store " + path);
+    }
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    base = fallback.data();
+    file_size = fallback.size();
+    if (file_size < sizeof(FileHeader)) {
+        throw std::runtime_error("Model store " + path + " is too small");
+    }
+#endif
+
+    //Only the header is validated here, models are checked when they are first resolved
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.byte_order == ENDIAN_MARKER && header.version != VERSION) {
+#ifdef QUANTNET_HAS_MMAP
+        ::munmap(const_cast<unsigned char*>(base), file_size);
+#endif
+        throw std::runtime_error("Model store " + path + " has version " + std::to_string(header.version) + ", expected " +
+                                 std::to_string(VERSION) + " (version 1 predates the separate candidate gate weights)");
+    }
+    const bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                       header.version == VERSION && header.byte_order == ENDIAN_MARKER &&
+                       header.index_offset % alignof(IndexEntry) == 0 && header.index_offset <= file_size &&
+                       header.count <= (file_size - header.index_offset) / sizeof(IndexEntry);
+    if (!valid) {
+#ifdef QUANTNET_HAS_MMAP
+        ::munmap(const_cast<unsigned char*>(base), file_size);
+#endif
+        throw std::runtime_error("Not a compatible model store: " + path);
+    }
+    index = reinterpret_cast<const IndexEntry*>(base + header.index_offset);
+    count = header.count;
+}
+
+ModelStore::~ModelStore() {
+#ifdef QUANTNET_HAS_MMAP
+    if (base != nullptr) {
+        ::munmap(const_cast<unsigned char*>(base), file_size);
+        base = nullptr;
+    }
+#endif
+}
+
+const ModelStore::IndexEntry* ModelStore::find(const std::string& key) const {
+    const IndexEntry* end = index + count;
+    const IndexEntry* entry = std::lower_bound(index, end, key, [](const IndexEntry& e, const std::string& k) {
+        return compareKey(k, e.key) > 0;
+    });
+    return (entry != end && compareKey(key, entry->key) == 0) ? entry : nullptr;
+}
+
+bool ModelStore::contains(const std::string& key) const {
+    return find(key) != nullptr;
+}
+
+std::shared_ptr<const ModelStore::Model> ModelStore::load(const IndexEntry& entry) const {
+    if (entry.offset % ALIGNMENT != 0 || entry.offset > file_size || entry.size > file_size - entry.offset || entry.size < sizeof(RecordHeader)) {
+        throw std::runtime_error("Corrupt model store: record out of range");
+    }
+    const unsigned char* record = base + entry.offset;
+    const unsigned char* record_end = record + entry.size;
+
+#ifdef QUANTNET_HAS_MMAP
+    ::madvise(const_cast<unsigned char*>(record), entry.size, MADV_WILLNEED);
+#endif
+
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    const size_t metadata = sizeof(RecordHeader) + header.num_layers * sizeof(LayerEntry) + header.num_tensors * sizeof(TensorEntry);
+    if (metadata > entry.size) {
+        throw std::runtime_error("Corrupt model store: record metadata out of range");
+    }
+    const LayerEntry* layers = reinterpret_cast<const LayerEntry*>(record + sizeof(RecordHeader));
+    const TensorEntry* tensors = reinterpret_cast<const TensorEntry*>(layers + header.num_layers);
+
+    auto model = std::make_shared<Model>();
+    for (uint32_t l = 0; l < header.num_layers; l++) {
+        model->layer_types.push_back(layerName(layers[l].type));
+        model->layer_dims.push_back(layers[l].dim);
+    }
+    model->params.resize(header.num_layers);
+
+    for (uint32_t t = 0; t < header.num_tensors; t++) {
+        const TensorEntry& tensor = tensors[t];
+        const size_t bytes = static_cast<size_t>(tensor.rows) * tensor.cols * sizeof(double);
+        if (tensor.layer >= header.num_layers || tensor.offset % alignof(double) != 0 || tensor.offset < entry.offset ||
+            tensor.offset > file_size || bytes > static_cast<size_t>(record_end - (base + tensor.offset))) {
+            throw std::runtime_error("Corrupt model store: weights out of range");
+        }
+        const std::string name(tensor.name, strnlen(tensor.name, sizeof(tensor.name)));
+        const double* data = reinterpret_cast<const double*>(base + tensor.offset);
+        model->params[tensor.layer].emplace(name, linalg::View(data, tensor.rows, tensor.cols, tensor.cols));
+    }
+    return model;
+}
+
+void ModelStore::release(const IndexEntry& entry) const {
+#ifdef QUANTNET_HAS_MMAP
+    //Only whole pages inside the record are dropped, they are read back from the file if touched again
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t begin = (entry.offset + page - 1) / page * page;
+    const size_t end = (entry.offset + entry.size) / page * page;
+    if (end > begin) {
+        ::madvise(const_cast<unsigned char*>(base + begin), end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+std::shared_ptr<const ModelStore::Model> ModelStore::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto hit = resident.find(key);
+    if (hit != resident.end()) {
+        lru.splice(lru.begin(), lru, hit->second);
+        return hit->second->second;
+    }
+
+    const IndexEntry* entry = find(key);
+    if (entry == nullptr) {
+        throw std::out_of_range("No model for key " + key + " in the model store");
+    }
+    std::shared_ptr<const Model> model = load(*entry);
+    lru.emplace_front(key, model);
+    resident[key] = lru.begin();
+
+    if (lru.size() > capacity) {
+        const std::string& evicted = lru.back().first;
+        release(*find(evicted));
+        resident.erase(evicted);
+        lru.pop_back();
+    }
+    return model;
+}
+
+Matrix ModelStore::Model::predict(const Tensor3D& x) const {
+    //Same layer rules as HybridModel::forward: LSTM layers read the original input, the first one starts from a
+    //zero state and later ones from the previous layer's last hidden state; Dense layers follow
+    if (layer_types.empty() || layer_types[0] != "LSTM") {
+        throw std::invalid_argument("Stored model must start with an LSTM layer");
+    }
+    const size_t m = x.size(), timesteps = x[0].size(), n_x = x[0][0].size();
+
+    std::vector<Matrix> x_t(timesteps, Matrix(m, std::vector<double>(n_x)));
+    for (size_t i = 0; i < m; i++) {
+        for (size_t t = 0; t < timesteps; t++) {
+            x_t[t][i] = x[i][t];
+        }
+    }
+
+    Matrix a = linalg::generateZeros(m, params[0].at("Wy1").cols());
+    Matrix a_out;
+    for (size_t i = 1; i <= layer_types.size(); i++) {
+        const std::string layer = std::to_string(i);
+        const std::map<std::string, linalg::View>& p = params[i-1];
+
+        if (layer_types[i-1] == "LSTM") {
+            const LSTMCell::CellWeights weights{p.at("Wf"+layer), p.at("bf"+layer), p.at("Wi"+layer), p.at("bi"+layer),
+                                                p.at("Wc"+layer), p.at("bc"+layer), p.at("Wo"+layer), p.at("bo"+layer)};
+            Matrix c = linalg::generateZeros(m, a[0].size());
+            for (size_t t = 0; t < timesteps; t++) {
+                std::tie(a, c) = LSTMCell::lstm_cell_step(x_t[t], a, c, weights);
+            }
+        } else {
+            const bool after_lstm = layer_types[i-2] == "LSTM";
+            const Matrix Z = linalg::add(linalg::matmul(p.at("W"+layer), after_lstm ? linalg::T(a) : linalg::View(a_out)), p.at("b"+layer));
+            a_out = (layer_types[i-1] == "Relu") ? activations::relu(Z) : Z;
+        }
+    }
+    return a_out;
+}
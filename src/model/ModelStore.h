@@ -0,0 +1,78 @@
+#ifndef MODELSTORE_H
+#define MODELSTORE_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <utility>
+
+#include "linalg.h"
+#include "HybridModel.h"
+
+/*
+ * Store for many trained models (e.g. one per ticker) packed into a single file that is memory-mapped read-only.
+ *
+ * Layout: a fixed header, the models' weight records, then an index of (key -> offset, size) entries sorted by key.
+ * Opening maps the file and checks the header only, so startup cost does not depend on the number of models.
+ * A model is resolved on first request by binary search in the mapped index; its weights stay in the mapping and
+ * are read through linalg::View, never copied. Resolved models are kept in an LRU of `capacity` entries, and the
+ * pages of evicted models are released back to the OS.
+ */
+class ModelStore {
+public:
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    //A model whose parameters are views into the store's mapping. Valid while the store is open
+    struct Model {
+        std::vector<std::string> layer_types;
+        std::vector<int> layer_dims; //As HybridModel::dimensions()
+        std::vector<std::map<std::string, linalg::View>> params; //Per layer, e.g. params[0].at("Wf1")
+
+        //Same forward pass as HybridModel::predict, shape (1, m). Thread-safe
+        Matrix predict(const Tensor3D& x) const;
+    };
+
+    //Pack models into a store file, keys must be unique and at most MAX_KEY - 1 characters
+    static void write(const std::string& path, const std::vector<std::pair<std::string, const HybridModel*>>& models);
+
+    explicit ModelStore(const std::string& path, const size_t capacity = 256);
+    ~ModelStore();
+
+    ModelStore(const ModelStore&) = delete;
+    ModelStore& operator=(const ModelStore&) = delete;
+
+    size_t size() const { return count; }
+    bool contains(const std::string& key) const;
+
+    //Resolve a model, loading it on first use. Thread-safe; throws std::out_of_range for unknown keys
+    std::shared_ptr<const Model> get(const std::string& key);
+
+    static constexpr size_t MAX_KEY = 24;
+
+private:
+    struct IndexEntry;
+
+    const IndexEntry* find(const std::string& key) const;
+    std::shared_ptr<const Model> load(const IndexEntry& entry) const;
+    void release(const IndexEntry& entry) const;
+
+    const unsigned char* base = nullptr;
+    size_t file_size = 0;
+    const IndexEntry* index = nullptr;
+    size_t count = 0;
+    std::vector<unsigned char> fallback; //File contents when memory mapping is unavailable
+
+    //LRU of resolved models, most recent at the front
+    const size_t capacity;
+    std::mutex mutex;
+    std::list<std::pair<std::string, std::shared_ptr<const Model>>> lru;
+    std::unordered_map<std::string, decltype(lru)::iterator> resident;
+};
+
+#endif //MODELSTORE_H
@@ -0,0 +1,79 @@
+#include "ProjectionCache.h"
+#include "linalg.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+namespace ProjectionCache {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::map<std::string, Matrix> matrixDict;
+
+    Table build(const Matrix& data, const std::vector<size_t>& window_starts, const size_t timesteps, const matrixDict& params, const int layer) {
+        const std::string l = std::to_string(layer);
+        const Matrix& Wf = params.at("Wf"+l);
+        Table table;
+        table.n_a = Wf.size();
+        table.timesteps = timesteps;
+        table.windows = window_starts.size();
+        if (window_starts.empty() || timesteps == 0) {
+            return table;
+        }
+
+        for (const size_t start : window_starts) {
+            if (start + timesteps > data.size()) {
+                throw std::out_of_range("Window starting at row " + std::to_string(start) + " runs past the end of the data");
+            }
+            for (size_t t = 0; t < timesteps; t++) {
+                table.rows.push_back(start + t);
+            }
+        }
+        std::sort(table.rows.begin(), table.rows.end());
+        table.rows.erase(std::unique(table.rows.begin(), table.rows.end()), table.rows.end());
+
+        table.slot.resize(window_starts.size() * timesteps);
+        for (size_t k = 0; k < window_starts.size(); k++) {
+            const size_t first = std::lower_bound(table.rows.begin(), table.rows.end(), window_starts[k]) - table.rows.begin();
+            for (size_t t = 0; t < timesteps; t++) {
+                table.slot[k * timesteps + t] = first + t; //The rows of a window are consecutive in the sorted list
+            }
+        }
+
+        Matrix X(table.rows.size());
+        for (size_t r = 0; r < table.rows.size(); r++) {
+            X[r] = data[table.rows[r]];
+        }
+
+        //Columns n_a.. of each gate weight multiply the input, (rows, n_x) * (n_x, n_a)
+        auto project = [&](const Matrix& W) {
+            return linalg::matmul(X, linalg::T(linalg::sliceColsView(W, table.n_a, W[0].size())));
+        };
+        table.f = project(Wf);
+        table.i = project(params.at("Wi"+l));
+        table.c = project(params.at("Wc"+l));
+        table.o = project(params.at("Wo"+l));
+        return table;
+    }
+
+    LSTMCell::GateInputs gather(const Table& table, const size_t timestep) {
+        const size_t m = table.windows;
+        LSTMCell::GateInputs inputs;
+        inputs.f = linalg::generateZeros(table.n_a, m);
+        inputs.i = linalg::generateZeros(table.n_a, m);
+        inputs.c = linalg::generateZeros(table.n_a, m);
+        inputs.o = linalg::generateZeros(table.n_a, m);
+
+        //Gate inputs are in the (n_a, m) gate layout
+        for (size_t k = 0; k < m; k++) {
+            const size_t r = table.slot[k * table.timesteps + timestep];
+            for (size_t j = 0; j < table.n_a; j++) {
+                inputs.f[j][k] = table.f[r][j];
+                inputs.i[j][k] = table.i[r][j];
+                inputs.c[j][k] = table.c[r][j];
+                inputs.o[j][k] = table.o[r][j];
+            }
+        }
+        return inputs;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef PROJECTIONCACHE_H
+#define PROJECTIONCACHE_H
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstddef>
+
+#include "LSTMCell.h"
+
+/*
+ * Input-to-gate projections of the first LSTM layer, shared by overlapping windows.
+ *
+ * Window k of generate_tensor covers dataset rows k .. k + T - 1, so consecutive windows share T - 1 rows and the
+ * input half of each gate product, W_g[:, n_a:] * x_row, is otherwise recomputed for the same row up to T times.
+ * A Table holds it once for every distinct row of a batch of windows, computed as one matrix product per gate, and
+ * gather() assembles each timestep's LSTMCell::GateInputs from it. A table belongs to the parameters it was built
+ * from, so it has to be rebuilt after every optimizer step.
+ */
+namespace ProjectionCache {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::map<std::string, Matrix> matrixDict;
+
+    struct Table {
+        size_t n_a = 0;
+        size_t timesteps = 0;
+        size_t windows = 0;
+        std::vector<size_t> rows; //Distinct dataset rows used by the windows, sorted
+        Matrix f, i, c, o;        //(rows.size(), n_a) projections of those rows
+        std::vector<size_t> slot; //slot[k * timesteps + t] = index into rows of row t of window k
+
+        size_t projected() const { return rows.size(); }       //Row projections computed
+        size_t uncached() const { return windows * timesteps; } //Row projections computed without the table
+    };
+
+    //Projections of the rows of data used by the windows starting at window_starts, for params of layer
+    Table build(const Matrix& data, const std::vector<size_t>& window_starts, const size_t timesteps, const matrixDict& params, const int layer);
+
+    //Projections of row `timestep` of every window, in window order
+    LSTMCell::GateInputs gather(const Table& table, const size_t timestep);
+}
+
+#endif //PROJECTIONCACHE_H
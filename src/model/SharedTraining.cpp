@@ -0,0 +1,94 @@
+#include "SharedTraining.h"
+#include "HybridModel.h"
+#include "parallel.h"
+#include "../framework/DataFramework.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <variant>
+#include <limits>
+#include <stdexcept>
+#include <exception>
+
+namespace SharedTraining {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    Dataset share(Tensor3D X, Matrix Y) {
+        if (X.empty() || Y.size() < X.size()) {
+            throw std::invalid_argument("Shared dataset needs samples and a target row for every sample");
+        }
+        Dataset data;
+        data.X = std::make_shared<const std::variant<Matrix, Tensor3D>>(std::move(X));
+        data.Y = std::make_shared<const Matrix>(std::move(Y));
+        return data;
+    }
+
+    Dataset load(const std::string& filename, const int timesteps) {
+        auto [x_features, Y] = DataFramework::preprocessFeaturesFromFile(filename);
+        return share(DataFramework::generate_tensor(x_features, timesteps), std::move(Y));
+    }
+
+    Group make_group(const Dataset& data, const std::vector<ModelSpec>& specs, const int batch_size) {
+        Group group;
+        group.data = data;
+        group.batch_size = batch_size;
+        group.models.resize(specs.size());
+        group.errors.resize(specs.size());
+
+        //Replicas are initialised on the pool so their parameters and Adam moments are first-touched by workers
+        //spread over the NUMA nodes (see parallel::set_pinning) rather than all on the caller's node
+        const int n_features = data.tensor()[0][0].size();
+        parallel::parallel_for(0, specs.size(), 1, [&](const size_t lo, const size_t hi) {
+            for (size_t k = lo; k < hi; k++) {
+                std::vector<int> layer_dims = {n_features};
+                layer_dims.insert(layer_dims.end(), specs[k].layer_dims.begin(), specs[k].layer_dims.end());
+
+                HybridModel& model = group.models[k];
+                model.init_data(data.X, data.Y, batch_size);
+                model.init_hidden_units(specs[k].hidden_units);
+                model.init_layers(specs[k].layer_types, layer_dims);
+                model.initialize_network(k); //Replica k, independent of which worker initialises it
+                model.init_learning_rate(specs[k].learning_rate);
+                model.init_Adam();
+            }
+        });
+        return group;
+    }
+
+    std::vector<double> train_epoch(Group& group, const int seed) {
+        const size_t K = group.models.size();
+
+        //Shuffled and split once for the whole group
+        std::vector<HybridModel::minibatch> minibatches = HybridModel::generate_minibatches(group.data.tensor(), *group.data.Y, group.batch_size, seed);
+
+        for (auto& [X_batch, Y_batch] : minibatches) {
+            //Wrapped once, every model reads the same batch without copying it
+            const std::variant<Tensor3D, Matrix> batch = std::move(X_batch);
+
+            parallel::parallel_for(0, K, 1, [&](const size_t lo, const size_t hi) {
+                for (size_t k = lo; k < hi; k++) {
+                    if (!group.errors[k].empty()) {
+                        continue;
+                    }
+                    try {
+                        HybridModel& model = group.models[k];
+                        model.forward_prop(batch);
+                        model.loss(Y_batch);
+                        model.back_prop();
+                        model.optimize();
+                    } catch (const std::exception& e) {
+                        group.errors[k] = e.what();
+                    }
+                }
+            });
+        }
+
+        std::vector<double> losses(K);
+        for (size_t k = 0; k < K; k++) {
+            losses[k] = group.errors[k].empty() ? group.models[k].return_avg_loss() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return losses;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SHAREDTRAINING_H
+#define SHAREDTRAINING_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <variant>
+
+#include "HybridModel.h"
+
+/*
+ * Lock-step training of several models on one dataset.
+ *
+ * The data is parsed, engineered, scaled and windowed once and held behind shared read-only pointers, so the K
+ * models of a group reference a single copy. Each epoch is shuffled once for the whole group and every minibatch
+ * is built once, then consumed by all K models (in parallel) before the next one is read, so the input data
+ * streams through memory once per batch instead of once per model.
+ */
+namespace SharedTraining {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    struct Dataset {
+        std::shared_ptr<const std::variant<Matrix, Tensor3D>> X;
+        std::shared_ptr<const Matrix> Y;
+
+        const Tensor3D& tensor() const { return std::get<Tensor3D>(*X); }
+    };
+
+    Dataset share(Tensor3D X, Matrix Y);
+    Dataset load(const std::string& filename, const int timesteps = 30);
+
+    //Per-model settings, the input dimension is taken from the dataset
+    struct ModelSpec {
+        std::vector<std::string> layer_types = {"LSTM", "LSTM", "Relu", "Relu", "Linear"};
+        std::vector<int> layer_dims = {64, 64, 32, 1}; //Layer sizes after the input
+        int hidden_units = 64;
+        double learning_rate = 3e-4;
+    };
+
+    struct Group {
+        Dataset data;
+        int batch_size = 32;
+        std::vector<HybridModel> models;
+        std::vector<std::string> errors; //Per model, set once a model fails; it then sits out the remaining batches
+    };
+
+    Group make_group(const Dataset& data, const std::vector<ModelSpec>& specs, const int batch_size);
+
+    //One epoch over the shared data, returns each model's return_avg_loss() (NaN for failed models)
+    std::vector<double> train_epoch(Group& group, const int seed);
+}
+
+#endif //SHAREDTRAINING_H
@@ -0,0 +1,370 @@
+#include "Sweep.h"
+#include "HybridModel.h"
+#include "parallel.h"
+#include "linalg.h"
+#include "rng.h"
+#include "../framework/DataFramework.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <exception>
+#include <cmath>
+#include <limits>
+
+namespace Sweep {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    namespace {
+        //Chronological train/validation split of one windowing of the features
+        struct Dataset {
+            Tensor3D X_train;
+            Matrix Y_train;
+            Tensor3D X_val;
+            std::vector<double> Y_val;
+        };
+
+        Dataset make_dataset(const Matrix& x_features, const Matrix& Y, const int timesteps, const double validation_fraction) {
+            Tensor3D X = DataFramework::generate_tensor(x_features, timesteps);
+            const size_t n_val = static_cast<size_t>(X.size() * validation_fraction);
+            const size_t n_train = X.size() - n_val;
+            if (n_train == 0 || n_val == 0) {
+                throw std::invalid_argument("Sweep validation split leaves an empty train or validation set");
+            }
+
+            Dataset data;
+            data.X_train.assign(std::make_move_iterator(X.begin()), std::make_move_iterator(X.begin() + n_train));
+            data.X_val.assign(std::make_move_iterator(X.begin() + n_train), std::make_move_iterator(X.end()));
+            data.Y_train.assign(Y.begin(), Y.begin() + n_train);
+            for (size_t i = n_train; i < X.size(); i++) {
+                data.Y_val.push_back(Y[i][0]);
+            }
+            return data;
+        }
+
+        //Validation losses recorded at each rung, shared by all running trials
+        class RungTable {
+        public:
+            RungTable(const size_t num_rungs, const int eta) : losses(num_rungs), eta(eta) {}
+
+            //Record loss at rung and decide whether the trial continues: it must rank within the best
+            //max(1, n / eta) of the n trials that have reached this rung so far
+            bool report(const size_t rung, double loss) {
+                if (std::isnan(loss)) {
+                    loss = std::numeric_limits<double>::infinity(); //Diverged trials rank last
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                std::vector<double>& recorded = losses[rung];
+                recorded.push_back(loss);
+
+                std::vector<double> sorted = recorded;
+                const size_t keep = std::max<size_t>(1, recorded.size() / eta);
+                std::nth_element(sorted.begin(), sorted.begin() + (keep - 1), sorted.end());
+                return loss <= sorted[keep - 1];
+            }
+
+        private:
+            std::vector<std::vector<double>> losses;
+            const int eta;
+            std::mutex mutex;
+        };
+
+        std::string join(const std::vector<int>& values, const char separator) {
+            std::string joined;
+            for (size_t i = 0; i < values.size(); i++) {
+                joined += (i == 0 ? "" : std::string(1, separator)) + std::to_string(values[i]);
+            }
+            return joined;
+        }
+
+        std::vector<int> rung_epochs(const Config& config) {
+            std::vector<int> rungs;
+            for (long long epochs = config.min_epochs; epochs < config.max_epochs; epochs *= config.eta) {
+                rungs.push_back(static_cast<int>(epochs));
+            }
+            return rungs;
+        }
+
+        double validation_loss(const HybridModel& model, const Dataset& data) {
+            return HybridModel::MSE(model.predict(data.X_val)[0], data.Y_val); //Predictions are (1, m)
+        }
+
+        //Every combination of hidden_units and layer_dims must give a network forward_prop can run, checked before
+        //any trial starts so a bad candidate is not reported as failed trials. The full dims are n_features followed
+        //by the candidate: an LSTM after the first reads the features, a Dense layer after an LSTM its hidden state
+        void validate_space(const SearchSpace& space, const Config& config, const int n_features) {
+            const std::vector<std::string>& types = config.layer_types;
+            if (types.empty() || types[0] != "LSTM") {
+                throw std::invalid_argument("Sweep layer_types must start with an LSTM layer");
+            }
+            for (const int hidden : space.hidden_units) {
+                if (hidden <= 0) {
+                    throw std::invalid_argument("Sweep hidden_units must be positive");
+                }
+            }
+            for (const std::vector<int>& candidate : space.layer_dims) {
+                if (candidate.size() + 1 != types.size() || candidate.back() != 1) {
+                    throw std::invalid_argument("Sweep layer_dims {" + join(candidate, ',') + "} must hold one size per layer type after the first, ending in 1");
+                }
+                std::vector<int> dims = {n_features};
+                dims.insert(dims.end(), candidate.begin(), candidate.end());
+
+                for (size_t i = 1; i < types.size(); i++) {
+                    if (dims[i] <= 0) {
+                        throw std::invalid_argument("Sweep layer_dims {" + join(candidate, ',') + "} must be positive");
+                    }
+                    if (types[i] == "LSTM" && (types[i-1] != "LSTM" || dims[i-1] != n_features)) {
+                        throw std::invalid_argument("Sweep layer_dims {" + join(candidate, ',') + "}: LSTM layer " + std::to_string(i + 1) +
+                                                    " must follow an LSTM layer of size n_features (" + std::to_string(n_features) + ")");
+                    }
+                    if (types[i] != "LSTM" && types[i-1] == "LSTM") {
+                        for (const int hidden : space.hidden_units) {
+                            if (dims[i-1] != hidden) {
+                                throw std::invalid_argument("Sweep layer_dims {" + join(candidate, ',') + "}: layer " + std::to_string(i) +
+                                                            " feeds a Dense layer and must equal hidden_units " + std::to_string(hidden));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        void init_model(HybridModel& model, const TrialResult& result, const Dataset& data, const int n_features, const Config& config) {
+            std::vector<int> layer_dims = {n_features};
+            layer_dims.insert(layer_dims.end(), result.params.layer_dims.begin(), result.params.layer_dims.end());
+
+            model.init_data(data.X_train, data.Y_train, result.params.batch_size);
+            model.init_hidden_units(result.params.hidden_units);
+            model.init_layers(config.layer_types, layer_dims);
+            model.initialize_network(result.id);
+            model.init_learning_rate(result.params.learning_rate);
+            model.init_Adam();
+        }
+
+        //Train from the trial's current epoch up to and including epoch `until`
+        void train_until(HybridModel& model, TrialResult& result, const Dataset& data, const int until, const Config& config) {
+            for (int epoch = result.epochs + 1; epoch <= until; epoch++) {
+                model.train_epoch(data.X_train, data.Y_train, static_cast<int>(config.seed) + epoch);
+                result.epochs = epoch;
+                result.train_loss = model.return_avg_loss();
+            }
+        }
+
+        void run_trial(TrialResult& result, const Dataset& data, const int n_features, const std::vector<int>& rungs, RungTable& table, const Config& config) {
+            HybridModel model;
+            init_model(model, result, data, n_features, config);
+
+            for (size_t rung = 0; rung < rungs.size(); rung++) {
+                train_until(model, result, data, rungs[rung], config);
+                result.validation_loss = validation_loss(model, data);
+                if (!table.report(rung, result.validation_loss)) {
+                    result.status = Status::Stopped;
+                    return;
+                }
+            }
+            train_until(model, result, data, config.max_epochs, config);
+            result.validation_loss = validation_loss(model, data);
+            result.status = Status::Completed;
+        }
+
+        //Synchronous successive halving for parallel::deterministic(): all surviving trials train to a rung, then
+        //the best max(1, n / eta) of the n survivors continue, ties broken by trial id. Decisions only depend on
+        //the losses, never on which trial finished first
+        void run_synchronous(std::vector<TrialResult>& results, const std::map<int, Dataset>& datasets, const int n_features, const std::vector<int>& rungs, const Config& config) {
+            std::vector<HybridModel> models(results.size());
+            std::vector<size_t> active;
+            for (size_t t = 0; t < results.size(); t++) {
+                active.push_back(t);
+            }
+
+            auto advance = [&](const int until) {
+                parallel::parallel_for(0, active.size(), 1, [&](const size_t lo, const size_t hi) {
+                    for (size_t k = lo; k < hi; k++) {
+                        TrialResult& result = results[active[k]];
+                        const Dataset& data = datasets.at(result.params.timesteps);
+                        try {
+                            if (result.epochs == 0) {
+                                init_model(models[active[k]], result, data, n_features, config);
+                            }
+                            train_until(models[active[k]], result, data, until, config);
+                            result.validation_loss = validation_loss(models[active[k]], data);
+                        } catch (const std::exception& e) {
+                            result.status = Status::Failed;
+                            result.error = e.what();
+                        }
+                    }
+                });
+                active.erase(std::remove_if(active.begin(), active.end(), [&](const size_t t) { return !results[t].error.empty(); }), active.end());
+            };
+
+            for (const int until : rungs) {
+                advance(until);
+                auto rank = [&](const size_t t) {
+                    const double loss = results[t].validation_loss;
+                    return std::isnan(loss) ? std::numeric_limits<double>::infinity() : loss;
+                };
+                std::stable_sort(active.begin(), active.end(), [&](const size_t a, const size_t b) { return rank(a) < rank(b); });
+                const size_t keep = std::min(active.size(), std::max<size_t>(1, active.size() / config.eta));
+                for (size_t k = keep; k < active.size(); k++) {
+                    results[active[k]].status = Status::Stopped;
+                    models[active[k]] = HybridModel(); //Free the stopped trial's parameters
+                }
+                active.resize(keep);
+                std::sort(active.begin(), active.end());
+            }
+
+            advance(config.max_epochs);
+            for (const size_t t : active) {
+                results[t].status = Status::Completed;
+            }
+        }
+
+        std::string status_name(const Status status) {
+            switch (status) {
+                case Status::Completed: return "completed";
+                case Status::Stopped: return "stopped";
+                default: return "failed";
+            }
+        }
+
+        std::string json_escape(const std::string& s) {
+            std::string escaped;
+            for (const char c : s) {
+                if (c == '"' || c == '\\') {
+                    escaped += '\\';
+                    escaped += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped += ' ';
+                } else {
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        //JSON has no NaN or Infinity, a loss that never got a value (or diverged) is written as null
+        std::string json_number(const double value) {
+            if (!std::isfinite(value)) {
+                return "null";
+            }
+            std::ostringstream out;
+            out.precision(std::numeric_limits<double>::max_digits10);
+            out << value;
+            return out.str();
+        }
+
+        std::ofstream open_output(const std::string& path) {
+            std::ofstream file(path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + path + " for writing");
+            }
+            file.precision(std::numeric_limits<double>::max_digits10); //Round-trips every double exactly
+            return file;
+        }
+    }
+
+    std::vector<TrialParams> sample_trials(const SearchSpace& space, const Config& config) {
+        if (space.hidden_units.empty() || space.layer_dims.empty() || space.learning_rate.empty() || space.batch_size.empty() || space.timesteps.empty()) {
+            throw std::invalid_argument("Every hyperparameter in the search space needs at least one candidate");
+        }
+
+        //Trial t draws its k-th choice from the counter stream (seed, t, k), independent of the other trials
+        std::vector<TrialParams> trials;
+        for (int t = 0; t < config.num_trials; t++) {
+            auto pick = [&](const size_t k, const size_t n) {
+                return std::min(n - 1, static_cast<size_t>(rng::uniform(config.seed, t, k) * n));
+            };
+            TrialParams params;
+            params.hidden_units = space.hidden_units[pick(0, space.hidden_units.size())];
+            params.layer_dims = space.layer_dims[pick(1, space.layer_dims.size())];
+            params.learning_rate = space.learning_rate[pick(2, space.learning_rate.size())];
+            params.batch_size = space.batch_size[pick(3, space.batch_size.size())];
+            params.timesteps = space.timesteps[pick(4, space.timesteps.size())];
+            trials.push_back(params);
+        }
+        return trials;
+    }
+
+    std::vector<TrialResult> run(const Matrix& x_features, const Matrix& Y, const SearchSpace& space, const Config& config) {
+        if (config.eta < 2 || config.min_epochs < 1 || config.max_epochs < config.min_epochs) {
+            throw std::invalid_argument("Sweep needs eta >= 2 and 1 <= min_epochs <= max_epochs");
+        }
+        if (x_features.empty()) {
+            throw std::invalid_argument("Sweep needs a non-empty feature matrix");
+        }
+        const int n_features = static_cast<int>(x_features[0].size());
+        const std::vector<TrialParams> trials = sample_trials(space, config);
+        validate_space(space, config, n_features);
+
+        //Window the data once per distinct timesteps value, trials only read it
+        std::map<int, Dataset> datasets;
+        for (const TrialParams& params : trials) {
+            if (datasets.find(params.timesteps) == datasets.end()) {
+                datasets.emplace(params.timesteps, make_dataset(x_features, Y, params.timesteps, config.validation_fraction));
+            }
+        }
+
+
+        const std::vector<int> rungs = rung_epochs(config);
+
+        std::vector<TrialResult> results(trials.size());
+        for (size_t t = 0; t < trials.size(); t++) {
+            results[t].id = static_cast<int>(t);
+            results[t].params = trials[t];
+        }
+        if (parallel::deterministic()) {
+            run_synchronous(results, datasets, n_features, rungs, config);
+            return results;
+        }
+
+        RungTable table(rungs.size(), config.eta);
+        parallel::parallel_for(0, trials.size(), 1, [&](const size_t lo, const size_t hi) {
+            for (size_t t = lo; t < hi; t++) {
+                try {
+                    run_trial(results[t], datasets.at(trials[t].timesteps), n_features, rungs, table, config);
+                } catch (const std::exception& e) {
+                    results[t].status = Status::Failed;
+                    results[t].error = e.what();
+                }
+            }
+        });
+
+        return results;
+    }
+
+    void write_csv(const std::string& path, const std::vector<TrialResult>& results) {
+        std::ofstream file = open_output(path);
+        file << "id,status,epochs,hidden_units,layer_dims,learning_rate,batch_size,timesteps,train_loss,validation_loss,error\n";
+        for (const TrialResult& r : results) {
+            std::string error = r.error;
+            for (size_t pos = 0; (pos = error.find('"', pos)) != std::string::npos; pos += 2) {
+                error.insert(pos, "\"");
+            }
+            file << r.id << ',' << status_name(r.status) << ',' << r.epochs << ','
+                 << r.params.hidden_units << ',' << join(r.params.layer_dims, ';') << ','
+                 << r.params.learning_rate << ',' << r.params.batch_size << ',' << r.params.timesteps << ','
+                 << r.train_loss << ',' << r.validation_loss << ",\"" << error << "\"\n";
+        }
+    }
+
+    void write_json(const std::string& path, const std::vector<TrialResult>& results) {
+        std::ofstream file = open_output(path);
+        file << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const TrialResult& r = results[i];
+            file << "  {\"id\": " << r.id << ", \"status\": \"" << status_name(r.status) << "\", \"epochs\": " << r.epochs
+                 << ", \"hidden_units\": " << r.params.hidden_units << ", \"layer_dims\": [" << join(r.params.layer_dims, ',') << "]"
+                 << ", \"learning_rate\": " << r.params.learning_rate << ", \"batch_size\": " << r.params.batch_size
+                 << ", \"timesteps\": " << r.params.timesteps << ", \"train_loss\": " << json_number(r.train_loss)
+                 << ", \"validation_loss\": " << json_number(r.validation_loss) << ", \"error\": \"" << json_escape(r.error) << "\"}"
+                 << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "]\n";
+    }
+}
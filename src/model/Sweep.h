@@ -0,0 +1,74 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/*
+ * Hyperparameter search with asynchronous successive halving (ASHA, Li et al. 2018).
+ *
+ * Trials are sampled from a discrete search space and run concurrently on parallel::pool(), each with its own
+ * HybridModel. Every trial is checkpointed at rungs of min_epochs * eta^k epochs: on reaching a rung it records
+ * its validation loss there and only continues if it is within the best 1/eta of the trials that have reached
+ * that rung so far, otherwise it is stopped early. Sampling is deterministic for a seed; which trials are stopped
+ * can depend on the order trials reach a rung, as in any asynchronous scheduler. With parallel::deterministic()
+ * the sweep runs synchronous successive halving instead, whose results do not depend on scheduling.
+ */
+namespace Sweep {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    //Candidate values per hyperparameter, each trial picks one of each
+    struct SearchSpace {
+        std::vector<int> hidden_units = {64};
+        //Sizes of the layers after the first, ending in the output size 1. The feature count is prepended as the first
+        //layer's size, so a later LSTM needs the layer before it at n_features and a Dense layer after an LSTM hidden_units
+        std::vector<std::vector<int>> layer_dims = {{64, 64, 32, 1}};
+        std::vector<double> learning_rate = {3e-4};
+        std::vector<int> batch_size = {32};
+        std::vector<int> timesteps = {30};
+    };
+
+    struct Config {
+        std::vector<std::string> layer_types = {"LSTM", "LSTM", "Relu", "Relu", "Linear"};
+        int num_trials = 16;
+        int max_epochs = 27;
+        int min_epochs = 1;       //First rung
+        int eta = 3;              //Reduction factor between rungs
+        double validation_fraction = 0.2; //Last part of the series, never shuffled into training
+        uint64_t seed = 0;
+    };
+
+    struct TrialParams {
+        int hidden_units;
+        std::vector<int> layer_dims;
+        double learning_rate;
+        int batch_size;
+        int timesteps;
+    };
+
+    enum class Status { Completed, Stopped, Failed };
+
+    struct TrialResult {
+        int id;
+        TrialParams params;
+        Status status = Status::Failed;
+        int epochs = 0;              //Epochs trained before completing or being stopped
+        double train_loss = 0.0;     //return_avg_loss() of the last epoch
+        double validation_loss = 0.0;
+        std::string error;
+    };
+
+    std::vector<TrialParams> sample_trials(const SearchSpace& space, const Config& config);
+
+    //x_features: scaled, not yet windowed features (see DataFramework::preprocessFeaturesFromFile), Y: targets.
+    //Throws std::invalid_argument when a layer_dims candidate does not fit layer_types (see SearchSpace)
+    std::vector<TrialResult> run(const Matrix& x_features, const Matrix& Y, const SearchSpace& space, const Config& config);
+
+    //Results table, one row per trial
+    void write_csv(const std::string& path, const std::vector<TrialResult>& results);
+    void write_json(const std::string& path, const std::vector<TrialResult>& results);
+}
+
+#endif //SWEEP_H
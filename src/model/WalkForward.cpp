@@ -0,0 +1,123 @@
+#include "WalkForward.h"
+#include "HybridModel.h"
+#include "parallel.h"
+#include "reductions.h"
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+#include <exception>
+
+namespace WalkForward {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    std::vector<Fold> make_folds(const size_t n_samples, const Config& config) {
+        if (config.train_size == 0 || config.test_size == 0) {
+            throw std::invalid_argument("Walk-forward train_size and test_size must be positive");
+        }
+        const size_t step = config.step == 0 ? config.test_size : config.step;
+
+        std::vector<Fold> folds;
+        for (size_t offset = 0; ; offset += step) {
+            Fold fold;
+            fold.train_begin = (config.window == Window::Rolling) ? offset : 0;
+            fold.train_end = config.train_size + offset;
+            fold.test_begin = fold.train_end + config.gap;
+            fold.test_end = fold.test_begin + config.test_size;
+            if (fold.test_end > n_samples) {
+                break;
+            }
+            folds.push_back(fold);
+        }
+        return folds;
+    }
+
+    FoldResult run_fold(const Tensor3D& X, const Matrix& Y, const Fold& fold, const Config& config) {
+        FoldResult result;
+        result.fold = fold;
+
+        const Tensor3D X_train(X.begin() + fold.train_begin, X.begin() + fold.train_end);
+        const Matrix Y_train(Y.begin() + fold.train_begin, Y.begin() + fold.train_end);
+        const Tensor3D X_test(X.begin() + fold.test_begin, X.begin() + fold.test_end);
+
+        //Fresh model per fold, nothing is shared with the other folds
+        HybridModel model;
+        model.init_data(X_train, Y_train, config.batch_size);
+        model.init_hidden_units(config.hidden_units);
+        //The input size comes from the data
+        std::vector<int> layer_dims = {static_cast<int>(X[0][0].size())};
+        layer_dims.insert(layer_dims.end(), config.layer_dims.begin(), config.layer_dims.end());
+        model.init_layers(config.layer_types, layer_dims);
+        model.initialize_network(fold.test_begin); //Folds run concurrently, so each is keyed by its own start
+        model.init_learning_rate(config.learning_rate);
+        model.init_Adam();
+
+        for (int epoch = 0; epoch < config.epochs; epoch++) {
+            model.train_epoch(X_train, Y_train, config.seed + epoch);
+        }
+        result.train_loss = model.return_avg_loss();
+
+        //Out-of-sample evaluation on the whole test window at once
+        result.predictions = model.predict(X_test)[0]; //Predictions are (1, m)
+        if (result.predictions.size() != X_test.size()) {
+            throw std::runtime_error("Walk-forward prediction count does not match the test window");
+        }
+
+        const size_t n = result.predictions.size();
+        result.mse = reductions::pairwiseSum(n, [&](const size_t i) {
+            const double error = result.predictions[i] - Y[fold.test_begin + i][0];
+            return error * error;
+        }) / n;
+        result.mae = reductions::pairwiseSum(n, [&](const size_t i) {
+            return std::abs(result.predictions[i] - Y[fold.test_begin + i][0]);
+        }) / n;
+        result.completed = true;
+
+        return result;
+    }
+
+    Summary run(const Tensor3D& X, const Matrix& Y, const Config& config) {
+        if (Y.size() < X.size()) {
+            throw std::invalid_argument("Walk-forward needs a target row for every input sample");
+        }
+
+        const std::vector<Fold> folds = make_folds(X.size(), config);
+        Summary summary;
+        summary.folds.resize(folds.size());
+
+        //One fold per chunk, each writes only its own slot. A failing fold is recorded instead of stopping the others
+        parallel::parallel_for(0, folds.size(), 1, [&](const size_t lo, const size_t hi) {
+            for (size_t k = lo; k < hi; k++) {
+                try {
+                    summary.folds[k] = run_fold(X, Y, folds[k], config);
+                } catch (const std::exception& e) {
+                    summary.folds[k].fold = folds[k];
+                    summary.folds[k].error = e.what();
+                }
+            }
+        });
+
+        //Aggregate in fold order
+        reductions::KahanAccumulator mse, mae, squared_error;
+        size_t n_predictions = 0;
+        for (const FoldResult& result : summary.folds) {
+            if (!result.completed) {
+                continue;
+            }
+            summary.completed++;
+            mse.add(result.mse);
+            mae.add(result.mae);
+            squared_error.add(result.mse * result.predictions.size());
+            n_predictions += result.predictions.size();
+        }
+        if (summary.completed > 0) {
+            summary.mean_mse = mse.value() / summary.completed;
+            summary.mean_mae = mae.value() / summary.completed;
+            summary.pooled_mse = squared_error.value() / n_predictions;
+        }
+
+        return summary;
+    }
+}
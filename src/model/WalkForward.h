@@ -0,0 +1,69 @@
+#ifndef WALKFORWARD_H
+#define WALKFORWARD_H
+
+#include <vector>
+#include <string>
+
+/*
+ * Walk-forward validation over a time-ordered dataset (sample i of X is paired with row i of Y).
+ *
+ * Each fold trains a fresh HybridModel on a window of past samples and evaluates it on the samples that follow.
+ * Folds are independent, so they are trained concurrently on parallel::pool(); results are returned in fold order
+ * and do not depend on the number of threads.
+ */
+namespace WalkForward {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    enum class Window {
+        Rolling,  //Fixed-length training window that slides forward
+        Expanding //Training window always starts at sample 0 and grows
+    };
+
+    struct Config {
+        Window window = Window::Expanding;
+        size_t train_size = 0; //Samples in the first training window
+        size_t test_size = 0;  //Out-of-sample samples per fold
+        size_t step = 0;       //Shift between folds, 0 = test_size (non-overlapping test windows)
+        size_t gap = 0;        //Samples skipped between train and test, avoids overlap of the input sequences
+
+        //Model and training settings, used for every fold
+        std::vector<std::string> layer_types = {"LSTM", "LSTM", "Relu", "Relu", "Linear"};
+        std::vector<int> layer_dims = {64, 64, 32, 1}; //Layer sizes after the input, as in Sweep and SharedTraining
+        int hidden_units = 64;
+        int batch_size = 32;
+        double learning_rate = 3e-4;
+        int epochs = 1;
+        int seed = 10; //Minibatch shuffling seed of the first epoch
+    };
+
+    //Half-open sample ranges [begin, end)
+    struct Fold {
+        size_t train_begin, train_end;
+        size_t test_begin, test_end;
+    };
+
+    struct FoldResult {
+        Fold fold;
+        bool completed = false;
+        std::string error; //Set when the fold failed, the other folds still run
+        double train_loss = 0.0;
+        double mse = 0.0;
+        double mae = 0.0;
+        std::vector<double> predictions; //Out-of-sample predictions, one per test sample
+    };
+
+    struct Summary {
+        std::vector<FoldResult> folds;
+        size_t completed = 0;
+        double mean_mse = 0.0;   //Average of the per-fold metrics
+        double mean_mae = 0.0;
+        double pooled_mse = 0.0; //MSE over all out-of-sample predictions together
+    };
+
+    std::vector<Fold> make_folds(const size_t n_samples, const Config& config);
+    FoldResult run_fold(const Tensor3D& X, const Matrix& Y, const Fold& fold, const Config& config);
+    Summary run(const Tensor3D& X, const Matrix& Y, const Config& config);
+}
+
+#endif //WALKFORWARD_H
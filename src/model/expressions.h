@@ -0,0 +1,192 @@
+#ifndef EXPRESSIONS_H
+#define EXPRESSIONS_H
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+
+#include "linalg.h"
+
+/*
+ * Lazy elementwise expressions over linalg::Matrix.
+ *
+ * Operators on expression nodes build a small tree instead of a Matrix; nothing is computed until the tree is
+ * passed to linalg::eval, which walks the output once and evaluates every node per element. A composite such as
+ *      transposed(update_gate) * transposed(candidate) + transposed(forget_gate) * c_prev
+ * therefore runs in a single loop with no intermediate matrices.
+ *
+ * Leaves hold references, so an expression must be evaluated while the matrices it refers to are alive.
+ */
+namespace linalg {
+    namespace expr {
+        //CRTP base, operators only bind when at least one side is an expression
+        template <typename E>
+        struct Expression {
+            const E& self() const { return static_cast<const E&>(*this); }
+        };
+
+        template <typename E>
+        concept IsExpression = std::is_base_of_v<Expression<std::remove_cvref_t<E>>, std::remove_cvref_t<E>>;
+
+        template <typename E>
+        concept Operand = IsExpression<E> || std::is_same_v<std::remove_cvref_t<E>, Matrix> ||
+                          std::is_same_v<std::remove_cvref_t<E>, View> || std::is_arithmetic_v<std::remove_cvref_t<E>>;
+
+        //Leaf: an existing matrix
+        struct Ref : Expression<Ref> {
+            const Matrix& m;
+            explicit Ref(const Matrix& m) : m(m) {}
+            size_t rows() const { return m.size(); }
+            size_t cols() const { return m.empty() ? 0 : m[0].size(); }
+            double operator()(const size_t i, const size_t j) const { return m[i][j]; }
+        };
+
+        //Leaf: an existing matrix read as its transpose, no copy is made
+        struct Transposed : Expression<Transposed> {
+            const Matrix& m;
+            explicit Transposed(const Matrix& m) : m(m) {}
+            size_t rows() const { return m.empty() ? 0 : m[0].size(); }
+            size_t cols() const { return m.size(); }
+            double operator()(const size_t i, const size_t j) const { return m[j][i]; }
+        };
+
+        //Leaf: a linalg::View (column block and/or transposed), orientation is resolved per element
+        struct ViewLeaf : Expression<ViewLeaf> {
+            View v;
+            explicit ViewLeaf(const View& v) : v(v) {}
+            size_t rows() const { return v.rows(); }
+            size_t cols() const { return v.cols(); }
+            double operator()(const size_t i, const size_t j) const { return v.at(i, j); }
+        };
+
+        //Leaf: a scalar broadcast to whatever shape it is combined with. Shape (0, 0) means "any".
+        struct Scalar : Expression<Scalar> {
+            double s;
+            explicit Scalar(const double s) : s(s) {}
+            size_t rows() const { return 0; }
+            size_t cols() const { return 0; }
+            double operator()(const size_t, const size_t) const { return s; }
+        };
+
+        //Node: elementwise binary operation, shapes are checked once when the node is built
+        template <typename L, typename R, typename Op>
+        struct Binary : Expression<Binary<L, R, Op>> {
+            L lhs;
+            R rhs;
+            Binary(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {
+                if ((lhs.rows() != 0 && rhs.rows() != 0 && lhs.rows() != rhs.rows()) ||
+                    (lhs.cols() != 0 && rhs.cols() != 0 && lhs.cols() != rhs.cols())) {
+                    throw std::invalid_argument("Shape mismatch in linalg expression. lhs shape: " +
+                        std::to_string(lhs.rows()) + ", " + std::to_string(lhs.cols()) + " rhs shape: " +
+                        std::to_string(rhs.rows()) + ", " + std::to_string(rhs.cols()));
+                }
+            }
+            size_t rows() const { return lhs.rows() != 0 ? lhs.rows() : rhs.rows(); }
+            size_t cols() const { return lhs.cols() != 0 ? lhs.cols() : rhs.cols(); }
+            double operator()(const size_t i, const size_t j) const { return Op::apply(lhs(i, j), rhs(i, j)); }
+        };
+
+        //Node: elementwise unary function
+        template <typename E, typename F>
+        struct Map : Expression<Map<E, F>> {
+            E e;
+            F f;
+            Map(const E& e, const F& f) : e(e), f(f) {}
+            size_t rows() const { return e.rows(); }
+            size_t cols() const { return e.cols(); }
+            double operator()(const size_t i, const size_t j) const { return f(e(i, j)); }
+        };
+
+        struct Plus { static double apply(const double a, const double b) { return a + b; } };
+        struct Minus { static double apply(const double a, const double b) { return a - b; } };
+        struct Multiplies { static double apply(const double a, const double b) { return a * b; } };
+        struct Divides { static double apply(const double a, const double b) { return a / b; } };
+
+        //Lift matrices and scalars into leaves, expressions pass through unchanged
+        inline Ref wrap(const Matrix& m) { return Ref(m); }
+        inline ViewLeaf wrap(const View& v) { return ViewLeaf(v); }
+        inline Scalar wrap(const double s) { return Scalar(s); }
+        template <IsExpression E>
+        const E& wrap(const E& e) { return e; }
+
+        template <typename Op, typename L, typename R>
+        auto makeBinary(const L& l, const R& r) {
+            using LE = std::remove_cvref_t<decltype(wrap(l))>;
+            using RE = std::remove_cvref_t<decltype(wrap(r))>;
+            return Binary<LE, RE, Op>(wrap(l), wrap(r));
+        }
+
+        template <typename E, typename F>
+        auto makeMap(const E& e, const F& f) {
+            using EE = std::remove_cvref_t<decltype(wrap(e))>;
+            return Map<EE, F>(wrap(e), f);
+        }
+
+        inline Ref lazy(const Matrix& m) { return Ref(m); }
+        inline Transposed transposed(const Matrix& m) { return Transposed(m); }
+
+        //Arithmetic operators
+        template <Operand L, Operand R> requires (IsExpression<L> || IsExpression<R>)
+        auto operator+(const L& l, const R& r) { return makeBinary<Plus>(l, r); }
+
+        template <Operand L, Operand R> requires (IsExpression<L> || IsExpression<R>)
+        auto operator-(const L& l, const R& r) { return makeBinary<Minus>(l, r); }
+
+        template <Operand L, Operand R> requires (IsExpression<L> || IsExpression<R>)
+        auto operator*(const L& l, const R& r) { return makeBinary<Multiplies>(l, r); }
+
+        //NOTE: unlike linalg::division, no guard against division by zero
+        template <Operand L, Operand R> requires (IsExpression<L> || IsExpression<R>)
+        auto operator/(const L& l, const R& r) { return makeBinary<Divides>(l, r); }
+
+        template <IsExpression E>
+        auto operator-(const E& e) { return makeMap(e, [](const double x) { return -x; }); }
+
+        //Elementwise functions, mirroring linalg and activations
+        template <Operand E> requires (!std::is_arithmetic_v<E>)
+        auto sqrt(const E& e) { return makeMap(e, [](const double x) { return std::sqrt(x); }); }
+
+        template <Operand E> requires (!std::is_arithmetic_v<E>)
+        auto pow(const E& e, const double exponent) {
+            return makeMap(e, [exponent](const double x) { return std::pow(x, exponent); });
+        }
+
+        template <Operand E> requires (!std::is_arithmetic_v<E>)
+        auto tanh(const E& e) { return makeMap(e, [](const double x) { return std::tanh(x); }); }
+
+        template <Operand E> requires (!std::is_arithmetic_v<E>)
+        auto tanh_prime(const E& e) {
+            return makeMap(e, [](const double x) { const double th = std::tanh(x); return 1 - th * th; });
+        }
+
+        template <Operand E> requires (!std::is_arithmetic_v<E>)
+        auto sigmoid(const E& e) { return makeMap(e, [](const double x) { return 1 / (1 + std::exp(-x)); }); }
+    }
+
+    //Evaluate an expression into `out` in a single pass, reusing its storage when the shape matches.
+    //NOTE: `out` may appear in the expression as a plain leaf (e.g. v = beta1 * v + ...), but not as a transposed one
+    template <typename E>
+    void eval_into(Matrix& out, const expr::Expression<E>& e) {
+        const E& x = e.self();
+        const size_t rows = x.rows(), cols = x.cols();
+        ensureShape(out, rows, cols);
+
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                out[i][j] = x(i, j);
+            }
+        }
+    }
+
+    //Evaluate an expression into a new matrix in a single pass
+    template <typename E>
+    Matrix eval(const expr::Expression<E>& e) {
+        Matrix result;
+        eval_into(result, e);
+        return result;
+    }
+}
+
+#endif //EXPRESSIONS_H
@@ -2,9 +2,10 @@
 #include <string>
 #include <vector>
 #include <cmath>
-#include <random>
-#include <__random/random_device.h>
+#include <atomic>
 #include "linalg.h"
+#include "reductions.h"
+#include "rng.h"
 
 namespace linalg {
     typedef std::vector<std::vector<double>> Matrix;
@@ -18,6 +19,127 @@ namespace linalg {
         return std::to_string(m.size()) + ", " + std::to_string(m[0].size()) + ", " + std::to_string(m[0][0].size());
     }
 
+    std::string shape(const View &v) {
+        return std::to_string(v.rows()) + ", " + std::to_string(v.cols());
+    }
+
+    //Transposed view, no data is copied
+    View T(const View& v) {
+        View transposed = v;
+        transposed.transposed = !v.transposed;
+        return transposed;
+    }
+
+    //View of columns [start_col, end_col), no data is copied
+    View sliceColsView(const View& mat, size_t start_col, size_t end_col) {
+        // Ensure end_col is within bounds, start_col < end_col
+        if (mat.transposed || end_col > mat.cols() || start_col >= end_col) {
+            throw std::invalid_argument("Invalid column range for slicing.");
+        }
+
+        View sliced(mat);
+        sliced.col_offset += start_col;
+        sliced.n_cols = end_col - start_col;
+        return sliced;
+    }
+
+    namespace {
+        //Calls f with an element accessor specialised for the view's orientation, so the transpose branch is
+        //resolved once per kernel call instead of once per element
+        template <typename F>
+        void withAccessor(const View& v, F&& f) {
+            if (v.data) {
+                const double* d = v.row(0);
+                const size_t stride = v.stride;
+                if (v.transposed) {
+                    f([d, stride](const size_t i, const size_t j) { return d[j * stride + i]; });
+                } else {
+                    f([d, stride](const size_t i, const size_t j) { return d[i * stride + j]; });
+                }
+                return;
+            }
+            const Matrix& m = *v.m;
+            const size_t r0 = v.row_offset, c0 = v.col_offset;
+            if (v.transposed) {
+                f([&m, r0, c0](const size_t i, const size_t j) { return m[r0 + j][c0 + i]; });
+            } else {
+                f([&m, r0, c0](const size_t i, const size_t j) { return m[r0 + i][c0 + j]; });
+            }
+        }
+
+        //out[i][j] = op(a(i, j)) over the shape of a
+        template <typename Op>
+        void unaryKernel(Matrix& out, const View& a, Op op) {
+            const size_t rows = a.rows(), cols = a.cols();
+            ensureShape(out, rows, cols);
+            withAccessor(a, [&](auto A) {
+                for (size_t i = 0; i < rows; i++) {
+                    for (size_t j = 0; j < cols; j++) {
+                        out[i][j] = op(A(i, j));
+                    }
+                }
+            });
+        }
+
+        //NumPy-style broadcasting: out[i][j] = op(a(i, j), b(i, j)) where a (1, n) row, (m, 1) column or (1, 1)
+        //operand is repeated to the broadcast shape. Broadcast strides are resolved once per call and the common
+        //bias/scalar cases run their own loop without any per-element index arithmetic
+        template <typename Op>
+        void broadcastKernel(Matrix& out, const View& a, const View& b, Op op) {
+            const Shape out_shape = broadcastShape(a, b);
+            const size_t rows = out_shape.rows, cols = out_shape.cols;
+            ensureShape(out, rows, cols);
+
+            // Stride 0 repeats the single row/column of a broadcast operand
+            const size_t a_rs = (a.rows() == rows) ? 1 : 0, a_cs = (a.cols() == cols) ? 1 : 0;
+            const size_t b_rs = (b.rows() == rows) ? 1 : 0, b_cs = (b.cols() == cols) ? 1 : 0;
+
+            withAccessor(a, [&](auto A) {
+                withAccessor(b, [&](auto B) {
+                    if (a_rs && a_cs && b_rs && b_cs) { // Same shapes
+                        for (size_t i = 0; i < rows; i++) {
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] = op(A(i, j), B(i, j));
+                            }
+                        }
+                    } else if (a_rs && a_cs && b_rs) { // b is a (m, 1) column, e.g. a bias
+                        for (size_t i = 0; i < rows; i++) {
+                            const double b_i = B(i, 0);
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] = op(A(i, j), b_i);
+                            }
+                        }
+                    } else if (a_rs && a_cs && b_cs) { // b is a (1, n) row
+                        for (size_t i = 0; i < rows; i++) {
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] = op(A(i, j), B(0, j));
+                            }
+                        }
+                    } else if (a_rs && a_cs) { // b is (1, 1)
+                        const double b_00 = B(0, 0);
+                        for (size_t i = 0; i < rows; i++) {
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] = op(A(i, j), b_00);
+                            }
+                        }
+                    } else { // a is broadcast too, e.g. (m, 1) op (1, n)
+                        for (size_t i = 0; i < rows; i++) {
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] = op(A(i * a_rs, j * a_cs), B(i * b_rs, j * b_cs));
+                            }
+                        }
+                    }
+                });
+            });
+        }
+
+        //out[i][j] = op(a(i, j), s): the scalar case of the broadcast engine, no operand matrix is needed
+        template <typename Op>
+        void scalarKernel(Matrix& out, const View& a, const double s, Op op) {
+            unaryKernel(out, a, [s, &op](const double x) { return op(x, s); });
+        }
+    }
+
     //Vector generate zeros:
     std::vector<double> generateZeros(const int n) {
         std::vector<double> zero_vector(n, 0.0);
@@ -71,8 +193,32 @@ namespace linalg {
         }
         return dotProduct;
     }
+
+    //Broadcast shape of two operands following NumPy rules: each dimension must match or be 1
+    Shape broadcastShape(const View& a, const View& b) {
+        const auto dim = [&](const size_t x, const size_t y) {
+            if (x != y && x != 1 && y != 1) {
+                throw std::invalid_argument("Shapes cannot be broadcast together. a shape: " + shape(a) + " b shape: " + shape(b));
+            }
+            return (x == 1) ? y : x;
+        };
+        return Shape{dim(a.rows(), b.rows()), dim(a.cols(), b.cols())};
+    }
+
+    //Resize `out` only when it does not already have the requested shape, so hot loops can reuse buffers
+    void ensureShape(Matrix& out, const size_t rows, const size_t cols) {
+        if (out.size() != rows) {
+            out.resize(rows);
+        }
+        for (size_t i = 0; i < rows; i++) {
+            if (out[i].size() != cols) {
+                out[i].resize(cols);
+            }
+        }
+    }
+
     //This function computes the matmul product of two matrices
-    Matrix matmul(const Matrix &a, const Matrix &b) {
+    void matmul_into(Matrix& out, const View &a, const View &b) {
         /*
         Result[i][j]=
             v=0
@@ -80,235 +226,297 @@ namespace linalg {
             n−1
         */
         //Ensure same shape
-        if (a[0].size() != b.size()) {
+        if (a.cols() != b.rows()) {
             //throw std::invalid_argument("Matrices have different shapes for matmul. a_shape: " + shape(a) + " b shape: " + shape(b));
         }
-        // Generate array of zeros
-        Matrix product = generateZeros(a.size(), b[0].size());
+        const size_t rows = a.rows(), inner = a.cols(), cols = b.cols();
+        ensureShape(out, rows, cols);
+        for (std::vector<double>& out_row : out) {
+            std::fill(out_row.begin(), out_row.end(), 0.0);
+        }
 
-        // Matrix multiplication
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < b[0].size(); j++) {
-                double sum = 0; // Sum of each row
-                for (size_t v = 0; v < a[i].size(); v++) {
-                    sum += a[i][v] * b[v][j];
+        // Every layout sums over v in increasing order, only the loop nest differs so rows are walked contiguously
+        if (!a.transposed && !b.transposed) {
+            // i-v-j: b and out are walked along rows
+            for (size_t i = 0; i < rows; i++) {
+                const double* a_row = a.row(i);
+                double* out_row = out[i].data();
+                for (size_t v = 0; v < inner; v++) {
+                    const double a_iv = a_row[v];
+                    const double* b_row = b.row(v);
+                    for (size_t j = 0; j < cols; j++) {
+                        out_row[j] += a_iv * b_row[j];
+                    }
+                }
+            }
+        } else if (!a.transposed && b.transposed) {
+            // A * B^T: every entry is a dot product of two stored rows
+            for (size_t i = 0; i < rows; i++) {
+                const double* a_row = a.row(i);
+                for (size_t j = 0; j < cols; j++) {
+                    const double* b_row = b.row(j);
+                    double sum = 0.0;
+                    for (size_t v = 0; v < inner; v++) {
+                        sum += a_row[v] * b_row[v];
+                    }
+                    out[i][j] = sum;
+                }
+            }
+        } else if (a.transposed && !b.transposed) {
+            // A^T * B: v-i-j, row v of the stored A scales row v of B
+            for (size_t v = 0; v < inner; v++) {
+                const double* a_row = a.row(v);
+                const double* b_row = b.row(v);
+                for (size_t i = 0; i < rows; i++) {
+                    const double a_iv = a_row[i];
+                    double* out_row = out[i].data();
+                    for (size_t j = 0; j < cols; j++) {
+                        out_row[j] += a_iv * b_row[j];
+                    }
                 }
-                product[i][j] = sum; // Append the product
             }
+        } else {
+            withAccessor(a, [&](auto A) {
+                withAccessor(b, [&](auto B) {
+                    for (size_t i = 0; i < rows; i++) {
+                        for (size_t v = 0; v < inner; v++) {
+                            const double a_iv = A(i, v);
+                            for (size_t j = 0; j < cols; j++) {
+                                out[i][j] += a_iv * B(v, j);
+                            }
+                        }
+                    }
+                });
+            });
         }
+    }
 
+    Matrix matmul(const View &a, const View &b) {
+        Matrix product;
+        matmul_into(product, a, b);
         return product;
     }
 
-    // Element wise addition
-    Matrix add(const Matrix &a, const Matrix &b) {
-        if (a.size() != b.size()) {
-            //throw std::invalid_argument("Matrices not the same shape for addition. a_shape: " + shape(a) + " b shape: " + shape(b));
-        }
-
-        // Generate array of zeros
-        Matrix result = generateZeros(a.size(), a[0].size());
+    // Element wise addition, broadcasting (n, 1) / (1, n) biases and (1, 1) scalars
+    void add_into(Matrix& out, const View &a, const View &b) {
+        broadcastKernel(out, a, b, [](const double x, const double y) { return x + y; });
+    }
 
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                // Add broadcasting for weights and biases
-                if (b[0].size() == 1) {
-                    result[i][j] = a[i][j] + b[i][0];
-                } else {
-                    result[i][j] = a[i][j] + b[i][j];
-                }
-            }
-        }
+    Matrix add(const View &a, const View &b) {
+        Matrix result;
+        add_into(result, a, b);
         return result;
     }
 
     // @overload: Scalar addition
-    Matrix add(const Matrix &a, const double scalar) {
-        Matrix result = generateZeros(a.size(), a[0].size());
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                result[i][j] += scalar;
-            }
-        }
+    void add_into(Matrix& out, const View &a, const double scalar) {
+        scalarKernel(out, a, scalar, [](const double x, const double y) { return x + y; });
+    }
+
+    Matrix add(const View &a, const double scalar) {
+        Matrix result;
+        add_into(result, a, scalar);
         return result;
     }
 
     // Element wise subtraction
-    Matrix subtract(const Matrix &a, const Matrix &b) {
-        if (a.size() != b.size() || a[0].size() != b[0].size()) {
-            throw std::invalid_argument("Matrices not the same shape for addition");
-        }
-        // Generate array of zeros
-        Matrix result = generateZeros(a.size(), b[0].size());
+    void subtract_into(Matrix& out, const View &a, const View &b) {
+        broadcastKernel(out, a, b, [](const double x, const double y) { return x - y; });
+    }
 
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                result[i][j] = a[i][j] - b[i][j];
-            }
-        }
+    Matrix subtract(const View &a, const View &b) {
+        Matrix result;
+        subtract_into(result, a, b);
         return result;
     }
 
-    Matrix transpose(const Matrix &m) {
-        // Initialize transposed matrix with swapped dimensions
-        Matrix transposed(m[0].size(), std::vector<double>(m.size()));
+    //Materialise a transpose. Prefer T(m) wherever a kernel can read the view directly
+    void transpose_into(Matrix& out, const View &m) {
+        unaryKernel(out, T(m), [](const double x) { return x; });
+    }
 
-        for (size_t i = 0; i < m.size(); i++) {
-            for (size_t j = 0; j < m[0].size(); j++) {
-                transposed[j][i] = m[i][j];
-            }
-        }
+    Matrix transpose(const View &m) {
+        Matrix transposed;
+        transpose_into(transposed, m);
         return transposed;
     }
 
-    Matrix pow(const Matrix &m, const double exponent) {
-        // Copy the current matrix
-        Matrix result(m.size(), std::vector<double>(m[0].size()));
-
+    void pow_into(Matrix& out, const View &m, const double exponent) {
         // Element-wise power
-        for (size_t i = 0; i < m.size(); i++) {
-            for (size_t j = 0; j < m[0].size(); j++) {
-                result[i][j] = std::pow(m[i][j], exponent);
-            }
-        }
+        unaryKernel(out, m, [exponent](const double x) { return std::pow(x, exponent); });
+    }
+
+    Matrix pow(const View &m, const double exponent) {
+        Matrix result;
+        pow_into(result, m, exponent);
         return result;
     }
 
-    Matrix sqrt(const Matrix &m) {
-        return pow(m, 0.5);
+    void sqrt_into(Matrix& out, const View &m) {
+        unaryKernel(out, m, [](const double x) { return std::sqrt(x); });
     }
 
-    Matrix sum(const Matrix &m, const int axis) {
-        //This function assumes keepdims = True
-        if (axis == 0) {
-            // Sum along columns, index 1 represents sum.
-            Matrix colSum(1, std::vector<double>(m[0].size(), 0.0));
+    Matrix sqrt(const View &m) {
+        Matrix result;
+        sqrt_into(result, m);
+        return result;
+    }
 
-            for (size_t j = 0; j < m[0].size(); j++) {
-                for (size_t i = 0; i < m.size(); i++) {
-                    colSum[0][j] += m[i][j];
-                }
-            }
-            return colSum;
-        }
-        else {
-            //Sum along rows
-            Matrix rowSum(m.size(), std::vector<double>(1, 0.0));
+    void sum_into(Matrix& out, const View &m, const int axis) {
+        //This function assumes keepdims = True. Axis 0 sums along columns, any other axis along rows
+        out = reductions::sum(m, axis == 0 ? 0 : 1);
+    }
 
-            for (size_t i = 0; i < m.size(); i++) {
-                for (size_t j = 0; j < m[0].size(); j++) {
-                    rowSum[i][0] += m[i][j];
-                }
-            }
-            return rowSum;
-        }
+    Matrix sum(const View &m, const int axis) {
+        Matrix result;
+        sum_into(result, m, axis);
+        return result;
     }
 
     //Scalar multiplication
-    Matrix scalarMultiply(const double scalar, const Matrix &m) {
-        Matrix result = m;
-        for (size_t i = 0; i < m.size(); i++) {
-            for (size_t j = 0; j < m[0].size(); j++) {
-                result[i][j] = scalar * m[i][j];
-            }
-        }
+    void scalarMultiply_into(Matrix& out, const double scalar, const View &m) {
+        scalarKernel(out, m, scalar, [](const double x, const double y) { return y * x; });
+    }
+
+    Matrix scalarMultiply(const double scalar, const View &m) {
+        Matrix result;
+        scalarMultiply_into(result, scalar, m);
         return result;
     }
 
     //Element-wise multiplication
-    Matrix elementMultiply(const Matrix &a, const Matrix &b) {
-        if (a.size() != b.size() || (a.size() > 0 && b.size() > 0 && a[0].size() != b[0].size())) {
-            std::string error_message = "Error in linalg::elementMultiply: Dimension mismatch.\n";
-            error_message += "Shape of matrix 'a': " + std::to_string(a.size()) + "x" + (a.empty() ? "0" : std::to_string(a[0].size())) + "\n";
-            error_message += "Shape of matrix 'b': " + std::to_string(b.size()) + "x" + (b.empty() ? "0" : std::to_string(b[0].size()));
-            //throw std::invalid_argument(error_message); // Throw exception if dimensions don't match
-        }
-
-        Matrix result(a.size(), std::vector<double>(a[0].size(), 0.0));
+    void elementMultiply_into(Matrix& out, const View &a, const View &b) {
+        broadcastKernel(out, a, b, [](const double x, const double y) { return x * y; });
+    }
 
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                result[i][j] = a[i][j] * b[i][j];
-            }
-        }
+    Matrix elementMultiply(const View &a, const View &b) {
+        Matrix result;
+        elementMultiply_into(result, a, b);
         return result;
     }
 
     //Element-wise division
-    Matrix division(const Matrix &a, const Matrix &b) {
-        // Ensure dimensions match -- broadcasting b in L2 Norm
-        if (a[0].size() != b[0].size()) {
-            throw std::invalid_argument("Shape mismatch in element-wise division");
-        }
-
-        Matrix result(a.size(), std::vector<double>(a[0].size(), 0.0));
+    void division_into(Matrix& out, const View &a, const View &b) {
+        // Broadcasting b in L2 Norm. Division by zero gives 0
+        broadcastKernel(out, a, b, [](const double x, const double y) { return (y == 0) ? 0.0 : x / y; });
+    }
 
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                if (b[i][j] == 0) {
-                    result[i][j] = 0; //Prevents division by zero
-                }
-                else {
-                    result[i][j] = a[i][j] / b[i][j];
-                }
-            }
-        }
+    Matrix division(const View &a, const View &b) {
+        Matrix result;
+        division_into(result, a, b);
         return result;
     }
 
     //Element-wise division of a matrix by a scalar
-    Matrix division(const Matrix &a, const int s) {
-        Matrix result(a.size(), std::vector<double>(a[0].size(), 0.0));
-
+    void division_into(Matrix& out, const View &a, const int s) {
         //Prevent division by zero
-        if (s == 0) {
-            return a;
+        scalarKernel(out, a, s, [](const double x, const double y) { return (y == 0) ? x : x / y; });
+    }
+
+    Matrix division(const View &a, const int s) {
+        Matrix result;
+        division_into(result, a, s);
+        return result;
+    }
+
+    namespace {
+        //In-place ops may broadcast b up to the shape of a, never a up to the shape of b
+        void checkInplaceShape(const View& a, const View& b, const std::string& op) {
+            const Shape out_shape = broadcastShape(a, b);
+            if (out_shape.rows != a.rows() || out_shape.cols != a.cols()) {
+                throw std::invalid_argument("Shape mismatch in " + op + ". Target shape: " + shape(a) + " operand shape: " + shape(b));
+            }
         }
+    }
 
-        for (size_t i = 0; i < a.size(); i++) {
-            for (size_t j = 0; j < a[0].size(); j++) {
-                result[i][j] = a[i][j] / s;
+    // a += b, b may be broadcast to the shape of a
+    void add_inplace(Matrix& a, const View& b) {
+        checkInplaceShape(a, b, "add_inplace");
+        add_into(a, a, b);
+    }
+
+    // a -= b
+    void subtract_inplace(Matrix& a, const View& b) {
+        checkInplaceShape(a, b, "subtract_inplace");
+        subtract_into(a, a, b);
+    }
+
+    // a *= scalar
+    void scale_inplace(Matrix& a, const double scalar) {
+        for (std::vector<double>& row : a) {
+            for (double& value : row) {
+                value *= scalar;
             }
         }
-        return result;
     }
 
+    // y += alpha * x
+    void axpy(const double alpha, const View& x, Matrix& y) {
+        const View y_view(y);
+        checkInplaceShape(y_view, x, "axpy");
+        broadcastKernel(y, y_view, x, [alpha](const double y_ij, const double x_ij) { return y_ij + alpha * x_ij; });
+    }
+
+    // y += a * b, element-wise
+    void fma_inplace(Matrix& y, const View& a, const View& b) {
+        const View y_view(y);
+        if (a.rows() != y_view.rows() || b.rows() != y_view.rows() || a.cols() != y_view.cols() || b.cols() != y_view.cols()) {
+            throw std::invalid_argument("Shape mismatch in fma_inplace. y shape: " + shape(y_view) + " a shape: " + shape(a) + " b shape: " + shape(b));
+        }
+        withAccessor(a, [&](auto A) {
+            withAccessor(b, [&](auto B) {
+                for (size_t i = 0; i < y.size(); i++) {
+                    for (size_t j = 0; j < y[i].size(); j++) {
+                        y[i][j] += A(i, j) * B(i, j);
+                    }
+                }
+            });
+        });
+    }
+
+    //Draws come from the counter-based generator in rng.h, keyed by rng::seed(). Each randn call gets its own stream,
+    //so its values do not depend on how many threads fill it, only on the order of randn calls
     double randnum() {
-        constexpr int SEED = 0; //Seed can be changed for reproducibility
-        static std::random_device rd;
-        static std::mt19937 gen(SEED);
-        static std::normal_distribution<double> distrib(0, 1);
-        return distrib(gen);
+        static const uint64_t stream = rng::next_tensor_id();
+        static std::atomic<uint64_t> index{0};
+        return rng::normal(rng::seed(), stream, index.fetch_add(1));
     }
 
     // randn to generate a vector of random numbers
     std::vector<double> randn(const int n) {
-        std::vector<double> result(n);
-        for (int i = 0; i < n; i++) {
-            result[i] = randnum();
-        }
-        return result;
+        Matrix result(1, std::vector<double>(n));
+        rng::fillNormal(result, rng::seed(), rng::next_tensor_id());
+        return result[0];
     }
 
     // randn to generate a matrix of random numbers
     Matrix randn(const int rows, const int cols) {
         Matrix result(rows, std::vector<double>(cols));
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result[i][j] = randnum();
-            }
-        }
+        rng::fillNormal(result, rng::seed(), rng::next_tensor_id());
         return result;
     }
 
-    //randn to generate a Tensor3D of random numbers
+    //Keyed by name instead of call order, e.g. randn(n_a, n_a + n_x, "Wf1") is the same whatever was initialised before it
+    Matrix randn(const int rows, const int cols, const std::string& name) {
+        return randn(rows, cols, name, rng::seed());
+    }
+
+    //Same, under an explicit seed (e.g. rng::derive_seed of a model id) instead of rng::seed()
+    Matrix randn(const int rows, const int cols, const std::string& name, const uint64_t seed) {
+        Matrix result(rows, std::vector<double>(cols));
+        rng::fillNormal(result, seed, rng::tensor_id(name));
+        return result;
+    }
+
+    //randn to generate a Tensor3D of random numbers, filled as one (rows * timesteps, cols) stream
     Tensor3D randn(const int rows, const int timesteps, const int cols) {
-        Tensor3D result(rows, Matrix(timesteps, std::vector<double>(cols)));
+        Matrix flat(static_cast<size_t>(rows) * timesteps, std::vector<double>(cols));
+        rng::fillNormal(flat, rng::seed(), rng::next_tensor_id());
+
+        Tensor3D result(rows, Matrix(timesteps));
         for (size_t i = 0; i < rows; ++i) {
             for (size_t j = 0; j < timesteps; ++j) {
-                for (size_t k = 0; k < cols; ++k) {
-                    result[i][j][k] = randnum();
-                }
+                result[i][j] = std::move(flat[i * timesteps + j]);
             }
         }
         return result;
@@ -334,11 +542,12 @@ namespace linalg {
         return sliced;
     }
 
-    //Reshape a (m, 1) Matrix --> (m) vector
-    std::vector<double> reshape(const Matrix& m) {
-        std::vector<double> vector(m.size());
-        for (size_t i = 0; i < m.size(); i++) {
-            vector.push_back(m[i][0]);
+    //Reshape a (m, 1) Matrix or view --> (m) vector. Pass T(m) for a (1, m) row
+    std::vector<double> reshape(const View& m) {
+        std::vector<double> vector;
+        vector.reserve(m.rows());
+        for (size_t i = 0; i < m.rows(); i++) {
+            vector.push_back(m.at(i, 0));
         }
         return vector;
     }
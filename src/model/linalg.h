@@ -6,16 +6,56 @@
 #include <vector>
 #include <cmath>
 #include <random>
+#include <cstdint>
 
 namespace linalg {
     // Type definitions
     typedef std::vector<std::vector<double>> Matrix;
     typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
 
+    // Zero-copy, read-only view of a Matrix or a block of its columns, optionally transposed.
+    // Matrix converts implicitly, so every kernel below accepts plain matrices unchanged.
+    // A View can also wrap raw row-major storage (e.g. weights in a memory-mapped file) given its row stride.
+    // NOTE: a View does not own its data, the viewed Matrix or buffer must outlive it
+    struct View {
+        const Matrix* m;
+        const double* data = nullptr;  // Raw storage, used instead of m when set
+        size_t stride = 0;             // Elements between consecutive rows of data
+        size_t row_offset, col_offset; // Block origin in the storage
+        size_t n_rows, n_cols;         // Block shape in the storage, before transposition
+        bool transposed;
+
+        View(const Matrix& m)
+            : m(&m), row_offset(0), col_offset(0), n_rows(m.size()), n_cols(m.empty() ? 0 : m[0].size()), transposed(false) {}
+        View(const double* data, const size_t rows, const size_t cols, const size_t stride)
+            : m(nullptr), data(data), stride(stride), row_offset(0), col_offset(0), n_rows(rows), n_cols(cols), transposed(false) {}
+
+        size_t rows() const { return transposed ? n_cols : n_rows; }
+        size_t cols() const { return transposed ? n_rows : n_cols; }
+        // Start of storage row r of the block (before transposition)
+        const double* row(const size_t r) const {
+            return data ? data + (row_offset + r) * stride + col_offset : (*m)[row_offset + r].data() + col_offset;
+        }
+        double at(const size_t i, const size_t j) const {
+            return transposed ? row(j)[i] : row(i)[j];
+        }
+    };
+
+    // Explicit (rows, cols) shape
+    struct Shape {
+        size_t rows, cols;
+    };
+
     // Function declarations
     std::string shape(const Matrix &m);
+    std::string shape(const View &v);
     std::string shapeTensor(const Tensor3D &m);
 
+    Shape broadcastShape(const View& a, const View& b);
+
+    View T(const View& v);
+    View sliceColsView(const View& mat, size_t start_col, size_t end_col);
+
     std::vector<double> generateZeros(const int n);
     Matrix generateZeros(const int rows, const int cols);
     Tensor3D generateZeros(const int rows, const int timesteps, const int cols);
@@ -25,25 +65,53 @@ namespace linalg {
     Tensor3D generateOnes(const int rows, const int timesteps, const int cols);
 
     double dot(const std::vector<double> &a, const std::vector<double> &b);
-    Matrix matmul(const Matrix &a, const Matrix &b);
-    Matrix add(const Matrix &a, const Matrix &b);
-    Matrix add(const Matrix &a, const double s);
-    Matrix subtract(const Matrix &a, const Matrix &b);
-    Matrix transpose(const Matrix &m);
-    Matrix pow(const Matrix &m, const double exponent);
-    Matrix sqrt(const Matrix &m);
-    Matrix sum(const Matrix &m, const int axis);
-    Matrix scalarMultiply(const double scalar, const Matrix &m);
-    Matrix elementMultiply(const Matrix &a, const Matrix &b);
-    Matrix division(const Matrix &a, const Matrix &b);
-    Matrix division(const Matrix& a, const int s);
+    Matrix matmul(const View &a, const View &b);
+    Matrix add(const View &a, const View &b);
+    Matrix add(const View &a, const double s);
+    Matrix subtract(const View &a, const View &b);
+    Matrix transpose(const View &m);
+    Matrix pow(const View &m, const double exponent);
+    Matrix sqrt(const View &m);
+    Matrix sum(const View &m, const int axis);
+    Matrix scalarMultiply(const double scalar, const View &m);
+    Matrix elementMultiply(const View &a, const View &b);
+    Matrix division(const View &a, const View &b);
+    Matrix division(const View& a, const int s);
+
+    // Elementwise binary ops (add, subtract, elementMultiply, division, axpy) broadcast NumPy-style:
+    // each dimension must match or be 1, e.g. (m, n) + (m, 1) bias, (m, n) + (1, n) row, (m, n) * (1, 1)
+
+    // Out-parameter variants: write into `out`, which is only reallocated when its shape differs.
+    // NOTE: `out` may alias a non-transposed input for elementwise ops, but not for matmul_into, transpose_into or sum_into
+    void ensureShape(Matrix& out, const size_t rows, const size_t cols);
+    void matmul_into(Matrix& out, const View& a, const View& b);
+    void add_into(Matrix& out, const View& a, const View& b);
+    void add_into(Matrix& out, const View& a, const double s);
+    void subtract_into(Matrix& out, const View& a, const View& b);
+    void transpose_into(Matrix& out, const View& m);
+    void pow_into(Matrix& out, const View& m, const double exponent);
+    void sqrt_into(Matrix& out, const View& m);
+    void sum_into(Matrix& out, const View& m, const int axis);
+    void scalarMultiply_into(Matrix& out, const double scalar, const View& m);
+    void elementMultiply_into(Matrix& out, const View& a, const View& b);
+    void division_into(Matrix& out, const View& a, const View& b);
+    void division_into(Matrix& out, const View& a, const int s);
+
+    // Compound in-place variants
+    void add_inplace(Matrix& a, const View& b);                         // a += b
+    void subtract_inplace(Matrix& a, const View& b);                    // a -= b
+    void scale_inplace(Matrix& a, const double scalar);                 // a *= scalar
+    void axpy(const double alpha, const View& x, Matrix& y);            // y += alpha * x
+    void fma_inplace(Matrix& y, const View& a, const View& b);          // y += a * b (element-wise)
 
     double randnum();
     std::vector<double> randn(const int n);
     Matrix randn(const int rows, const int cols);
+    Matrix randn(const int rows, const int cols, const std::string& name);
+    Matrix randn(const int rows, const int cols, const std::string& name, const uint64_t seed);
     Tensor3D randn(const int rows, const int timesteps, const int cols);
     Matrix sliceCols(const Matrix& mat, size_t start_col, size_t end_col);
-    std::vector<double> reshape(const Matrix& m);
+    std::vector<double> reshape(const View& m);
     Matrix reshape(const std::vector<double> v);
 
     void printVector(const std::vector<double>& vec);
@@ -0,0 +1,156 @@
+#include "memory.h"
+
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace memory {
+    namespace {
+        enum class Kind { Heap, Mapped, HugeTLB };
+
+        struct Region {
+            size_t bytes;  //Requested
+            size_t mapped; //Length of the mapping, 0 for heap allocations
+            Kind kind;
+            bool advised;
+        };
+
+        std::atomic<HugePages> policy{HugePages::Off};
+        std::mutex registry_mutex;
+        std::unordered_map<void*, Region> registry;
+
+        size_t round_up(const size_t n, const size_t multiple) {
+            return (n + multiple - 1) / multiple * multiple;
+        }
+
+#if defined(__linux__)
+        //Anonymous mapping trimmed to a HUGE_PAGE boundary, transparent huge pages need aligned 2MB ranges
+        void* map_aligned(const size_t length) {
+            const size_t padded = length + HUGE_PAGE;
+            void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) {
+                return nullptr;
+            }
+            const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+            const uintptr_t aligned = round_up(start, HUGE_PAGE);
+            if (aligned > start) {
+                munmap(raw, aligned - start);
+            }
+            const uintptr_t tail = aligned + length;
+            if (start + padded > tail) {
+                munmap(reinterpret_cast<void*>(tail), start + padded - tail);
+            }
+            return reinterpret_cast<void*>(aligned);
+        }
+#endif
+    }
+
+    void set_huge_pages(const HugePages value) {
+        policy = value;
+    }
+
+    HugePages huge_pages() {
+        return policy;
+    }
+
+    void* allocate(const size_t bytes) {
+        Region region{bytes, 0, Kind::Heap, false};
+        void* p = nullptr;
+
+#if defined(__linux__)
+        const HugePages current = policy;
+        if (current != HugePages::Off && bytes >= HUGE_PAGE) {
+            const size_t length = round_up(bytes, HUGE_PAGE);
+            if (current == HugePages::Explicit) {
+                p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (p == MAP_FAILED) {
+                    p = nullptr; //Pool empty or not configured
+                } else {
+                    region = {bytes, length, Kind::HugeTLB, false};
+                }
+            }
+            if (p == nullptr) {
+                p = map_aligned(length);
+                if (p != nullptr) {
+                    region = {bytes, length, Kind::Mapped, madvise(p, length, MADV_HUGEPAGE) == 0};
+                }
+            }
+        }
+#endif
+        if (p == nullptr) {
+            p = std::aligned_alloc(ALIGNMENT, round_up(std::max<size_t>(bytes, 1), ALIGNMENT));
+            if (p == nullptr) {
+                throw std::bad_alloc();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.emplace(p, region);
+        return p;
+    }
+
+    void deallocate(void* p) {
+        if (p == nullptr) {
+            return;
+        }
+        Region region;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            const auto it = registry.find(p);
+            if (it == registry.end()) {
+                return;
+            }
+            region = it->second;
+            registry.erase(it);
+        }
+#if defined(__linux__)
+        if (region.kind != Kind::Heap) {
+            munmap(p, region.mapped);
+            return;
+        }
+#endif
+        std::free(p);
+    }
+
+    Stats stats() {
+        Stats result;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            for (const auto& [p, region] : registry) {
+                result.allocated_bytes += region.bytes;
+                result.regions++;
+                if (region.kind == Kind::HugeTLB) {
+                    result.hugetlb_bytes += region.bytes;
+                }
+                if (region.advised) {
+                    result.advised_bytes += region.bytes;
+                }
+            }
+        }
+#if defined(__linux__)
+        //"AnonHugePages:   4096 kB"
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        std::string key;
+        size_t kb;
+        std::string unit;
+        while (smaps >> key) {
+            if (key == "AnonHugePages:" && smaps >> kb >> unit) {
+                result.anon_huge_bytes = kb * 1024;
+                break;
+            }
+            smaps.ignore(256, '\n');
+        }
+#endif
+        return result;
+    }
+}
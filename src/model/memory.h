@@ -0,0 +1,52 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <memory>
+#include <cstddef>
+
+/*
+ * Allocator for large contiguous buffers (workspace arenas, flat datasets), with optional 2MB huge pages.
+ *
+ * Every allocation is at least 64-byte aligned for SIMD loads. Below HUGE_PAGE bytes, or with the policy Off, it
+ * is an aligned heap allocation. Larger regions are mapped separately on Linux:
+ * - Explicit uses MAP_HUGETLB from the pre-reserved pool (vm.nr_hugepages), then falls back to Transparent.
+ * - Transparent maps a 2MB-aligned anonymous region and marks it MADV_HUGEPAGE, so khugepaged can back it
+ *   with huge pages.
+ * On other systems huge pages are not used and the policy has no effect.
+ */
+namespace memory {
+    enum class HugePages { Off, Transparent, Explicit };
+
+    constexpr size_t ALIGNMENT = 64;
+    constexpr size_t HUGE_PAGE = size_t(2) << 20;
+
+    //Policy for allocations made after the call. Default Off
+    void set_huge_pages(HugePages policy);
+    HugePages huge_pages();
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p); //p must come from allocate, nullptr is ignored
+
+    struct Stats {
+        size_t allocated_bytes = 0;  //Live bytes handed out by allocate
+        size_t regions = 0;          //Live allocations
+        size_t hugetlb_bytes = 0;    //Live bytes mapped with MAP_HUGETLB
+        size_t advised_bytes = 0;    //Live bytes marked MADV_HUGEPAGE
+        size_t anon_huge_bytes = 0;  //Transparent huge pages backing the whole process (AnonHugePages), Linux only
+    };
+    Stats stats();
+
+    //Owning typed buffer from allocate
+    struct Deleter {
+        void operator()(void* p) const { deallocate(p); }
+    };
+    template <typename T>
+    using Buffer = std::unique_ptr<T[], Deleter>;
+
+    template <typename T>
+    Buffer<T> make_buffer(const size_t n) {
+        return Buffer<T>(static_cast<T*>(allocate(n * sizeof(T))));
+    }
+}
+
+#endif //MEMORY_H
@@ -0,0 +1,266 @@
+#include "numa.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include <new>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace numa {
+    namespace {
+        //"0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+        std::vector<int> parse_cpulist(const std::string& list) {
+            std::vector<int> cpus;
+            std::stringstream ss(list);
+            std::string range;
+            while (std::getline(ss, range, ',')) {
+                if (range.empty() || range == "\n") {
+                    continue;
+                }
+                const size_t dash = range.find('-');
+                const int first = std::stoi(range.substr(0, dash));
+                const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; cpu++) {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+        std::vector<Node> read_topology() {
+            std::vector<Node> nodes;
+#if defined(__linux__)
+            if (DIR* dir = opendir("/sys/devices/system/node")) {
+                while (dirent* entry = readdir(dir)) {
+                    const std::string name = entry->d_name;
+                    if (name.rfind("node", 0) != 0 || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                        continue;
+                    }
+                    std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+                    std::string list;
+                    if (file && std::getline(file, list)) {
+                        Node node{std::stoi(name.substr(4)), parse_cpulist(list)};
+                        if (!node.cpus.empty()) { //Memory-only nodes have no CPUs to run on
+                            nodes.push_back(std::move(node));
+                        }
+                    }
+                }
+                closedir(dir);
+            }
+            std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+#endif
+            if (nodes.empty()) {
+                Node node{0, {}};
+                for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++) {
+                    node.cpus.push_back(static_cast<int>(cpu));
+                }
+                nodes.push_back(std::move(node));
+            }
+            return nodes;
+        }
+
+#if defined(__linux__)
+        bool set_affinity(const std::vector<int>& cpus) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        }
+#else
+        bool set_affinity(const std::vector<int>&) {
+            return false;
+        }
+#endif
+    }
+
+    const std::vector<Node>& topology() {
+        static const std::vector<Node> nodes = read_topology();
+        return nodes;
+    }
+
+    size_t num_nodes() {
+        return topology().size();
+    }
+
+    int node_of_cpu(const int cpu) {
+        for (const Node& node : topology()) {
+            if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+                return node.id;
+            }
+        }
+        return topology()[0].id;
+    }
+
+    int current_node() {
+#if defined(__linux__)
+        const int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return node_of_cpu(cpu);
+        }
+#endif
+        return topology()[0].id;
+    }
+
+    int cpu_for_thread(const size_t index) {
+        size_t total = 0;
+        for (const Node& node : topology()) {
+            total += node.cpus.size();
+        }
+        size_t k = index % total;
+        for (const Node& node : topology()) {
+            if (k < node.cpus.size()) {
+                return node.cpus[k];
+            }
+            k -= node.cpus.size();
+        }
+        return 0;
+    }
+
+    bool pin_to_cpu(const int cpu) {
+        return set_affinity({cpu});
+    }
+
+    bool pin_to_node(const int node) {
+        for (const Node& candidate : topology()) {
+            if (candidate.id == node) {
+                return set_affinity(candidate.cpus);
+            }
+        }
+        return false;
+    }
+
+    void run_on_node(const int node, const std::function<void()>& fn) {
+        std::exception_ptr error;
+        std::thread worker([&]() {
+            pin_to_node(node);
+            try {
+                fn();
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+        worker.join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    Arena::Arena(const size_t block_doubles) : block_doubles(std::max<size_t>(block_doubles, 8)), home_node(current_node()) {}
+
+    double* Arena::allocate(const size_t n) {
+        const size_t padded = (n + 7) / 8 * 8; //Keeps every allocation on a 64-byte boundary (memory::ALIGNMENT)
+        for (Block& block : blocks) {
+            if (block.size - block.used >= padded) {
+                double* p = block.data.get() + block.used;
+                block.used += padded;
+                return p;
+            }
+        }
+
+        Block block;
+        block.size = std::max(block_doubles, padded);
+        block.data = memory::make_buffer<double>(block.size);
+        //First touch from the owning thread places the pages on its node
+        std::fill(block.data.get(), block.data.get() + block.size, 0.0);
+        block.used = padded;
+        blocks.push_back(std::move(block));
+        return blocks.back().data.get();
+    }
+
+    void Arena::reset() {
+        const int node = current_node();
+        if (node != home_node) {
+            blocks.clear(); //Remote now, the next allocations are touched on the new node
+            home_node = node;
+        }
+        for (Block& block : blocks) {
+            block.used = 0;
+        }
+    }
+
+    size_t Arena::capacity() const {
+        size_t total = 0;
+        for (const Block& block : blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    Arena& local_arena() {
+        thread_local Arena arena;
+        return arena;
+    }
+
+    Bandwidth benchmark(const size_t bytes, const int repeats) {
+        const std::vector<Node>& nodes = topology();
+        const size_t n = std::max<size_t>(bytes / sizeof(double), 1);
+        const size_t page = 4096 / sizeof(double);
+
+        //Pages of the buffer are first-touched by node_for(page index)
+        auto place = [&](const std::function<int(size_t)>& node_for) {
+            std::unique_ptr<double, void (*)(void*)> buffer(static_cast<double*>(std::aligned_alloc(4096, (n + page - 1) / page * page * sizeof(double))), std::free);
+            if (!buffer) {
+                throw std::bad_alloc();
+            }
+            for (const Node& node : nodes) {
+                run_on_node(node.id, [&]() {
+                    for (size_t p = 0; p * page < n; p++) {
+                        if (node_for(p) == node.id) {
+                            std::fill(buffer.get() + p * page, buffer.get() + std::min(n, (p + 1) * page), 1.0);
+                        }
+                    }
+                });
+            }
+            return buffer;
+        };
+
+        //Best of `repeats` full reads from node 0
+        auto read_bandwidth = [&](const double* data) {
+            double best = 0.0;
+            run_on_node(nodes.front().id, [&]() {
+                for (int r = 0; r < repeats; r++) {
+                    const auto start = std::chrono::steady_clock::now();
+                    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+                    size_t i = 0;
+                    for (; i + 4 <= n; i += 4) {
+                        sum[0] += data[i];
+                        sum[1] += data[i + 1];
+                        sum[2] += data[i + 2];
+                        sum[3] += data[i + 3];
+                    }
+                    for (; i < n; i++) {
+                        sum[0] += data[i];
+                    }
+                    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    volatile double sink = sum[0] + sum[1] + sum[2] + sum[3];
+                    (void)sink;
+                    best = std::max(best, n * sizeof(double) / seconds / 1e9);
+                }
+            });
+            return best;
+        };
+
+        Bandwidth result;
+        result.nodes = nodes.size();
+        result.local = read_bandwidth(place([&](size_t) { return nodes.front().id; }).get());
+        result.interleaved = read_bandwidth(place([&](const size_t p) { return nodes[p % nodes.size()].id; }).get());
+        result.remote = read_bandwidth(place([&](size_t) { return nodes.back().id; }).get());
+        return result;
+    }
+}
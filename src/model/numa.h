@@ -0,0 +1,83 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+#include "memory.h"
+
+/*
+ * NUMA topology, thread pinning and node-local memory placement.
+ *
+ * The topology is read once from /sys/devices/system/node (Linux). Elsewhere, or if sysfs is unavailable, the
+ * machine is reported as a single node holding every hardware thread, and pinning is a no-op. Memory is placed by
+ * first touch: Linux backs a page on the node of the thread that first writes it, so buffers initialised by a
+ * thread pinned to a node are local to that node. No libnuma is needed.
+ */
+namespace numa {
+    struct Node {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    const std::vector<Node>& topology();
+    size_t num_nodes();
+    int node_of_cpu(int cpu);
+    int current_node(); //Node of the CPU the calling thread runs on, 0 if unknown
+
+    //CPU for the index-th thread of a pool: nodes are filled one after the other so neighbouring workers share a
+    //node, wrapping around when there are more threads than CPUs
+    int cpu_for_thread(size_t index);
+
+    //Pin the calling thread to one CPU, or to all CPUs of a node. Returns false when pinning is unsupported
+    bool pin_to_cpu(int cpu);
+    bool pin_to_node(int node);
+
+    //Run fn on a temporary thread pinned to node and wait for it, e.g. to first-touch a buffer on that node
+    void run_on_node(int node, const std::function<void()>& fn);
+
+    //Bump allocator for per-thread scratch buffers. Blocks come from memory::allocate (64-byte aligned, huge pages
+    //per memory::set_huge_pages) and are first-touched by the thread that creates them, so they are local to its
+    //node; reset() makes the memory reusable and drops the blocks if the thread has since moved to another node
+    class Arena {
+    public:
+        explicit Arena(size_t block_doubles = memory::HUGE_PAGE / sizeof(double));
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        double* allocate(size_t n); //Valid until reset()
+        void reset();
+
+        size_t capacity() const; //Doubles held across all blocks
+        int node() const { return home_node; }
+
+    private:
+        struct Block {
+            memory::Buffer<double> data;
+            size_t size = 0;
+            size_t used = 0;
+        };
+
+        size_t block_doubles;
+        int home_node = 0;
+        std::vector<Block> blocks;
+    };
+
+    //The calling thread's arena
+    Arena& local_arena();
+
+    //Read bandwidth (GB/s) of a buffer read from node 0 when its pages are on node 0 (local), spread round-robin
+    //over all nodes (interleaved), or on the last node (remote). On a single node the three coincide
+    struct Bandwidth {
+        size_t nodes = 1;
+        double local = 0.0;
+        double interleaved = 0.0;
+        double remote = 0.0;
+    };
+    Bandwidth benchmark(size_t bytes = size_t(256) << 20, int repeats = 5);
+}
+
+#endif //NUMA_H
@@ -0,0 +1,159 @@
+#include "parallel.h"
+#include "numa.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+
+namespace parallel {
+    ThreadPool::ThreadPool(const size_t num_threads, const bool pin) {
+        for (size_t i = 0; i < num_threads; i++) {
+            workers.emplace_back([this, i, pin]() {
+                if (pin) {
+                    numa::pin_to_cpu(numa::cpu_for_thread(i + 1));
+                }
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex);
+                        condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (stopping && tasks.empty()) {
+                            return;
+                        }
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            tasks.push(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+    namespace {
+        std::mutex pool_mutex;
+        std::unique_ptr<ThreadPool> global_pool;
+        std::atomic<bool> deterministic_mode{false};
+        bool pinned = false;
+
+        //The calling thread always participates, so the pool holds one thread less than requested
+        size_t default_workers() {
+            const size_t hardware = std::thread::hardware_concurrency();
+            return hardware > 1 ? hardware - 1 : 0;
+        }
+    }
+
+    ThreadPool& pool() {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!global_pool) {
+            global_pool = std::make_unique<ThreadPool>(default_workers(), pinned);
+        }
+        return *global_pool;
+    }
+
+    void set_num_threads(const size_t n) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        global_pool = std::make_unique<ThreadPool>(n > 1 ? n - 1 : 0, pinned);
+    }
+
+    void set_pinning(const bool enabled) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        pinned = enabled;
+        const size_t workers = global_pool ? global_pool->size() : default_workers();
+        global_pool.reset(); //Joins the old workers before the new ones are pinned
+        global_pool = std::make_unique<ThreadPool>(workers, pinned);
+    }
+
+    size_t num_threads() {
+        return pool().size() + 1;
+    }
+
+    void set_deterministic(const bool enabled) {
+        deterministic_mode = enabled;
+    }
+
+    bool deterministic() {
+        return deterministic_mode;
+    }
+
+    void parallel_for(const size_t begin, const size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+        if (end <= begin) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        const size_t num_chunks = (end - begin + grain - 1) / grain;
+
+        ThreadPool& workers = pool();
+        if (num_chunks == 1 || workers.size() == 0) {
+            fn(begin, end);
+            return;
+        }
+
+        //Shared between the caller and the helper tasks, helpers that start late find no chunk left and exit
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::exception_ptr error;
+            size_t error_chunk = 0;
+        };
+        auto state = std::make_shared<State>();
+
+        auto run = [state, begin, end, grain, num_chunks, &fn]() {
+            size_t chunk;
+            while ((chunk = state->next.fetch_add(1)) < num_chunks) {
+                const size_t lo = begin + chunk * grain;
+                const size_t hi = std::min(end, lo + grain);
+                try {
+                    fn(lo, hi);
+                } catch (...) {
+                    //Keep the lowest chunk's exception, so the error reported does not depend on scheduling
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error || chunk < state->error_chunk) {
+                        state->error = std::current_exception();
+                        state->error_chunk = chunk;
+                    }
+                }
+                if (state->done.fetch_add(1) + 1 == num_chunks) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        const size_t helpers = std::min(num_chunks - 1, workers.size());
+        for (size_t i = 0; i < helpers; i++) {
+            workers.enqueue(run);
+        }
+        run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state, num_chunks]() { return state->done.load() == num_chunks; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+}
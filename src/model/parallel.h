@@ -0,0 +1,71 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace parallel {
+    //Fixed-size pool of worker threads consuming a FIFO task queue
+    class ThreadPool {
+    public:
+        //With pin, worker i is pinned to numa::cpu_for_thread(i + 1), index 0 being left for the calling thread
+        explicit ThreadPool(size_t num_threads, bool pin = false);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t size() const { return workers.size(); }
+        void enqueue(std::function<void()> task);
+
+        //Run f on a worker, the returned future carries its result or exception
+        template <typename F>
+        auto submit(F&& f) -> std::future<std::invoke_result_t<F>> {
+            using Result = std::invoke_result_t<F>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+            std::future<Result> result = task->get_future();
+            enqueue([task]() { (*task)(); });
+            return result;
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex queue_mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+    };
+
+    //Process-wide pool shared by the linalg kernels, data loading and training drivers
+    ThreadPool& pool();
+
+    //Total threads used by parallel_for, including the calling thread. Must not be changed while work is in flight
+    void set_num_threads(size_t n);
+    size_t num_threads();
+
+    //Pin pool workers to cores, filling one NUMA node before the next (numa.h). Recreates the pool, so it must not
+    //be changed while work is in flight. Off by default
+    void set_pinning(bool enabled);
+
+    //Reproducibility mode for audits. Kernels and reductions never depend on scheduling: chunk boundaries are
+    //fixed by parallel_for, partial sums are combined in a fixed pairwise tree (reductions.h) and loss/gradient
+    //accumulation runs in sample and timestep order, so results are bitwise identical for any thread count.
+    //Deterministic mode additionally fixes the drivers whose decisions depend on completion order (e.g. Sweep
+    //switches from asynchronous to synchronous successive halving). Off by default
+    void set_deterministic(bool enabled);
+    bool deterministic();
+
+    //Split [begin, end) into chunks of `grain` and run fn(chunk_begin, chunk_end) on the pool, blocking until all
+    //chunks are done. The calling thread takes chunks too, so nested calls from inside a task cannot deadlock.
+    //Chunk boundaries depend only on begin, end and grain, never on the number of threads. If chunks throw, the
+    //exception of the lowest chunk is rethrown.
+    void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+}
+
+#endif //PARALLEL_H
@@ -0,0 +1,263 @@
+#include "reductions.h"
+#include "parallel.h"
+#include "linalg.h"
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace reductions {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        //A view resolved to its storage: nr rows of nc contiguous values, never transposed
+        struct Block {
+            linalg::View v;
+            size_t nr, nc;
+            const double* row(const size_t i) const { return v.row(i); }
+        };
+
+        Block storageOf(const linalg::View& v) {
+            return Block{v, v.n_rows, v.n_cols};
+        }
+
+        //Axis 0 of a transposed view is axis 1 of its storage
+        int storageAxis(const linalg::View& v, const int axis) {
+            const int view_axis = (axis == 0) ? 0 : 1;
+            return v.transposed ? 1 - view_axis : view_axis;
+        }
+
+        //Rows per chunk when a reduction is split over the pool
+        size_t rowGrain(const Block& b) {
+            return std::max<size_t>(1, PARALLEL_THRESHOLD / std::max<size_t>(1, b.nc) / 4);
+        }
+
+        //out[i] = f(row i, i) for every storage row. Rows are independent, so chunking cannot change the result
+        template <typename F>
+        std::vector<double> perRow(const Block& b, const F& f) {
+            std::vector<double> out(b.nr);
+            const auto body = [&](const size_t lo, const size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    out[i] = f(b.row(i), i);
+                }
+            };
+            if (b.nr * b.nc >= PARALLEL_THRESHOLD) {
+                parallel::parallel_for(0, b.nr, rowGrain(b), body);
+            } else {
+                body(0, b.nr);
+            }
+            return out;
+        }
+
+        //out[j] = sum over rows of f(x_ij, i, j). Each chunk of PAIRWISE_BLOCK rows accumulates row by row into its
+        //own partial vector (contiguous, vectorisable), then the partials are combined as a balanced binary tree
+        template <typename F>
+        std::vector<double> perColumnSum(const Block& b, const F& f) {
+            const size_t num_chunks = (b.nr + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK;
+            std::vector<std::vector<double>> partials(num_chunks, std::vector<double>(b.nc, 0.0));
+
+            const auto body = [&](const size_t lo, const size_t hi) {
+                for (size_t chunk = lo; chunk < hi; chunk++) {
+                    double* partial = partials[chunk].data();
+                    const size_t row_end = std::min(b.nr, (chunk + 1) * PAIRWISE_BLOCK);
+                    for (size_t i = chunk * PAIRWISE_BLOCK; i < row_end; i++) {
+                        const double* row = b.row(i);
+                        for (size_t j = 0; j < b.nc; j++) {
+                            partial[j] += f(row[j], i, j);
+                        }
+                    }
+                }
+            };
+            if (b.nr * b.nc >= PARALLEL_THRESHOLD) {
+                parallel::parallel_for(0, num_chunks, std::max<size_t>(1, rowGrain(b) / PAIRWISE_BLOCK), body);
+            } else {
+                body(0, num_chunks);
+            }
+
+            //Fixed tree order: (0+1) (2+3) ..., then (0+2) ..., independent of how the chunks were scheduled
+            for (size_t step = 1; step < num_chunks; step *= 2) {
+                for (size_t chunk = 0; chunk + step < num_chunks; chunk += 2 * step) {
+                    for (size_t j = 0; j < b.nc; j++) {
+                        partials[chunk][j] += partials[chunk + step][j];
+                    }
+                }
+            }
+            return num_chunks > 0 ? partials[0] : std::vector<double>(b.nc, 0.0);
+        }
+
+        //Extremum of every storage column, `better(a, b)` is true when a should replace b
+        template <typename Better>
+        std::vector<double> perColumnExtremum(const Block& b, const Better& better) {
+            if (b.nr == 0) {
+                throw std::invalid_argument("Extremum of an empty column");
+            }
+            std::vector<double> out(b.row(0), b.row(0) + b.nc);
+            for (size_t i = 1; i < b.nr; i++) {
+                const double* row = b.row(i);
+                for (size_t j = 0; j < b.nc; j++) {
+                    if (better(row[j], out[j])) {
+                        out[j] = row[j];
+                    }
+                }
+            }
+            return out;
+        }
+
+        template <typename Better>
+        double rowExtremum(const double* row, const size_t n, const Better& better) {
+            if (n == 0) {
+                throw std::invalid_argument("Extremum of an empty row");
+            }
+            double best = row[0];
+            for (size_t j = 1; j < n; j++) {
+                if (better(row[j], best)) {
+                    best = row[j];
+                }
+            }
+            return best;
+        }
+
+        //Shape a vector of per-slice results for the requested view axis
+        Matrix keepdims(const std::vector<double>& values, const int axis) {
+            if (axis == 0) {
+                return Matrix(1, values);
+            }
+            Matrix result(values.size(), std::vector<double>(1));
+            for (size_t i = 0; i < values.size(); i++) {
+                result[i][0] = values[i];
+            }
+            return result;
+        }
+
+        //Sum of f(x_ij, i, j) along the given view axis, i and j are storage indices
+        template <typename F>
+        std::vector<double> sumAlong(const linalg::View& m, const int axis, const F& f) {
+            const Block b = storageOf(m);
+            if (storageAxis(m, axis) == 0) {
+                return perColumnSum(b, f);
+            }
+            return perRow(b, [&](const double* row, const size_t i) {
+                return pairwiseSum(b.nc, [&](const size_t j) { return f(row[j], i, j); });
+            });
+        }
+
+        template <typename F>
+        double sumAllWith(const linalg::View& m, const F& f) {
+            const Block b = storageOf(m);
+            const std::vector<double> row_sums = perRow(b, [&](const double* row, const size_t i) {
+                return pairwiseSum(b.nc, [&](const size_t j) { return f(row[j], i, j); });
+            });
+            return pairwiseSum(row_sums.size(), [&](const size_t i) { return row_sums[i]; });
+        }
+
+        template <typename Better>
+        std::vector<double> extremumAlong(const linalg::View& m, const int axis, const Better& better) {
+            const Block b = storageOf(m);
+            if (storageAxis(m, axis) == 0) {
+                return perColumnExtremum(b, better);
+            }
+            return perRow(b, [&](const double* row, const size_t) { return rowExtremum(row, b.nc, better); });
+        }
+
+        const auto identity = [](const double x, const size_t, const size_t) { return x; };
+        const auto square = [](const double x, const size_t, const size_t) { return x * x; };
+        const auto greater = [](const double a, const double b) { return a > b; };
+        const auto less = [](const double a, const double b) { return a < b; };
+    }
+
+    double sum(const std::vector<double>& v) {
+        return pairwiseSum(v.size(), [&v](const size_t i) { return v[i]; });
+    }
+
+    double kahanSum(const std::vector<double>& v) {
+        KahanAccumulator accumulator;
+        for (const double x : v) {
+            accumulator.add(x);
+        }
+        return accumulator.value();
+    }
+
+    void KahanAccumulator::add(const double value) {
+        const double t = sum + value;
+        //Recover the low-order bits lost by whichever operand was smaller
+        if (std::abs(sum) >= std::abs(value)) {
+            compensation += (sum - t) + value;
+        } else {
+            compensation += (value - t) + sum;
+        }
+        sum = t;
+    }
+
+    Matrix sum(const linalg::View& m, const int axis) {
+        return keepdims(sumAlong(m, axis, identity), axis);
+    }
+
+    Matrix mean(const linalg::View& m, const int axis) {
+        const double count = static_cast<double>((axis == 0) ? m.rows() : m.cols());
+        std::vector<double> values = sumAlong(m, axis, identity);
+        for (double& value : values) {
+            value /= count;
+        }
+        return keepdims(values, axis);
+    }
+
+    Matrix variance(const linalg::View& m, const int axis) {
+        //Two passes: the mean, then the mean squared deviation from it
+        const double count = static_cast<double>((axis == 0) ? m.rows() : m.cols());
+        std::vector<double> means = sumAlong(m, axis, identity);
+        for (double& value : means) {
+            value /= count;
+        }
+
+        //Index of the mean for storage element (i, j)
+        const bool per_column = storageAxis(m, axis) == 0;
+        std::vector<double> values = sumAlong(m, axis, [&](const double x, const size_t i, const size_t j) {
+            const double deviation = x - means[per_column ? j : i];
+            return deviation * deviation;
+        });
+        for (double& value : values) {
+            value /= count;
+        }
+        return keepdims(values, axis);
+    }
+
+    Matrix max(const linalg::View& m, const int axis) {
+        return keepdims(extremumAlong(m, axis, greater), axis);
+    }
+
+    Matrix min(const linalg::View& m, const int axis) {
+        return keepdims(extremumAlong(m, axis, less), axis);
+    }
+
+    Matrix norm(const linalg::View& m, const int axis) {
+        std::vector<double> values = sumAlong(m, axis, square);
+        for (double& value : values) {
+            value = std::sqrt(value);
+        }
+        return keepdims(values, axis);
+    }
+
+    double sumAll(const linalg::View& m) {
+        return sumAllWith(m, identity);
+    }
+
+    double meanAll(const linalg::View& m) {
+        return sumAll(m) / static_cast<double>(m.rows() * m.cols());
+    }
+
+    double maxAll(const linalg::View& m) {
+        const std::vector<double> row_max = extremumAlong(m, 1, greater);
+        return rowExtremum(row_max.data(), row_max.size(), greater);
+    }
+
+    double minAll(const linalg::View& m) {
+        const std::vector<double> row_min = extremumAlong(m, 1, less);
+        return rowExtremum(row_min.data(), row_min.size(), less);
+    }
+
+    double norm(const linalg::View& m) {
+        return std::sqrt(sumAllWith(m, square));
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef REDUCTIONS_H
+#define REDUCTIONS_H
+
+#include <vector>
+#include <cstddef>
+
+#include "linalg.h"
+
+/*
+ * Reductions over linalg matrices and views.
+ *
+ * Sums are pairwise: blocks of 128 elements are summed with 8 independent accumulators (which the compiler can
+ * keep in SIMD registers) and blocks are combined as a balanced tree, so rounding error grows with O(log n)
+ * instead of O(n) on long series. Axis-0 reductions walk the data row by row, never down a column.
+ * Inputs above PARALLEL_THRESHOLD elements are split over parallel::pool() in fixed-size chunks whose partials are
+ * combined in a fixed tree order, so results do not depend on the number of threads.
+ */
+namespace reductions {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    constexpr size_t PAIRWISE_BLOCK = 128;
+    constexpr size_t PARALLEL_THRESHOLD = 1 << 15;
+
+    namespace detail {
+        template <typename F>
+        double pairwiseSum(const size_t begin, const size_t end, const F& element) {
+            const size_t n = end - begin;
+            if (n <= PAIRWISE_BLOCK) {
+                double acc[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+                size_t i = begin;
+                for (; i + 8 <= end; i += 8) {
+                    for (size_t k = 0; k < 8; k++) {
+                        acc[k] += element(i + k);
+                    }
+                }
+                double sum = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+                for (; i < end; i++) {
+                    sum += element(i);
+                }
+                return sum;
+            }
+            //Split on a multiple of 8 so every leaf block keeps its accumulators full
+            const size_t mid = begin + (n / 2) / 8 * 8;
+            return pairwiseSum(begin, mid, element) + pairwiseSum(mid, end, element);
+        }
+    }
+
+    //Pairwise sum of element(0) + ... + element(n-1)
+    template <typename F>
+    double pairwiseSum(const size_t n, const F& element) {
+        return detail::pairwiseSum(0, n, element);
+    }
+
+    double sum(const std::vector<double>& v);
+    double kahanSum(const std::vector<double>& v);
+
+    //Compensated (Kahan-Babuska) running sum, for values that arrive one at a time such as per-batch losses
+    class KahanAccumulator {
+    public:
+        void add(const double value);
+        double value() const { return sum + compensation; }
+        void reset() { sum = 0.0; compensation = 0.0; }
+
+    private:
+        double sum = 0.0;
+        double compensation = 0.0;
+    };
+
+    //Axis reductions, keepdims = True: axis 0 gives (1, n), axis 1 gives (m, 1)
+    Matrix sum(const linalg::View& m, const int axis);
+    Matrix mean(const linalg::View& m, const int axis);
+    Matrix variance(const linalg::View& m, const int axis); //Population variance
+    Matrix max(const linalg::View& m, const int axis);
+    Matrix min(const linalg::View& m, const int axis);
+    Matrix norm(const linalg::View& m, const int axis);     //L2 norm
+
+    //Whole-matrix reductions
+    double sumAll(const linalg::View& m);
+    double meanAll(const linalg::View& m);
+    double maxAll(const linalg::View& m);
+    double minAll(const linalg::View& m);
+    double norm(const linalg::View& m);                     //Frobenius norm
+}
+
+#endif //REDUCTIONS_H
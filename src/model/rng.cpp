@@ -0,0 +1,135 @@
+#include "rng.h"
+#include "parallel.h"
+
+#include <vector>
+#include <array>
+#include <string>
+#include <atomic>
+#include <cmath>
+#include <numbers>
+
+namespace rng {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    namespace {
+        constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+        constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+        constexpr uint32_t PHILOX_W0 = 0x9E3779B9; //Golden ratio
+        constexpr uint32_t PHILOX_W1 = 0xBB67AE85; //sqrt(3) - 1
+        constexpr int PHILOX_ROUNDS = 10;
+
+        //Elements per parallel chunk when filling a matrix
+        constexpr size_t FILL_GRAIN = 1 << 14;
+
+        std::atomic<uint64_t> global_seed{0}; //Matches the previous fixed mt19937 seed
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> model_sequence{0};
+
+        inline void mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi, uint32_t& lo) {
+            const uint64_t product = static_cast<uint64_t>(a) * b;
+            hi = static_cast<uint32_t>(product >> 32);
+            lo = static_cast<uint32_t>(product);
+        }
+
+        std::array<uint32_t, 4> block(const uint64_t seed, const uint64_t stream, const uint64_t index) {
+            return philox4x32(
+                {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)},
+                {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+        }
+
+        //53 random bits -> [0, 1)
+        inline double toUnit(const uint32_t hi, const uint32_t lo) {
+            const uint64_t bits = (static_cast<uint64_t>(hi) << 21) ^ (lo >> 11);
+            return static_cast<double>(bits & ((1ULL << 53) - 1)) * 0x1.0p-53;
+        }
+    }
+
+    std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+        for (int round = 0; round < PHILOX_ROUNDS; round++) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(PHILOX_M0, counter[0], hi0, lo0);
+            mulhilo(PHILOX_M1, counter[2], hi1, lo1);
+            counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+            key[0] += PHILOX_W0;
+            key[1] += PHILOX_W1;
+        }
+        return counter;
+    }
+
+    void set_seed(const uint64_t seed) {
+        global_seed = seed;
+    }
+
+    uint64_t seed() {
+        return global_seed;
+    }
+
+    uint64_t tensor_id(const std::string& name) {
+        //FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const unsigned char c : name) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    uint64_t next_tensor_id() {
+        //Top bit set so sequential ids never collide with small hand-picked streams
+        return (1ULL << 63) | sequence.fetch_add(1);
+    }
+
+    uint64_t derive_seed(const uint64_t seed, const uint64_t id) {
+        //SplitMix64 finaliser of seed and id, so neighbouring ids give unrelated keys
+        uint64_t z = seed ^ (id * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t next_model_id() {
+        //Top bit set so sequence ids never equal the small explicit ids of replicas, trials or folds
+        return (1ULL << 63) | model_sequence.fetch_add(1);
+    }
+
+    double uniform(const uint64_t seed, const uint64_t stream, const uint64_t index) {
+        const std::array<uint32_t, 4> r = block(seed, stream, index);
+        return toUnit(r[0], r[1]);
+    }
+
+    double normal(const uint64_t seed, const uint64_t stream, const uint64_t index) {
+        //Box-Muller on the two 53-bit uniforms of one Philox block, u1 in (0, 1] so the log is finite
+        const std::array<uint32_t, 4> r = block(seed, stream, index);
+        const double u1 = 1.0 - toUnit(r[0], r[1]);
+        const double u2 = toUnit(r[2], r[3]);
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+    }
+
+    void fillNormal(Matrix& m, const uint64_t seed, const uint64_t stream, const double mean, const double stdev) {
+        if (m.empty()) {
+            return;
+        }
+        const size_t cols = m[0].size();
+        const size_t rows_per_chunk = std::max<size_t>(1, FILL_GRAIN / std::max<size_t>(1, cols));
+
+        parallel::parallel_for(0, m.size(), rows_per_chunk, [&](const size_t lo, const size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                for (size_t j = 0; j < cols; j++) {
+                    m[i][j] = mean + stdev * normal(seed, stream, i * cols + j);
+                }
+            }
+        });
+    }
+
+    std::vector<int> permutation(const int n, const uint64_t seed, const uint64_t stream) {
+        std::vector<int> result(n);
+        for (int i = 0; i < n; i++) {
+            result[i] = i;
+        }
+        for (int i = n - 1; i > 0; i--) {
+            const int j = static_cast<int>(uniform(seed, stream, i) * (i + 1));
+            std::swap(result[i], result[j]);
+        }
+        return result;
+    }
+}
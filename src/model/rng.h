@@ -0,0 +1,45 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
+
+/*
+ * Counter-based random numbers (Philox4x32-10, Salmon et al. 2011).
+ *
+ * Every draw is a pure function of (seed, stream, index): the stream identifies a tensor (see tensor_id) and the
+ * index is the element's position in it. There is no generator state to share or advance, so a matrix can be
+ * filled by any number of threads in any order and always holds the same values for the same seed.
+ */
+namespace rng {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+    //Process-wide default seed used when none is given
+    void set_seed(const uint64_t seed);
+    uint64_t seed();
+
+    //Stream id derived from a tensor's name (e.g. "Wf1"), independent of creation order
+    uint64_t tensor_id(const std::string& name);
+    //Next id of a process-wide sequence, for anonymous tensors created in program order
+    uint64_t next_tensor_id();
+
+    //Seed of the model (or replica, trial, fold...) `id` under `seed`: distinct ids give independent streams
+    uint64_t derive_seed(const uint64_t seed, const uint64_t id);
+    //Next of a process-wide sequence of model ids, for models initialised without an explicit one
+    uint64_t next_model_id();
+
+    double uniform(const uint64_t seed, const uint64_t stream, const uint64_t index); //[0, 1)
+    double normal(const uint64_t seed, const uint64_t stream, const uint64_t index);  //N(0, 1)
+
+    //Fill m (already sized) with N(mean, stdev^2), element (i, j) uses index i * cols + j. Large matrices are filled in parallel
+    void fillNormal(Matrix& m, const uint64_t seed, const uint64_t stream, const double mean = 0.0, const double stdev = 1.0);
+
+    //Uniformly random permutation of 0..n-1 (Fisher-Yates driven by the counter stream)
+    std::vector<int> permutation(const int n, const uint64_t seed, const uint64_t stream = 0);
+}
+
+#endif //RNG_H
@@ -17,20 +17,21 @@ int main() {
     const std::vector<int> layer_dims = {static_cast<int>(X_train[0][0].size()), 64, 64, 32, 1};
 
     //Init data and parameters for HybridModel
-    HybridModel::init_data(X_train, Y_train, batch_size);
-    HybridModel::init_hidden_units(numUnits);
+    HybridModel model;
+    model.init_data(X_train, Y_train, batch_size);
+    model.init_hidden_units(numUnits);
 
     // Initialize the layers
-    HybridModel::init_layers(layer_types, layer_dims);
+    model.init_layers(layer_types, layer_dims);
 
     // Initialize the network parameters
-    HybridModel::initialize_network();
+    model.initialize_network();
 
     // Initialize the learning rate
-    HybridModel::init_learning_rate(3e-4);
+    model.init_learning_rate(3e-4);
 
     // Initialize Adam optimizer
-    HybridModel::init_Adam();
+    model.init_Adam();
 
     // Initialize training values
     const int epochs = 1000;
@@ -47,23 +48,23 @@ int main() {
             auto& Y_batch = std::get<1>(batch); 
 
             // Forward prop
-            HybridModel::forward_prop(X_batch);
+            model.forward_prop(X_batch);
             std::cout << "Forward prop done" << std::endl;
 
             // Compute loss
-            HybridModel::loss(Y_batch);
+            model.loss(Y_batch);
             std::cout << "Loss computed" << std::endl;
 
             // Backward prop
-            HybridModel::back_prop();
+            model.back_prop();
             std::cout << "Backprop done" << std::endl;
 
             // Optimize (i.e. Adam optimizer to get better gradients)
-            HybridModel::optimize();
+            model.optimize();
             std::cout << "Optimizing done" << std::endl;
         }
 
-        std::cout << "Average training loss: " << HybridModel::return_avg_loss() << std::endl;
+        std::cout << "Average training loss: " << model.return_avg_loss() << std::endl;
     }
 
     return 0;
@@ -0,0 +1,57 @@
+#include "check.h"
+#include "framework/AsyncLoader.h"
+#include "framework/DataFramework.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Both read backends give parseData's rows for every file, in path order, and a missing file fails on its own
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+}
+
+int main() {
+    std::vector<std::string> paths;
+    for (int f = 0; f < 6; f++) {
+        const std::string path = "async_loader_test_" + std::to_string(f) + ".csv";
+        std::ofstream file(path, std::ios::trunc);
+        file << "Date,Open,High,Low,Close,Volume\n";
+        for (int k = 0; k < 200 * (f + 1); k++) {
+            char date[16];
+            std::snprintf(date, sizeof(date), "%04d-%02d-%02d", 2000 + k / 336, (k / 28) % 12 + 1, k % 28 + 1);
+            file << date << ',' << f + 0.5 * k << ',' << f + 0.5 * k + 1 << ',' << f + 0.5 * k - 1 << ','
+                 << f + 0.25 * k << ',' << 100 * k << '\n';
+        }
+        paths.push_back(path);
+    }
+    paths.insert(paths.begin() + 2, "async_loader_test_missing.csv");
+
+    for (const AsyncLoader::Backend backend : {AsyncLoader::Backend::Threads, AsyncLoader::Backend::Auto}) {
+        AsyncLoader::Config config;
+        config.backend = backend;
+        config.max_in_flight = 3; //Fewer lanes than files, so lanes take several files each
+        const AsyncLoader::Result result = AsyncLoader::parseFiles(paths, config);
+
+        CHECK(result.files.size() == paths.size());
+        CHECK(result.stats.files == paths.size());
+        for (size_t i = 0; i < paths.size(); i++) {
+            const AsyncLoader::File& file = result.files[i];
+            CHECK(file.path == paths[i]);
+            if (i == 2) {
+                CHECK(!file.error.empty());
+                CHECK(file.data.empty());
+            } else {
+                CHECK(file.error.empty());
+                CHECK(!file.data.empty());
+                CHECK(file.data == DataFramework::parseData(paths[i]));
+            }
+        }
+    }
+
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+    return check::result();
+}
@@ -0,0 +1,77 @@
+#include "check.h"
+#include "model/Backtest.h"
+#include "model/HybridModel.h"
+#include "framework/DataFramework.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//With reset_every = timesteps, the streamed prediction at the end of each reset period equals predict on the
+//window ending there, for a single LSTM layer, stacked LSTM layers and an LSTM feeding the Linear output directly
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    constexpr int TIMESTEPS = 6;
+
+    HybridModel make_model(const std::vector<std::string>& types, const std::vector<int>& dims, const Tensor3D& X, const Matrix& Y) {
+        HybridModel model;
+        model.init_data(X, Y, 16);
+        model.init_hidden_units(8);
+        model.init_layers(types, dims);
+        model.initialize_network(11);
+        return model;
+    }
+
+    //Largest |stream - predict| over the rows that end a reset period
+    double period_end_drift(const HybridModel& model, const Matrix& rows) {
+        Backtest::Config config;
+        config.reset_every = TIMESTEPS;
+        const Matrix streamed = Backtest::stream(model, rows, config);
+        const Matrix windowed = model.predict(DataFramework::generate_tensor(rows, TIMESTEPS));
+
+        double drift = 0.0;
+        for (size_t r = TIMESTEPS - 1; r < rows.size(); r += TIMESTEPS) {
+            drift = std::max(drift, std::abs(streamed[0][r] - windowed[0][r - (TIMESTEPS - 1)]));
+        }
+        CHECK(streamed.size() == 1 && streamed[0].size() == rows.size());
+        return drift;
+    }
+}
+
+int main() {
+    Matrix rows;
+    for (int k = 0; k < 60; k++) {
+        rows.push_back({std::sin(0.3 * k), std::cos(0.5 * k)});
+    }
+    const Tensor3D X = DataFramework::generate_tensor(rows, TIMESTEPS);
+    const Matrix Y(X.size(), std::vector<double>(1, 0.0));
+
+    const HybridModel single = make_model({"LSTM", "Relu", "Linear"}, {8, 8, 1}, X, Y);
+    const HybridModel stacked = make_model({"LSTM", "LSTM", "Relu", "Relu", "Linear"}, {2, 8, 8, 8, 1}, X, Y);
+    const HybridModel linear_head = make_model({"LSTM", "Linear"}, {8, 1}, X, Y);
+    CHECK(period_end_drift(single, rows) < 1e-12);
+    CHECK(period_end_drift(stacked, rows) < 1e-12);
+    CHECK(period_end_drift(linear_head, rows) < 1e-12);
+
+    //compare() reports the same at the period ends
+    Backtest::Config config;
+    config.reset_every = TIMESTEPS;
+    const Backtest::Comparison comparison = Backtest::compare(stacked, rows, TIMESTEPS, config);
+    CHECK(comparison.windows == X.size());
+    CHECK(comparison.max_period_end_drift < 1e-12);
+
+    //A single layer streams the whole history without resets, stacked layers need them
+    CHECK(Backtest::stream(single, rows)[0].size() == rows.size());
+    bool threw = false;
+    try {
+        Backtest::stream(stacked, rows);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    return check::result();
+}
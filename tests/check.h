@@ -0,0 +1,32 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+/*
+ * Minimal assertions for the test executables: CHECK records a failure with its location and keeps going, and
+ * main returns check::result() so ctest sees every failed condition of a run, not just the first.
+ */
+namespace check {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result() {
+        if (failures() != 0) {
+            std::cerr << failures() << " check(s) failed" << std::endl;
+        }
+        return failures() == 0 ? 0 : 1;
+    }
+}
+
+#define CHECK(condition)                                                                             \
+    do {                                                                                             \
+        if (!(condition)) {                                                                          \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            check::failures()++;                                                                     \
+        }                                                                                            \
+    } while (0)
+
+#endif //CHECK_H
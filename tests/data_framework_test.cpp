@@ -0,0 +1,137 @@
+#include "check.h"
+#include "framework/DataFramework.h"
+#include "framework/FeatureGraph.h"
+#include "model/parallel.h"
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Date parsing and timestamps: days_from_civil across leap years and before 1970, parseDateTime's accepted forms,
+//and intraday times carried from the CSV through to the Timestamp feature. Files larger than a parse chunk are split
+//across threads and must still give the rows in file order, the same for every thread count and for parseData
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    bool leap(const int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    int days_in_month(const int year, const int month) {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return (month == 2 && leap(year)) ? 29 : days[month - 1];
+    }
+
+    //parseDateTime on s, the cursor's advance is returned through consumed
+    bool parse(const char* s, DataFramework::DateTime& date, long& consumed) {
+        const char* cursor = s;
+        const bool ok = DataFramework::parseDateTime(cursor, s + std::strlen(s), date);
+        consumed = cursor - s;
+        return ok;
+    }
+}
+
+int main() {
+    //Fixed points, including the leap days of 2000 (divisible by 400) and dates before the epoch
+    CHECK(DataFramework::days_from_civil(1970, 1, 1) == 0);
+    CHECK(DataFramework::days_from_civil(1969, 12, 31) == -1);
+    CHECK(DataFramework::days_from_civil(1960, 1, 1) == -3653);
+    CHECK(DataFramework::days_from_civil(1900, 3, 1) == -25508);
+    CHECK(DataFramework::days_from_civil(1600, 3, 1) == -135080);
+    CHECK(DataFramework::days_from_civil(2000, 2, 29) == 11016);
+    CHECK(DataFramework::days_from_civil(2000, 3, 1) == 11017);
+
+    //Every day from 1600 to 2400 is one more than the day before, so 1700, 1800, 1900, 2100, ... have no Feb 29
+    int64_t expected = DataFramework::days_from_civil(1600, 1, 1);
+    bool consecutive = true;
+    for (int year = 1600; year <= 2400; year++) {
+        for (int month = 1; month <= 12; month++) {
+            for (int day = 1; day <= days_in_month(year, month); day++) {
+                consecutive = consecutive && DataFramework::days_from_civil(year, month, day) == expected;
+                expected++;
+            }
+        }
+    }
+    CHECK(consecutive);
+
+    //Date only, with a space or 'T' before the time, and rejected fields that leave the cursor alone
+    DataFramework::DateTime date;
+    long consumed = 0;
+    CHECK(parse("2024-02-29,1.5", date, consumed) && consumed == 10);
+    CHECK(date.year == 2024 && date.month == 2 && date.day == 29 && date.hour == 0 && date.minute == 0 && date.second == 0);
+    CHECK(parse("2024-02-29 13:45:30,1.5", date, consumed) && consumed == 19);
+    CHECK(date.hour == 13 && date.minute == 45 && date.second == 30);
+    CHECK(parse("1965-07-04T01:02:03", date, consumed) && consumed == 19);
+    CHECK(date.year == 1965 && date.month == 7 && date.day == 4 && date.hour == 1 && date.minute == 2 && date.second == 3);
+    CHECK(!parse("2024-13-01", date, consumed) && consumed == 0);
+    CHECK(!parse("2024-02-29 24:00:00", date, consumed) && consumed == 0);
+    CHECK(!parse("2024/02/29", date, consumed) && consumed == 0);
+    CHECK(!parse("2024-02-2", date, consumed) && consumed == 0);
+
+    //Plain UTC, also before 1970. The time of day is either given apart or as parseData's Day fraction
+    CHECK(DataFramework::UnixTimestamp(2024, 2, 29, 13, 45, 30) == 1709214330);
+    CHECK(DataFramework::UnixTimestamp(2024, 2, 29 + (13 * 3600 + 45 * 60 + 30) / 86400.0) == 1709214330);
+    CHECK(DataFramework::UnixTimestamp(1960, 1, 1) == -3653LL * 86400);
+
+    //Intraday bars keep their time of day in the Day column and the Timestamp feature
+    const std::string text =
+        "Date,Open,High,Low,Close,Volume\n"
+        "2024-02-29 09:30:00,10,11,9,10.5,100\n"
+        "2024-02-29 09:31:00,10.5,11,10,10.25,200\n"
+        "2024-02-29T16:00:00,10.25,10.5,10,10.5,300\n";
+    const Matrix data = DataFramework::parseCSV(text);
+    CHECK(data.size() == 3);
+    CHECK(data[0][2] == 29 + (9 * 3600 + 30 * 60) / 86400.0);
+    CHECK(data[0][2] < data[1][2] && data[1][2] < data[2][2]);
+    CHECK(data[2][3] == 10.25 && data[2][7] == 300);
+
+    const Matrix features = DataFramework::engineerData(data);
+    const Matrix timestamps = FeatureGraph::engineer(data, {"Timestamp"});
+    const double open = DataFramework::UnixTimestamp(2024, 2, 29, 9, 30, 0);
+    CHECK(features[0][3] == open);
+    CHECK(features[1][3] == open + 60);
+    CHECK(features[2][3] == DataFramework::UnixTimestamp(2024, 2, 29, 16, 0, 0));
+    for (size_t row = 0; row < data.size(); row++) {
+        CHECK(timestamps[row][0] == features[row][3]);
+    }
+
+    //About 3 MB of daily bars, several 1 MB chunks. Values are exact in binary, so they compare with ==
+    std::string big = "Date,Open,High,Low,Close,Volume\n";
+    Matrix expected_rows;
+    int year = 1950, month = 1, day = 1;
+    for (int k = 0; k < 60000; k++) {
+        const double open = 100 + (k % 997) * 0.25, volume = 1000 + k;
+        char line[96];
+        std::snprintf(line, sizeof(line), "%04d-%02d-%02d,%.2f,%.2f,%.2f,%.2f,%.0f\n", year, month, day, open, open + 1, open - 1, open + 0.5, volume);
+        big += line;
+        expected_rows.push_back({static_cast<double>(year), static_cast<double>(month), static_cast<double>(day), open, open + 1, open - 1, open + 0.5, volume});
+        if (++day > days_in_month(year, month)) {
+            day = 1;
+            if (++month > 12) {
+                month = 1;
+                year++;
+            }
+        }
+    }
+    big.pop_back(); //The last line has no newline
+
+    const size_t threads = parallel::num_threads();
+    for (const size_t n : {size_t(1), size_t(4)}) {
+        parallel::set_num_threads(n);
+        CHECK(DataFramework::parseCSV(big) == expected_rows);
+    }
+    parallel::set_num_threads(threads);
+
+    const std::string path = "data_framework_test.csv";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << big;
+    }
+    CHECK(DataFramework::parseData(path) == expected_rows);
+    std::remove(path.c_str());
+
+    return check::result();
+}
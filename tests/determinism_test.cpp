@@ -0,0 +1,120 @@
+#include "check.h"
+#include "model/HybridModel.h"
+#include "model/parallel.h"
+#include "model/reductions.h"
+#include "model/linalg.h"
+#include "model/rng.h"
+#include "model/Sweep.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <string>
+
+//With parallel::set_deterministic(true), reductions, training and sweeps give bitwise identical results at any thread
+//count
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    //Everything computed at one thread count, flattened for a bitwise comparison
+    std::vector<double> run(const size_t threads) {
+        parallel::set_num_threads(threads);
+        std::vector<double> out;
+        auto append = [&](const Matrix& m) {
+            for (const auto& row : m) {
+                out.insert(out.end(), row.begin(), row.end());
+            }
+        };
+
+        //Reductions: per-chunk partial sums of parallel_for combined in chunk order, and the library reductions
+        Matrix data(512, std::vector<double>(300));
+        rng::fillNormal(data, 42, rng::tensor_id("determinism"), 0.0, 1.0);
+        std::vector<double> flat = linalg::reshape(data);
+        const size_t grain = 1000;
+        std::vector<double> partials((flat.size() + grain - 1) / grain);
+        parallel::parallel_for(0, flat.size(), grain, [&](const size_t begin, const size_t end) {
+            partials[begin / grain] = reductions::kahanSum(std::vector<double>(flat.begin() + begin, flat.begin() + end));
+        });
+        out.push_back(reductions::sum(partials));
+        out.push_back(reductions::sum(flat));
+        out.push_back(reductions::sumAll(data));
+        out.push_back(reductions::norm(data));
+        append(reductions::sum(data, 0));
+        append(reductions::sum(data, 1));
+        append(linalg::matmul(linalg::T(data), data));
+
+        //Trained models' parameters and outputs: 96 windows fill six batches of 16, 135 leave a short last batch of 7
+        for (const int windows : {96, 135}) {
+            Tensor3D X;
+            Matrix Y;
+            for (int k = 0; k < windows; k++) {
+                Matrix window;
+                for (int t = 0; t < 5; t++) {
+                    window.push_back({std::sin(0.3 * (k + t)), std::cos(0.3 * (k + t))});
+                }
+                X.push_back(window);
+                Y.push_back({std::sin(0.3 * (k + 5))});
+            }
+            HybridModel model;
+            model.init_data(X, Y, 16);
+            model.init_hidden_units(8);
+            model.init_layers({"LSTM", "LSTM", "Relu", "Relu", "Linear"}, {2, 8, 8, 8, 1});
+            model.init_learning_rate(1e-2);
+            model.initialize_network(3);
+            model.init_Adam();
+            for (int epoch = 0; epoch < 2; epoch++) {
+                model.train_epoch(X, Y, epoch);
+            }
+            out.push_back(model.return_avg_loss());
+            append(model.predict(X));
+            for (const auto& layer : model.parameters()) {
+                for (const auto& [name, weights] : layer) {
+                    append(weights);
+                }
+            }
+        }
+
+        //A sweep trains its trials in parallel, each trial's losses and early-stopping decisions must not depend on it
+        Matrix features, targets;
+        for (int k = 0; k < 120; k++) {
+            features.push_back({std::sin(0.3 * k), std::cos(0.3 * k)});
+            targets.push_back({std::sin(0.3 * (k + 5))});
+        }
+        Sweep::SearchSpace space;
+        space.hidden_units = {8};
+        space.layer_dims = {{8, 8, 4, 1}};
+        space.learning_rate = {1e-2, 3e-3};
+        space.batch_size = {16, 32};
+        space.timesteps = {5};
+        Sweep::Config config;
+        config.num_trials = 4;
+        config.max_epochs = 3;
+        config.min_epochs = 1;
+        config.eta = 3;
+        config.seed = 5;
+        for (const Sweep::TrialResult& trial : Sweep::run(features, targets, space, config)) {
+            out.push_back(static_cast<double>(trial.status));
+            out.push_back(trial.epochs);
+            out.push_back(trial.train_loss);
+            out.push_back(trial.validation_loss);
+        }
+        return out;
+    }
+
+    bool bitwise_equal(const std::vector<double>& a, const std::vector<double>& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+    }
+}
+
+int main() {
+    parallel::set_deterministic(true);
+
+    const std::vector<double> reference = run(1);
+    CHECK(!reference.empty());
+    for (const size_t threads : {4, 16}) {
+        CHECK(bitwise_equal(run(threads), reference));
+    }
+
+    return check::result();
+}
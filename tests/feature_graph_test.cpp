@@ -0,0 +1,78 @@
+#include "check.h"
+#include "framework/FeatureGraph.h"
+#include "framework/DataFramework.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//The graph gives engineerData's columns for any subset of features, evaluating only what the subset needs
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    bool planned(const std::vector<std::string>& plan, const std::string& name) {
+        return std::find(plan.begin(), plan.end(), name) != plan.end();
+    }
+
+    //Equal values, or NaN in both: engineerData averages zero rows on the first row, and its MACD carries that NaN on
+    bool same(const double a, const double b) {
+        return a == b || (std::isnan(a) && std::isnan(b));
+    }
+}
+
+int main() {
+    //Daily bars in the parseData layout: Year, Month, Day, Open, High, Low, Close, Volume
+    Matrix data;
+    for (int k = 0; k < 90; k++) {
+        const double close = 100 + 10 * std::sin(0.2 * k) + 0.1 * k;
+        const double open = close - std::cos(0.7 * k);
+        data.push_back({2024, 1.0 + k / 28, 1.0 + k % 28, open, std::max(open, close) + 1, std::min(open, close) - 1, close, 1000.0 + k});
+    }
+    const Matrix whole = DataFramework::engineerData(data);
+    const std::vector<std::string>& names = FeatureGraph::features();
+    CHECK(names.size() == whole[0].size());
+
+    //Every feature at once matches engineerData column for column
+    const Matrix all = FeatureGraph::engineer(data, names);
+    CHECK(all.size() == data.size());
+    for (size_t row = 0; row < data.size(); row++) {
+        for (size_t j = 0; j < names.size(); j++) {
+            CHECK(same(all[row][j], whole[row][j]));
+        }
+    }
+
+    //A subset comes back in the requested order
+    const std::vector<std::string> subset = {"ADX", "Year", "7-Day STD"};
+    const Matrix picked = FeatureGraph::engineer(data, subset);
+    for (size_t row = 0; row < data.size(); row++) {
+        CHECK(picked[row].size() == 3);
+        CHECK(same(picked[row][0], whole[row][14]));
+        CHECK(same(picked[row][1], whole[row][0]));
+        CHECK(same(picked[row][2], whole[row][5]));
+    }
+
+    //Only the dependencies of the request are planned, each once
+    const std::vector<std::string> plan = FeatureGraph::plan({"7-Day STD", "7-Day SMA"});
+    CHECK(planned(plan, "7-Day SMA") && planned(plan, "Close"));
+    CHECK(!planned(plan, "ATR") && !planned(plan, "Timestamp"));
+    CHECK(std::count(plan.begin(), plan.end(), "7-Day SMA") == 1);
+
+    //No features gives (rows, 0), no rows gives nothing
+    const Matrix none = FeatureGraph::engineer(data, {});
+    CHECK(none.size() == data.size());
+    CHECK(std::all_of(none.begin(), none.end(), [](const std::vector<double>& row) { return row.empty(); }));
+    CHECK(FeatureGraph::plan({}).empty());
+    CHECK(FeatureGraph::engineer(Matrix(), {"ATR"}).empty());
+
+    bool threw = false;
+    try {
+        FeatureGraph::engineer(data, {"RSI"});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    return check::result();
+}
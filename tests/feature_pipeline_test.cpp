@@ -0,0 +1,109 @@
+#include "check.h"
+#include "framework/FeaturePipeline.h"
+#include "framework/FeatureCache.h"
+#include "framework/DataFramework.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+//Engineering a series in pieces from the saved IndicatorState gives the whole-series features bit for bit, and
+//merging batches into a Scaler gives the statistics and scaling of fitting every row at once
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    //Equal values, or NaN in both: engineerData averages zero rows on the first row, and its MACD carries that NaN on
+    bool same(const double a, const double b) {
+        return a == b || (std::isnan(a) && std::isnan(b));
+    }
+
+    bool close_to(const double a, const double b) {
+        return std::abs(a - b) <= 1e-12 * std::max(1.0, std::abs(b));
+    }
+
+    //Daily bars in the parseData layout: Year, Month, Day, Open, High, Low, Close, Volume
+    Matrix bars(const int count) {
+        Matrix data;
+        for (int k = 0; k < count; k++) {
+            const double close = 100 + 10 * std::sin(0.2 * k) + 0.1 * k;
+            const double open = close - std::cos(0.7 * k);
+            data.push_back({2024.0 + k / 336, 1.0 + (k / 28) % 12, 1.0 + k % 28, open, std::max(open, close) + 1, std::min(open, close) - 1, close, 1000.0 + k});
+        }
+        return data;
+    }
+}
+
+int main() {
+    const Matrix data = bars(120);
+    const Matrix whole = DataFramework::engineerData(data);
+
+    //Pieces shorter and longer than the indicators' history, including single rows
+    const std::vector<size_t> cuts = {0, 1, 2, 9, 40, 41, 100, 120};
+    DataFramework::IndicatorState state;
+    Matrix pieces;
+    for (size_t p = 0; p + 1 < cuts.size(); p++) {
+        const Matrix piece(data.begin() + cuts[p], data.begin() + cuts[p+1]);
+        for (std::vector<double>& row : DataFramework::engineerData(piece, state)) {
+            pieces.push_back(std::move(row));
+        }
+    }
+    CHECK(state.rows == data.size());
+    CHECK(pieces.size() == whole.size());
+    for (size_t row = 0; row < whole.size() && row < pieces.size(); row++) {
+        CHECK(pieces[row].size() == whole[row].size());
+        for (size_t j = 0; j < whole[row].size(); j++) {
+            CHECK(same(pieces[row][j], whole[row][j]));
+        }
+    }
+
+    //Batches merged one after another match one fit over all rows (columns without NaN: Daily Var, Timestamp,
+    //High-Close and Low-Open)
+    Matrix columns;
+    for (const std::vector<double>& row : whole) {
+        columns.push_back({row[2], row[3], row[6], row[7]});
+    }
+    FeaturePipeline::Scaler merged, fitted;
+    fitted.update(columns);
+    for (size_t p = 0; p + 1 < cuts.size(); p++) {
+        merged.update(Matrix(columns.begin() + cuts[p], columns.begin() + cuts[p+1]));
+    }
+    CHECK(merged.count == fitted.count && merged.count == columns.size());
+    for (size_t j = 0; j < fitted.mean.size(); j++) {
+        CHECK(close_to(merged.mean[j], fitted.mean[j]));
+        CHECK(close_to(merged.m2[j], fitted.m2[j]));
+        CHECK(merged.min[j] == fitted.min[j] && merged.max[j] == fitted.max[j]);
+    }
+
+    //Either scaler reproduces normalizeData(standardizeData(x))
+    const Matrix expected = DataFramework::normalizeData(DataFramework::standardizeData(columns));
+    const Matrix scaled = merged.transform(columns);
+    for (size_t row = 0; row < columns.size(); row++) {
+        for (size_t j = 0; j < columns[row].size(); j++) {
+            CHECK(close_to(scaled[row][j], expected[row][j]));
+        }
+    }
+
+    //A constant column scales to 0.5 like normalizeData's edge case
+    FeaturePipeline::Scaler constant;
+    constant.update({{3.0}, {3.0}});
+    constant.update({{3.0}});
+    CHECK(constant.transform({{3.0}})[0][0] == 0.5);
+
+    //build() then append() under Update leaves the pipeline where building the whole series would
+    const std::string cache = "feature_pipeline_test.qnfc";
+    const FeaturePipeline::State full = FeaturePipeline::build(data, cache, 10, FeaturePipeline::ScalerPolicy::Update);
+    FeaturePipeline::State split = FeaturePipeline::build(Matrix(data.begin(), data.begin() + 50), cache, 10, FeaturePipeline::ScalerPolicy::Update);
+    const FeaturePipeline::Appended appended = FeaturePipeline::append(split, Matrix(data.begin() + 50, data.end()), cache);
+    CHECK(appended.rows == 70);
+    CHECK(appended.first_window == 41 && appended.end_window == full.windows());
+    CHECK(split.indicators.rows == full.indicators.rows);
+    CHECK(split.target.count == full.target.count);
+    CHECK(close_to(split.target.mean[0], full.target.mean[0]) && close_to(split.target.m2[0], full.target.m2[0]));
+    CHECK(std::get<0>(FeatureCache::read(cache, 0)).size() == data.size());
+    std::remove(cache.c_str());
+
+    return check::result();
+}
@@ -0,0 +1,162 @@
+#include "check.h"
+#include "framework/FeatureStore.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//FeatureStore round-trips its rows and windows, and rejects files whose column tables point outside their blocks
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    //File layout: a 48-byte header, then the first block, which starts with one 16-byte
+    //{offset, bytes, codec, reserved} entry per column
+    constexpr size_t FIRST_BLOCK = 48;
+    constexpr size_t COLUMN_ENTRY = 16;
+
+    std::vector<char> read_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void write_file(const std::string& path, const std::vector<char>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    //Copy of the store with field `field` (0 offset, 1 bytes, 2 codec) of column `column` of the first block set to value
+    std::string corrupt_column(const std::string& path, const size_t column, const size_t field, const uint32_t value) {
+        std::vector<char> bytes = read_file(path);
+        std::memcpy(bytes.data() + FIRST_BLOCK + column * COLUMN_ENTRY + field * sizeof(uint32_t), &value, sizeof(value));
+        const std::string corrupt = path + ".corrupt";
+        write_file(corrupt, bytes);
+        return corrupt;
+    }
+
+    //Copy of the store with the bytes at `at` inside column `column`'s data of the first block overwritten
+    std::string corrupt_data(const std::string& path, const size_t column, const size_t at, const std::vector<unsigned char>& values) {
+        std::vector<char> bytes = read_file(path);
+        uint32_t offset;
+        std::memcpy(&offset, bytes.data() + FIRST_BLOCK + column * COLUMN_ENTRY, sizeof(offset));
+        std::memcpy(bytes.data() + FIRST_BLOCK + offset + at, values.data(), values.size());
+        const std::string corrupt = path + ".corrupt";
+        write_file(corrupt, bytes);
+        return corrupt;
+    }
+
+    template <typename F>
+    bool throws_runtime_error(const F& f) {
+        try {
+            f();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main() {
+    const std::string path = "feature_store_test.qnfs";
+    const size_t rows = 1000, n_features = 3;
+    std::vector<int64_t> timestamps(rows);
+    Matrix X(rows, std::vector<double>(n_features));
+    Matrix Y(rows, {0.0});
+    for (size_t i = 0; i < rows; i++) {
+        timestamps[i] = 1700000000 + 60 * static_cast<int64_t>(i);
+        for (size_t j = 0; j < n_features; j++) {
+            X[i][j] = 0.25 * ((i / 8 + j) % 5); //Repeating values, so the feature columns are Gorilla-compressed
+        }
+        Y[i][0] = static_cast<double>(i % 7);
+    }
+    FeatureStore::Options options;
+    options.block_rows = 128;
+    FeatureStore::write(path, timestamps, X, Y, options);
+
+    {
+        const FeatureStore store(path);
+        CHECK(store.rows() == rows);
+        CHECK(store.n_features() == n_features);
+        std::vector<double> features(rows * n_features), targets(rows);
+        std::vector<int64_t> decoded_timestamps(rows);
+        store.decode(0, rows, features.data(), targets.data(), decoded_timestamps.data());
+        bool equal = decoded_timestamps == timestamps;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < n_features; j++) {
+                equal = equal && features[i * n_features + j] == X[i][j];
+            }
+            equal = equal && targets[i] == Y[i][0];
+        }
+        CHECK(equal);
+
+        //Windows of a slice are views into one buffer, also those that span a block boundary (rows 128 and 256)
+        const size_t timesteps = 10;
+        const FeatureStore::Slice slice = store.slice(timestamps[120], timestamps[300], timesteps);
+        CHECK(slice.first_row == 120 - (timesteps - 1) && slice.history == timesteps - 1);
+        CHECK(slice.windows() == 180);
+        bool windows_equal = true;
+        for (size_t w = 0; w < slice.windows(); w++) {
+            const linalg::View window = slice.window(w);
+            windows_equal = windows_equal && window.rows() == timesteps && window.cols() == n_features;
+            for (size_t t = 0; t < timesteps && windows_equal; t++) {
+                for (size_t j = 0; j < n_features; j++) {
+                    windows_equal = windows_equal && window.at(t, j) == X[slice.first_row + w + t][j];
+                }
+            }
+            windows_equal = windows_equal && slice.target(w) == Y[slice.first_row + w + timesteps - 1][0];
+        }
+        CHECK(windows_equal);
+
+        //load clamps its range to the store like FeatureCache::load
+        CHECK(store.load(rows - 5).rows == 5);
+        CHECK(store.load(rows + 5).rows == 0);
+        CHECK(store.load(10, 5).rows == 0);
+    }
+
+    //block_rows must fit the format's 32-bit row counts
+    FeatureStore::Options oversized;
+    oversized.block_rows = size_t(1) << 33;
+    bool threw = false;
+    try {
+        FeatureStore::write(path + ".oversized", timestamps, X, Y, oversized);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    //Offsets or sizes outside the block, misaligned offsets and unknown codecs are rejected when the store is opened
+    const uint32_t huge = 0xfffffff0u;
+    CHECK(throws_runtime_error([&] { FeatureStore store(corrupt_column(path, 1, 0, huge)); }));
+    CHECK(throws_runtime_error([&] { FeatureStore store(corrupt_column(path, 1, 1, huge)); }));
+    CHECK(throws_runtime_error([&] { FeatureStore store(corrupt_column(path, 1, 0, 4)); }));
+    CHECK(throws_runtime_error([&] { FeatureStore store(corrupt_column(path, 1, 0, FIRST_BLOCK + 3)); }));
+    CHECK(throws_runtime_error([&] { FeatureStore store(corrupt_column(path, n_features + 1, 2, 7)); }));
+
+    //A compressed column cut short opens, but decoding it stops at its end instead of reading the next column
+    {
+        const FeatureStore store(corrupt_column(path, 0, 1, 1));
+        std::vector<int64_t> decoded_timestamps(rows);
+        CHECK(throws_runtime_error([&] { store.decode(0, 128, nullptr, nullptr, decoded_timestamps.data()); }));
+    }
+    {
+        const FeatureStore store(corrupt_column(path, 1, 1, 8));
+        std::vector<double> features(rows * n_features), targets(rows);
+        CHECK(throws_runtime_error([&] { store.decode(0, 128, features.data(), targets.data()); }));
+    }
+
+    //A Gorilla header whose leading zeros and length add up to more than 64 bits: control bits 11, leading 31, length 64
+    {
+        const FeatureStore store(corrupt_data(path, 1, sizeof(uint64_t), {0xff, 0xff}));
+        std::vector<double> features(rows * n_features), targets(rows);
+        CHECK(throws_runtime_error([&] { store.decode(0, 128, features.data(), targets.data()); }));
+    }
+
+    std::remove(path.c_str());
+    std::remove((path + ".corrupt").c_str());
+    std::remove((path + ".oversized").c_str());
+    return check::result();
+}
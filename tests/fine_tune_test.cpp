@@ -0,0 +1,99 @@
+#include "check.h"
+#include "model/FineTune.h"
+#include "model/HybridModel.h"
+#include "framework/FeatureCache.h"
+#include "framework/DataFramework.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//Fine-tuning resumes a checkpoint on the rows appended since it was saved and lowers the loss on their windows,
+//also when the new windows do not divide into whole minibatches
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    constexpr int TIMESTEPS = 5;
+
+    //Row r of the series, whose target is the first feature TIMESTEPS rows later (the value after the window at r)
+    void rows(const int from, const int to, Matrix& X, Matrix& Y) {
+        X.clear();
+        Y.clear();
+        for (int r = from; r < to; r++) {
+            X.push_back({std::sin(0.3 * r), std::cos(0.3 * r)});
+            Y.push_back({std::sin(0.3 * (r + TIMESTEPS))});
+        }
+    }
+
+    double window_mse(const HybridModel& model, const Tensor3D& windows, const Matrix& Y) {
+        std::vector<double> targets;
+        for (size_t i = 0; i < windows.size(); i++) {
+            targets.push_back(Y[i][0]);
+        }
+        return HybridModel::MSE(model.predict(windows)[0], targets);
+    }
+}
+
+int main() {
+    const std::string cache = "fine_tune_test.qnfc";
+    const std::string checkpoint = "fine_tune_test.qntune";
+    const std::string output = "fine_tune_test_out.qntune";
+    std::remove(cache.c_str());
+
+    //A model trained on the first 100 rows
+    Matrix X, Y;
+    rows(0, 100, X, Y);
+    FeatureCache::append(cache, X, Y);
+    const Tensor3D initial = DataFramework::generate_tensor(X, TIMESTEPS);
+    const Matrix initial_Y(Y.begin(), Y.begin() + initial.size());
+
+    HybridModel model;
+    model.init_data(initial, initial_Y, 16);
+    model.init_hidden_units(8);
+    model.init_layers({"LSTM", "Relu", "Linear"}, {8, 8, 1});
+    model.init_learning_rate(1e-2);
+    model.initialize_network(3);
+    model.init_Adam();
+    model.train_epoch(initial, initial_Y, 1);
+    FineTune::save(checkpoint, model, 100);
+
+    //140 new rows: the windows ending on them start at row 96, 140 windows that leave a short last batch of 12
+    rows(100, 240, X, Y);
+    FeatureCache::append(cache, X, Y);
+    const auto [new_X, new_Y] = FeatureCache::read(cache, 100 - (TIMESTEPS - 1));
+    const Tensor3D windows = DataFramework::generate_tensor(new_X, TIMESTEPS);
+    CHECK(windows.size() == 140);
+
+    HybridModel before;
+    CHECK(FineTune::load(checkpoint, before) == 100);
+    const double loss_before = window_mse(before, windows, new_Y);
+
+    FineTune::Config config;
+    config.timesteps = TIMESTEPS;
+    config.epochs = 3;
+    config.batch_size = 16;
+    config.learning_rate = 1e-2;
+    const FineTune::Result result = FineTune::run({checkpoint, cache, output}, config);
+    CHECK(result.completed);
+    CHECK(result.error.empty());
+    CHECK(result.new_rows == 140);
+    CHECK(result.windows == 140);
+    CHECK(std::isfinite(result.loss));
+
+    HybridModel after;
+    CHECK(FineTune::load(output, after) == 240);
+    const double loss_after = window_mse(after, windows, new_Y);
+    CHECK(std::isfinite(loss_after));
+    CHECK(loss_after < loss_before);
+
+    //Nothing new since the fine-tuned checkpoint
+    const FineTune::Result again = FineTune::run({output, cache, output}, config);
+    CHECK(again.completed && again.new_rows == 0 && again.windows == 0);
+
+    std::remove(cache.c_str());
+    std::remove(checkpoint.c_str());
+    std::remove(output.c_str());
+    return check::result();
+}
@@ -0,0 +1,69 @@
+#include "check.h"
+#include "model/ModelStore.h"
+#include "model/HybridModel.h"
+#include "framework/DataFramework.h"
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//A stored model predicts the same as the HybridModel it was written from, for every layer layout forward accepts
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    HybridModel make_model(const std::vector<std::string>& types, const std::vector<int>& dims, const Tensor3D& X, const Matrix& Y, const int seed) {
+        HybridModel model;
+        model.init_data(X, Y, 16);
+        model.init_hidden_units(8);
+        model.init_layers(types, dims);
+        model.initialize_network(seed);
+        return model;
+    }
+
+    double max_difference(const Matrix& a, const Matrix& b) {
+        double difference = (a.size() == b.size() && a[0].size() == b[0].size()) ? 0.0 : INFINITY;
+        for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+            for (size_t j = 0; j < a[i].size() && j < b[i].size(); j++) {
+                difference = std::max(difference, std::abs(a[i][j] - b[i][j]));
+            }
+        }
+        return difference;
+    }
+}
+
+int main() {
+    Matrix rows;
+    for (int k = 0; k < 40; k++) {
+        rows.push_back({std::sin(0.3 * k), std::cos(0.5 * k)});
+    }
+    const Tensor3D X = DataFramework::generate_tensor(rows, 5);
+    const Matrix Y(X.size(), std::vector<double>(1, 0.0));
+
+    const HybridModel relu_head = make_model({"LSTM", "Relu", "Linear"}, {8, 8, 1}, X, Y, 1);
+    const HybridModel stacked = make_model({"LSTM", "LSTM", "Relu", "Relu", "Linear"}, {2, 8, 8, 8, 1}, X, Y, 2);
+    const HybridModel linear_head = make_model({"LSTM", "Linear"}, {8, 1}, X, Y, 3);
+
+    const std::string path = "model_store_test.qnms";
+    ModelStore::write(path, {{"relu", &relu_head}, {"stacked", &stacked}, {"linear", &linear_head}});
+    {
+        ModelStore store(path, 2);
+        CHECK(store.size() == 3);
+        CHECK(max_difference(store.get("relu")->predict(X), relu_head.predict(X)) < 1e-12);
+        CHECK(max_difference(store.get("stacked")->predict(X), stacked.predict(X)) < 1e-12);
+        CHECK(max_difference(store.get("linear")->predict(X), linear_head.predict(X)) < 1e-12);
+
+        bool threw = false;
+        try {
+            store.get("missing");
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+    std::remove(path.c_str());
+
+    return check::result();
+}
@@ -0,0 +1,50 @@
+#include "check.h"
+#include "model/HybridModel.h"
+
+#include <vector>
+#include <string>
+
+//Parameter initialisation: models are independent unless they are given the same init seed
+namespace {
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    HybridModel make_model() {
+        HybridModel model;
+        model.init_data(Tensor3D(4, HybridModel::Matrix(5, std::vector<double>(3, 0.5))), HybridModel::Matrix(4, {0.0}), 2);
+        model.init_hidden_units(8);
+        model.init_layers({"LSTM", "LSTM", "Relu", "Linear"}, {3, 8, 8, 1});
+        return model;
+    }
+
+    HybridModel initialised(const uint64_t init_seed) {
+        HybridModel model = make_model();
+        model.initialize_network(init_seed);
+        return model;
+    }
+}
+
+int main() {
+    const HybridModel a = initialised(1);
+    const HybridModel b = initialised(1);
+    const HybridModel c = initialised(2);
+    CHECK(a.parameters() == b.parameters());
+    CHECK(a.parameters() != c.parameters());
+
+    //Every weight tensor differs, not just one of them
+    for (size_t layer = 0; layer < a.parameters().size(); layer++) {
+        for (const auto& [name, weights] : a.parameters()[layer]) {
+            if (name[0] == 'W') {
+                CHECK(weights != c.parameters()[layer].at(name));
+            }
+        }
+    }
+
+    //Without an explicit seed, models initialised one after another are independent too
+    HybridModel d = make_model();
+    HybridModel e = make_model();
+    d.initialize_network();
+    e.initialize_network();
+    CHECK(d.parameters() != e.parameters());
+
+    return check::result();
+}
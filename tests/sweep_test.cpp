@@ -0,0 +1,79 @@
+#include "check.h"
+#include "model/Sweep.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+//A small sweep trains its trials to completion with finite losses, and rejects layer sizes that cannot run
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+
+    Sweep::Config small_config() {
+        Sweep::Config config;
+        config.num_trials = 3;
+        config.max_epochs = 3;
+        config.min_epochs = 1;
+        config.eta = 3;
+        config.seed = 5;
+        return config;
+    }
+}
+
+int main() {
+    //Two features, the target of row k is the first feature of the row after its window
+    Matrix x_features;
+    Matrix Y;
+    for (int k = 0; k < 120; k++) {
+        x_features.push_back({std::sin(0.3 * k), std::cos(0.3 * k)});
+        Y.push_back({std::sin(0.3 * (k + 5))});
+    }
+
+    Sweep::SearchSpace space;
+    space.hidden_units = {8};
+    space.layer_dims = {{8, 8, 4, 1}};
+    space.learning_rate = {1e-2, 3e-3};
+    space.batch_size = {16, 32};
+    space.timesteps = {5};
+
+    const std::vector<Sweep::TrialResult> results = Sweep::run(x_features, Y, space, small_config());
+    CHECK(results.size() == 3);
+    int completed = 0;
+    for (const Sweep::TrialResult& result : results) {
+        CHECK(result.error.empty());
+        CHECK(result.status != Sweep::Status::Failed);
+        CHECK(std::isfinite(result.validation_loss));
+        CHECK(std::isfinite(result.train_loss));
+        //Per epoch, not summed over the epochs trained: the targets are in [-1, 1], so an epoch's MSE / 2 stays small
+        CHECK(result.train_loss < 1.0);
+        if (result.status == Sweep::Status::Completed) {
+            CHECK(result.epochs == 3);
+            completed++;
+        }
+    }
+    CHECK(completed >= 1);
+
+    //The Dense layer after the second LSTM reads its hidden state, so that LSTM's size must equal hidden_units
+    Sweep::SearchSpace mismatched = space;
+    mismatched.layer_dims = {{6, 8, 4, 1}};
+    bool threw = false;
+    try {
+        Sweep::run(x_features, Y, mismatched, small_config());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    //One size per layer type after the first
+    Sweep::SearchSpace short_dims = space;
+    short_dims.layer_dims = {{8, 1}};
+    threw = false;
+    try {
+        Sweep::run(x_features, Y, short_dims, small_config());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    return check::result();
+}
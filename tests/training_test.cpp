@@ -0,0 +1,101 @@
+#include "check.h"
+#include "model/HybridModel.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+//One training epoch on a toy series lowers the loss, for both the windowed and the minibatch train_epoch,
+//including a sample count that leaves a short last minibatch
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    constexpr int TIMESTEPS = 5;
+
+    double mse(const Matrix& prediction, const Matrix& Y) {
+        std::vector<double> predictions(prediction[0].begin(), prediction[0].end());
+        std::vector<double> targets;
+        for (const auto& row : Y) {
+            targets.push_back(row[0]);
+        }
+        return HybridModel::MSE(predictions, targets);
+    }
+
+    HybridModel make_model(const Tensor3D& X, const Matrix& Y) {
+        HybridModel model;
+        model.init_data(X, Y, 16);
+        model.init_hidden_units(8);
+        model.init_layers({"LSTM", "Relu", "Linear"}, {8, 8, 1});
+        model.init_learning_rate(1e-2);
+        model.initialize_network(7);
+        model.init_Adam();
+        return model;
+    }
+
+    //Rows of a two-feature series, the target of each window is the next value of the first feature
+    void make_series(const size_t windows, Matrix& rows, Tensor3D& X, Matrix& Y) {
+        for (size_t k = 0; k < windows + TIMESTEPS; k++) {
+            rows.push_back({std::sin(0.3 * k), std::cos(0.3 * k)});
+        }
+        for (size_t k = 0; k + TIMESTEPS < rows.size(); k++) {
+            X.emplace_back(rows.begin() + k, rows.begin() + k + TIMESTEPS);
+            Y.push_back({rows[k + TIMESTEPS][0]});
+        }
+    }
+}
+
+int main() {
+    Matrix rows;
+    Tensor3D X;
+    Matrix Y;
+    make_series(128, rows, X, Y);
+
+    HybridModel minibatch = make_model(X, Y);
+    const double before = mse(minibatch.predict(X), Y);
+    minibatch.train_epoch(X, Y, 1);
+    const double after = mse(minibatch.predict(X), Y);
+    CHECK(std::isfinite(after));
+    CHECK(after < before);
+
+    HybridModel windowed = make_model(X, Y);
+    windowed.train_epoch(Matrix(rows.begin(), rows.end() - 1), Y, TIMESTEPS, 1);
+    const double windowed_after = mse(windowed.predict(X), Y);
+    CHECK(std::isfinite(windowed_after));
+    CHECK(windowed_after < before);
+
+    //Every window needs a target
+    bool threw = false;
+    try {
+        windowed.train_epoch(rows, Y, TIMESTEPS, 2); //One window more than Y has targets
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    //Further epochs keep improving
+    for (int epoch = 2; epoch <= 5; epoch++) {
+        minibatch.train_epoch(X, Y, epoch);
+    }
+    CHECK(mse(minibatch.predict(X), Y) < after);
+
+    //135 windows do not divide into batches of 16, the last minibatch holds the 7 left over
+    Matrix short_rows;
+    Tensor3D short_X;
+    Matrix short_Y;
+    make_series(135, short_rows, short_X, short_Y);
+
+    HybridModel short_minibatch = make_model(short_X, short_Y);
+    const double short_before = mse(short_minibatch.predict(short_X), short_Y);
+    short_minibatch.train_epoch(short_X, short_Y, 1);
+    const double short_after = mse(short_minibatch.predict(short_X), short_Y);
+    CHECK(std::isfinite(short_after));
+    CHECK(short_after < short_before);
+
+    HybridModel short_windowed = make_model(short_X, short_Y);
+    short_windowed.train_epoch(Matrix(short_rows.begin(), short_rows.end() - 1), short_Y, TIMESTEPS, 1);
+    CHECK(mse(short_windowed.predict(short_X), short_Y) < short_before);
+
+    return check::result();
+}
@@ -0,0 +1,67 @@
+#include "check.h"
+#include "model/WalkForward.h"
+
+#include <cmath>
+#include <vector>
+
+//Walk-forward folds train and score every out-of-sample window, and the summary agrees with the fold results
+namespace {
+    typedef std::vector<std::vector<double>> Matrix;
+    typedef std::vector<std::vector<std::vector<double>>> Tensor3D;
+
+    constexpr int TIMESTEPS = 5;
+}
+
+int main() {
+    Tensor3D X;
+    Matrix Y;
+    for (int k = 0; k < 90; k++) {
+        Matrix window;
+        for (int t = 0; t < TIMESTEPS; t++) {
+            window.push_back({std::sin(0.3 * (k + t)), std::cos(0.3 * (k + t))});
+        }
+        X.push_back(window);
+        Y.push_back({std::sin(0.3 * (k + TIMESTEPS))});
+    }
+
+    WalkForward::Config config;
+    config.window = WalkForward::Window::Rolling;
+    config.train_size = 48;
+    config.test_size = 12;
+    config.gap = TIMESTEPS - 1;
+    config.layer_dims = {8, 8, 4, 1};
+    config.hidden_units = 8;
+    config.batch_size = 16;
+    config.learning_rate = 1e-2;
+    config.epochs = 3;
+
+    const WalkForward::Summary summary = WalkForward::run(X, Y, config);
+    CHECK(summary.folds.size() == 3); //Test windows 52-64, 64-76 and 76-88
+    CHECK(summary.completed == summary.folds.size());
+
+    double pooled = 0.0;
+    size_t n = 0;
+    for (const WalkForward::FoldResult& result : summary.folds) {
+        CHECK(result.completed);
+        CHECK(result.error.empty());
+        CHECK(result.predictions.size() == config.test_size);
+        CHECK(std::isfinite(result.train_loss));
+
+        //The metrics are those of the stored predictions against the fold's targets
+        double squared = 0.0, absolute = 0.0;
+        for (size_t i = 0; i < result.predictions.size(); i++) {
+            const double error = result.predictions[i] - Y[result.fold.test_begin + i][0];
+            squared += error * error;
+            absolute += std::abs(error);
+        }
+        CHECK(std::abs(result.mse - squared / config.test_size) < 1e-12);
+        CHECK(std::abs(result.mae - absolute / config.test_size) < 1e-12);
+        CHECK(result.mae * result.mae <= result.mse + 1e-12);
+        pooled += squared;
+        n += result.predictions.size();
+    }
+    CHECK(std::abs(summary.pooled_mse - pooled / n) < 1e-12);
+    CHECK(std::isfinite(summary.mean_mse) && std::isfinite(summary.mean_mae));
+
+    return check::result();
+}